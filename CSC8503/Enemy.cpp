@@ -1,7 +1,6 @@
 #include "Enemy.h"
 #include "Player.h"
 #include "logging/log.h"
-#include "physics/PhysicsObject.h"
 
 #include "Debug.h"
 
@@ -12,8 +11,7 @@
 #include "ai/state_machine/StateTransition.h"
 
 namespace NCL::CSC8503 {
-Enemy::Enemy(const GameWorld &w, int id, const std::string name,
-             float viewDistance)
+Enemy::Enemy(GameWorld &w, int id, const std::string name, float viewDistance)
     : GameObject(name), world(w), rootBehaviour(name),
       viewDistance(viewDistance) {
   GetTags().set(Tag::Enemy);
@@ -23,30 +21,7 @@ Enemy::Enemy(const GameWorld &w, int id, const std::string name,
 }
 
 void Enemy::InitializeBehaviours() {
-  auto canSeePlayer = [this]() {
-    float distance = std::numeric_limits<float>::infinity();
-    std::optional<const NCL::CSC8503::Player *> goal = std::nullopt;
-
-    Vector3 pos = GetTransform().GetPosition();
-
-    for (auto &player : world.GetPlayerRange()) {
-      Vector3 pPos = player.second->GetTransform().GetPosition();
-
-      Vector3 dir = Vector::Normalise(pPos - pos);
-
-      Ray ray(pos, dir);
-      RayCollision hit;
-      if (world.Raycast(ray, hit, std::numeric_limits<float>::max(), this)) {
-        if (hit.node == player.second && distance > hit.rayDistance) {
-          distance = hit.rayDistance;
-          goal = reinterpret_cast<const NCL::CSC8503::Player *const>(
-              player.second);
-        }
-      }
-    }
-
-    return goal;
-  };
+  auto canSeePlayer = [this]() { return CanSeePlayer(); };
 
   enum class WaypointState { Ongoing, Finished, Failed };
 
@@ -71,15 +46,15 @@ void Enemy::InitializeBehaviours() {
         if (seenPlayer.has_value()) {
           timeSinceSeenPlayer = 0.0f;
           Vector3 currentPlayerPos =
-              seenPlayer.value()->GetTransform().GetPosition();
+              world.GetPhysicsState(*seenPlayer.value()).position;
 
           Vector3 to = currentPlayerPos - lastSeenPlayerPos;
 
           if (!navRequest.has_value() && Vector::Dot(to, to) > 5.f) {
             navRequest = world.pathfind().requestPath(
-                GetTransform().GetPosition(), lastSeenPlayerPos, true);
+                world.GetPhysicsState(*this).position, lastSeenPlayerPos, true);
             lastSeenPlayerPos =
-                seenPlayer.value()->GetTransform().GetPosition();
+                world.GetPhysicsState(*seenPlayer.value()).position;
           }
         }
       });
@@ -101,8 +76,8 @@ void Enemy::InitializeBehaviours() {
             currentPatrolPoint = 0;
           }
           navRequest = world.pathfind().requestPath(
-              GetTransform().GetPosition(), patrolPoints[currentPatrolPoint],
-              true);
+              world.GetPhysicsState(*this).position,
+              patrolPoints[currentPatrolPoint], true);
         }
       });
 
@@ -111,10 +86,11 @@ void Enemy::InitializeBehaviours() {
         auto playerOpt = canSeePlayer();
         if (playerOpt.has_value()) {
           timeSinceSeenPlayer = 0.0f;
-          lastSeenPlayerPos = playerOpt.value()->GetTransform().GetPosition();
+          lastSeenPlayerPos =
+              world.GetPhysicsState(*playerOpt.value()).position;
 
           navRequest = world.pathfind().requestPath(
-              GetTransform().GetPosition(), lastSeenPlayerPos, true);
+              world.GetPhysicsState(*this).position, lastSeenPlayerPos, true);
           return true;
         }
         return false;
@@ -144,11 +120,47 @@ void Enemy::InitializeBehaviours() {
 }
 
 void Enemy::Update(float dt) {
+  seenPlayer.reset();
   timeSinceSeenPlayer += dt;
   rootBehaviour.Execute(dt);
   CheckNavRequest();
 }
 
+/*
+A ray to every player, all cast together, seeing which ones make it there
+without hitting anything else first
+*/
+std::optional<const NCL::CSC8503::Player *> Enemy::CanSeePlayer() {
+  if (seenPlayer.has_value()) {
+    return *seenPlayer;
+  }
+
+  Vector3 pos = world.GetPhysicsState(*this).position;
+  sightQueries.clear();
+  for (auto &player : world.GetPlayerRange()) {
+    Vector3 pPos = world.GetPhysicsState(*player.second).position;
+    Vector3 dir = Vector::Normalise(pPos - pos);
+    sightQueries.push_back({Ray(pos, dir), std::nullopt, this});
+  }
+  sightHits.resize(sightQueries.size());
+  world.RaycastBatch(sightQueries, sightHits);
+
+  float distance = std::numeric_limits<float>::infinity();
+  std::optional<const NCL::CSC8503::Player *> goal = std::nullopt;
+  int i = 0;
+  for (auto &player : world.GetPlayerRange()) {
+    const RayCollision &hit = sightHits[i++];
+    if (hit.node == player.second && distance > hit.rayDistance) {
+      distance = hit.rayDistance;
+      goal = reinterpret_cast<const NCL::CSC8503::Player *const>(
+          player.second);
+    }
+  }
+
+  seenPlayer = goal;
+  return goal;
+}
+
 void Enemy::CheckNavRequest() {
   if (navRequest.has_value() && navRequest.value().valid()) {
     auto res = navRequest.value().get();
@@ -168,14 +180,14 @@ void Enemy::CheckNavRequest() {
 }
 
 bool Enemy::NavigateTo(float dt, const Vector3 &targetPos) {
-  Vector3 currentPos = GetTransform().GetPosition();
+  Vector3 currentPos = world.GetPhysicsState(*this).position;
 
   Vector3 toTarget = targetPos - currentPos;
   toTarget.y = 0.f;
 
   Vector3 moveDir = Vector::Normalise(toTarget);
 
-  GetPhysicsObject()->AddForce(moveDir * speed * dt);
+  world.ChangePhysics(*this, PhysicsCommands::AddForce{moveDir * speed * dt});
 
   constexpr float waypointThreshold = 2.0f;
   return Vector::Dot(toTarget, toTarget) < waypointThreshold;
@@ -185,7 +197,7 @@ void Enemy::UpdateToClosestPatrolPoint() {
   if (patrolPoints.empty()) {
     return;
   }
-  Vector3 currentPos = GetTransform().GetPosition();
+  Vector3 currentPos = world.GetPhysicsState(*this).position;
   size_t closestPoint = currentPatrolPoint;
   float closestDist = std::numeric_limits<float>::infinity();
   for (size_t i = 0; i < patrolPoints.size(); ++i) {
@@ -8,9 +8,11 @@
 #include <optional>
 
 namespace NCL::CSC8503 {
+class Player;
+
 class Enemy : public GameObject {
 public:
-  Enemy(const GameWorld &world, int id, const std::string name = "Enemy",
+  Enemy(GameWorld &world, int id, const std::string name = "Enemy",
         float viewDist = 100);
 
   void Update(float dt) override;
@@ -28,7 +30,9 @@ protected:
 
   void UpdateToClosestPatrolPoint();
 
-  const GameWorld &world;
+  std::optional<const NCL::CSC8503::Player *> CanSeePlayer();
+
+  GameWorld &world;
   std::optional<PathfindingService::Request> navRequest;
 
   struct Nav {
@@ -50,6 +54,12 @@ protected:
   float timeSinceSeenPlayer = 0.0f;
   Vector3 lastSeenPlayerPos;
 
+  // Both the states and their transitions want to know, so it's only
+  // worked out once per update
+  std::optional<std::optional<const NCL::CSC8503::Player *>> seenPlayer;
+  std::vector<GameWorld::RayQuery> sightQueries;
+  std::vector<RayCollision> sightHits;
+
   std::vector<Vector3> patrolPoints;
   size_t currentPatrolPoint = 0;
 };
@@ -5,6 +5,7 @@
 #include "MshLoader.h"
 #include "RenderObject.h"
 #include "TextureLoader.h"
+#include "physics/PhysicsSnapshot.h"
 
 #include "Debug.h"
 
@@ -194,16 +195,36 @@ void GameTechRenderer::BuildObjectLists() {
 
   Vector3 camPos = cam->GetPosition();
 
-  gameWorld.OperateOnContents([&](GameObject *o) {
-    if (o->IsActive()) {
-      const RenderObject *g = o->GetRenderObject();
+  // Physics bodies are drawn from the snapshots physics publishes, blended
+  // between its last two steps. While it's stepping on its own thread, the
+  // transforms it's moving can't be read from here anyway
+  const PhysicsSnapshot *snapshot = nullptr;
+  float alpha = 1.0f;
+  if (auto snapshots = gameWorld.GetPhysicsSnapshots()) {
+    snapshot = &snapshots->Read();
+    alpha = snapshot->GetAlpha();
+  }
+
+  gameWorld.OperateOnContents([&](GameObject *go) {
+    if (go->IsActive()) {
+      const RenderObject *g = go->GetRenderObject();
       if (g) {
         GameTechMaterial mat = g->GetMaterial();
 
         ObjectSortState o;
         o.object = g;
-        o.distanceFromCamera =
-            Vector::LengthSquared(camPos - g->GetTransform().GetPosition());
+
+        const PhysicsSnapshot::Body *body =
+            snapshot ? snapshot->Find(*go, go->GetWorldID()) : nullptr;
+        Vector3 position;
+        if (body) {
+          o.modelMatrix = PhysicsSnapshot::ModelMatrix(*body, alpha);
+          position = body->GetPosition(alpha);
+        } else {
+          o.modelMatrix = g->GetTransform().GetMatrix();
+          position = g->GetTransform().GetPosition();
+        }
+        o.distanceFromCamera = Vector::LengthSquared(camPos - position);
 
         if (mat.type == MaterialType::Opaque) {
           opaqueObjects.emplace_back(o);
@@ -247,7 +268,7 @@ void GameTechRenderer::RenderShadowMapPass(std::vector<ObjectSortState> &list) {
   for (const auto &i : list) {
     const RenderObject *o = i.object;
 
-    Matrix4 modelMatrix = o->GetTransform().GetMatrix();
+    const Matrix4 &modelMatrix = i.modelMatrix;
     Matrix4 mvpMatrix = mvMatrix * modelMatrix;
     glUniformMatrix4fv(mvpLocation, 1, false, (float *)&mvpMatrix);
     BindMesh((OGLMesh &)*o->GetMesh());
@@ -366,7 +387,7 @@ void GameTechRenderer::RenderOpaquePass(std::vector<ObjectSortState> &list) {
     if (diffuseTex) {
       BindTextureToShader(*diffuseTex, "mainTex", 0);
     }
-    Matrix4 modelMatrix = o->GetTransform().GetMatrix();
+    const Matrix4 &modelMatrix = i.modelMatrix;
     glUniformMatrix4fv(modelLocation, 1, false, (float *)&modelMatrix);
 
     Matrix4 fullShadowMat = shadowMatrix * modelMatrix;
@@ -453,7 +474,7 @@ void GameTechRenderer::RenderTransparentPass(
     if (diffuseTex) {
       BindTextureToShader(*diffuseTex, "mainTex", 0);
     }
-    Matrix4 modelMatrix = o->GetTransform().GetMatrix();
+    const Matrix4 &modelMatrix = i.modelMatrix;
     glUniformMatrix4fv(modelLocation, 1, false, (float *)&modelMatrix);
 
     Matrix4 fullShadowMat = shadowMatrix * modelMatrix;
@@ -28,6 +28,8 @@ protected:
   struct ObjectSortState {
     const RenderObject *object;
     float distanceFromCamera;
+    // Worked out once per frame, from the physics snapshot if there is one
+    Matrix4 modelMatrix;
   };
 
   void RenderLines();
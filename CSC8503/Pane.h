@@ -21,26 +21,31 @@ public:
   }
 
   void Update(float dt) override {
-    if (GetTransform().GetPosition().y < -50.0f) {
-      Reset();
+    NCL::CSC8503::PhysicsState state = world->GetPhysicsState(*this);
+    if (state.position.y < -50.0f) {
+      Respawn();
     }
 
-    const NCL::CSC8503::OffsetTiedConstraint *constraints[4] = {
-        ropes.fl.constraint, ropes.fr.constraint, ropes.bl.constraint,
-        ropes.br.constraint};
+    const Rope *allRopes[4] = {&ropes.fl, &ropes.fr, &ropes.bl, &ropes.br};
+    const Corner corners[4] = {Corner::FrontLeft, Corner::FrontRight,
+                               Corner::BackLeft, Corner::BackRight};
 
     const NCL::Maths::Vector4 colors[4] = {
         NCL::Maths::Vector4(1, 0, 0, 1), NCL::Maths::Vector4(0, 1, 0, 1),
         NCL::Maths::Vector4(0, 0, 1, 1), NCL::Maths::Vector4(1, 1, 0, 1)};
 
     for (int i = 0; i < 4; ++i) {
-      const NCL::CSC8503::OffsetTiedConstraint *constraint = constraints[i];
-      if (constraint && constraint->IsActive()) {
+      const Rope &rope = *allRopes[i];
+      if (rope.attached) {
         Vector4 color = colors[i];
 
-        float constraintDistance = constraints[i]->GetDistance();
-        Vector3 aPos = constraints[i]->GetAAttachPos();
-        Vector3 bPos = constraints[i]->GetBAttachPos();
+        NCL::CSC8503::PhysicsState nodeState =
+            world->GetPhysicsState(*rope.node);
+        float constraintDistance = rope.distance;
+        Vector3 aPos =
+            state.position + state.orientation * GetCornerOffset(corners[i]);
+        Vector3 bPos = nodeState.position +
+                       nodeState.orientation * rope.nodeOffset;
 
         Vector3 dir = bPos - aPos;
         float distSq = NCL::Maths::Vector::Dot(dir, dir);
@@ -56,8 +61,9 @@ public:
   }
 
   void OnCollisionBegin(NCL::CSC8503::GameObject *otherObject) override {
-    Vector3 relativeVel = otherObject->GetPhysicsObject()->GetLinearVelocity() -
-                          GetPhysicsObject()->GetLinearVelocity();
+    Vector3 relativeVel =
+        world->GetPhysicsState(*otherObject).linearVelocity -
+        world->GetPhysicsState(*this).linearVelocity;
 
     constexpr float collisionThreshold = 25.0f;
 
@@ -65,10 +71,12 @@ public:
 
     if (otherObject->GetPhysicsObject()->GetInverseMass() == 0.f &&
         mag > collisionThreshold) {
-      Reset();
+      Respawn();
     }
   }
 
+  /// @brief Only ever called through PhysicsCommands::Reset, so it can
+  /// touch the ropes' constraints
   void Reset() override {
     GameObject::Reset();
     ropes.fl.constraint->deactivate();
@@ -83,7 +91,9 @@ public:
   }
 
   void AttachCorner(Corner currentCorner, NCL::Camera &cam) {
-    GetPhysicsObject()->SetAxisLocks(0);
+    world->ChangePhysics(*this, Run([](GameObject &o) {
+                           o.GetPhysicsObject()->SetAxisLocks(0);
+                         }));
 
     std::vector<NCL::CSC8503::GameObject *> ignores;
     for (auto &p : world->GetPlayerRange()) {
@@ -101,45 +111,55 @@ public:
     if (world->Raycast(ray, closestCollision, std::nullopt, ignores)) {
       auto node =
           static_cast<NCL::CSC8503::GameObject *>(closestCollision.node);
-      auto offset =
-          closestCollision.collidedAt - node->GetTransform().GetPosition();
+      auto offset = closestCollision.collidedAt -
+                    world->GetPhysicsState(*node).position;
 
-      NCL::CSC8503::OffsetTiedConstraint *toActivate =
-          GetRope(currentCorner).constraint;
+      NCL::CSC8503::PhysicsState state = world->GetPhysicsState(*this);
       NCL::Maths::Vector3 pos =
-          GetTransform().GetPosition() +
-          (GetTransform().GetOrientation() * GetCornerOffset(currentCorner));
+          state.position +
+          (state.orientation * GetCornerOffset(currentCorner));
 
       auto rel = pos - closestCollision.collidedAt;
       auto dist = NCL::Maths::Vector::Length(rel);
 
-      toActivate->SetObjB({node, offset});
-      toActivate->SetDistance(dist);
-      toActivate->activate();
+      Rope &rope = GetRope(currentCorner);
+      rope.attached = true;
+      rope.node = node;
+      rope.nodeOffset = offset;
+      rope.distance = dist;
+
+      NCL::CSC8503::OffsetTiedConstraint *toActivate = rope.constraint;
+      world->ChangePhysics(*this, Run([=](GameObject &) {
+                             toActivate->SetObjB({node, offset});
+                             toActivate->SetDistance(dist);
+                             toActivate->activate();
+                           }));
     }
   }
 
   void ExtendCorner(Corner currentCorner, float dt) {
-    NCL::CSC8503::OffsetTiedConstraint *toActivate =
-        GetRope(currentCorner).constraint;
+    Rope &rope = GetRope(currentCorner);
 
     constexpr float extendSpeed = 5.0f;
-    float newDist = toActivate->GetDistance() + extendSpeed * dt;
-    toActivate->SetDistance(newDist);
+    rope.distance += extendSpeed * dt;
+    SetRopeDistance(rope);
   }
 
   void RetractCorner(Corner currentCorner, float dt) {
-    NCL::CSC8503::OffsetTiedConstraint *toDeactivate =
-        GetRope(currentCorner).constraint;
+    Rope &rope = GetRope(currentCorner);
     constexpr float retractSpeed = 5.0f;
-    float newDist = toDeactivate->GetDistance() - retractSpeed * dt;
+    rope.distance -= retractSpeed * dt;
 
-    toDeactivate->SetDistance(newDist);
+    SetRopeDistance(rope);
   }
 
   void DetachCorner(Corner currentCorner) {
-    Rope rope = GetRope(currentCorner);
-    rope.constraint->deactivate();
+    Rope &rope = GetRope(currentCorner);
+    rope.attached = false;
+    NCL::CSC8503::OffsetTiedConstraint *toDeactivate = rope.constraint;
+    world->ChangePhysics(*this, Run([toDeactivate](GameObject &) {
+                           toDeactivate->deactivate();
+                         }));
   }
 
   void SetupConstraints(NCL::CSC8503::GameWorld &world) {
@@ -176,8 +196,17 @@ protected:
   NCL::CSC8503::GameWorld *world;
   GameObject *player;
 
+  /*
+  The constraints belong to physics, which could be part way through a step
+  with them, so they're only changed through commands. What they were last
+  told is kept here too, for drawing the ropes.
+  */
   struct Rope {
     NCL::CSC8503::OffsetTiedConstraint *constraint = nullptr;
+    bool attached = false;
+    GameObject *node = nullptr;
+    NCL::Maths::Vector3 nodeOffset;
+    float distance = 0.0f;
   };
 
   struct Ropes {
@@ -189,7 +218,25 @@ protected:
 
   Ropes ropes;
 
-  Rope GetRope(Corner corner) {
+  using Run = NCL::CSC8503::PhysicsCommands::Run;
+
+  void Respawn() {
+    ropes.fl.attached = false;
+    ropes.fr.attached = false;
+    ropes.bl.attached = false;
+    ropes.br.attached = false;
+    world->ChangePhysics(*this, NCL::CSC8503::PhysicsCommands::Reset{});
+  }
+
+  void SetRopeDistance(const Rope &rope) {
+    NCL::CSC8503::OffsetTiedConstraint *constraint = rope.constraint;
+    float distance = rope.distance;
+    world->ChangePhysics(*this, Run([constraint, distance](GameObject &) {
+                           constraint->SetDistance(distance);
+                         }));
+  }
+
+  Rope &GetRope(Corner corner) {
     switch (corner) {
     case Corner::FrontLeft:
       return ropes.fl;
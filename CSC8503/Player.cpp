@@ -1,7 +1,6 @@
 #include "Player.h"
 
 #include "Bitflag.h"
-#include "physics/PhysicsObject.h"
 
 namespace {
 constexpr float ORIENTATION_DELTA_SCALE =
@@ -11,19 +10,17 @@ constexpr float ORIENTATION_DELTA_SCALE =
 namespace NCL::CSC8503 {
 
 void Player::Update(float dt) {
-  if (GetTransform().GetPosition().y < -50.0f) {
-    Reset();
+  auto pos = world->GetPhysicsState(*this).position;
+  if (pos.y < -50.0f) {
+    world->ChangePhysics(*this, PhysicsCommands::Reset{});
   }
 
-  auto pos = GetTransform().GetPosition();
   camera.SetPosition(pos + Vector3(0, 1.25, 0));
   auto rot = Quaternion::EulerAnglesToQuaternion(0, camera.GetYaw(), 0);
-  GetTransform().SetOrientation(rot);
+  world->ChangePhysics(*this, PhysicsCommands::SetOrientation{rot});
 }
 
 void Player::ClientInput(float dt) {
-  auto &phys = *GetPhysicsObject();
-
   float pitch = camera.GetPitch();
   float yaw = camera.GetYaw();
 
@@ -59,24 +56,21 @@ void Player::ClientInput(float dt) {
   constexpr float baseSpeed = 1000.f;
   float speed = baseSpeed * dt;
 
-  phys.AddForce(forwardV * forward * speed);
-  phys.AddForce(rightV * sidestep * speed);
+  world->ChangePhysics(*this,
+                       PhysicsCommands::AddForce{forwardV * forward * speed});
+  world->ChangePhysics(*this,
+                       PhysicsCommands::AddForce{rightV * sidestep * speed});
 
   ClientPacket input = CreateInputPacket();
   Input(dt, input, true);
 }
 
 void Player::Input(float dt, ClientPacket input, bool skipPosRot) {
-  auto &phys = *GetPhysicsObject();
-
   Bitflag<Actions> flags(input.actions);
 
   if (!skipPosRot) {
-    auto pos = GetTransform().GetPosition();
-    pos.x = input.pos[0];
-    pos.y = input.pos[1];
-    pos.z = input.pos[2];
-    GetTransform().SetPosition(pos);
+    Vector3 pos(input.pos[0], input.pos[1], input.pos[2]);
+    world->ChangePhysics(*this, PhysicsCommands::SetPosition{pos});
 
     float xRot = static_cast<float>(input.rot[0]) / ORIENTATION_DELTA_SCALE;
     float yRot = static_cast<float>(input.rot[1]) / ORIENTATION_DELTA_SCALE;
@@ -87,7 +81,8 @@ void Player::Input(float dt, ClientPacket input, bool skipPosRot) {
 
   constexpr Vector3 UP{0, 1, 0};
   if (flags.has(Actions::Jump) && world->IsOnGround(this)) {
-    phys.ApplyLinearImpulse(UP * 50.0f);
+    world->ChangePhysics(*this,
+                         PhysicsCommands::ApplyLinearImpulse{UP * 50.0f});
   }
 
   if (pane) {
@@ -159,7 +154,7 @@ void Player::Input(float dt, ClientPacket input, bool skipPosRot) {
 
 void Player::OnCollisionBegin(GameObject *otherObject) {
   if (otherObject->GetTags().has(Tag::Enemy)) {
-    Reset();
+    world->ChangePhysics(*this, PhysicsCommands::Reset{});
   }
 }
 
@@ -221,7 +216,7 @@ ClientPacket Player::CreateInputPacket() {
   p.rot[0] = static_cast<int16_t>(camera.GetPitch() * ORIENTATION_DELTA_SCALE);
   p.rot[1] = static_cast<int16_t>(camera.GetYaw() * ORIENTATION_DELTA_SCALE);
 
-  auto pos = GetTransform().GetPosition();
+  auto pos = world->GetPhysicsState(*this).position;
 
   p.pos[0] = pos.x;
   p.pos[1] = pos.y;
@@ -40,6 +40,9 @@ TutorialGame::TutorialGame(GameWorld &inWorld,
   useGravity = true;
   freeCursor = false;
 
+  // The bridge and the pane's ropes stay taut with a pass per substep
+  physics.SetConstraintSolver(PhysicsSystem::ConstraintSolver::XPBD);
+
   world.SetSunPosition({-200.0f, 60.0f, -200.0f});
   world.SetSunColour({0.8f, 0.8f, 0.5f});
 
@@ -109,13 +112,32 @@ void TutorialGame::UpdateGame(float dt) {
 void TutorialGame::DebugUi() {
   if (!showUi)
     return;
+  // Threaded physics changes its settings and finishes its profiler frames
+  // with the world locked
+  auto lock = world.LockWorld();
   {
     auto frame = NCL::gui::Frame("Tutorial Game Debug");
     if (ImGui::Checkbox("Use Gravity", &useGravity))
       physics.UseGravity(useGravity);
 
     if (useGravity) {
-      ImGui::InputFloat3("Gravity", &physics.GetGravity().x);
+      Vector3 gravity = physics.GetGravity();
+      if (ImGui::InputFloat3("Gravity", &gravity.x)) {
+        physics.SetGravity(gravity);
+      }
+    }
+
+    using ConstraintSolver = PhysicsSystem::ConstraintSolver;
+    bool xpbd = physics.GetConstraintSolver() == ConstraintSolver::XPBD;
+    if (ImGui::Checkbox("XPBD Constraints", &xpbd)) {
+      physics.SetConstraintSolver(xpbd ? ConstraintSolver::XPBD
+                                       : ConstraintSolver::Impulse);
+    }
+    if (xpbd) {
+      int substeps = physics.GetConstraintSubsteps();
+      if (ImGui::SliderInt("Constraint Substeps", &substeps, 1, 32)) {
+        physics.SetConstraintSubsteps(substeps);
+      }
     }
   }
 
@@ -127,6 +149,41 @@ void TutorialGame::DebugUi() {
       frame.text("Camera Position: (%.2f, %.2f, %.2f)", pos.x, pos.y, pos.z);
     }
   }
+
+  PhysicsProfilerUi();
+}
+
+void TutorialGame::PhysicsProfilerUi() {
+  auto frame = NCL::gui::Frame("Physics Profiler");
+  const PhysicsProfiler &profiler = physics.GetProfiler();
+  const PhysicsProfiler::Frame &last = profiler.GetLastFrame();
+  PhysicsProfiler::Frame average = profiler.GetAverage();
+
+  const auto &history = profiler.GetTotalHistory();
+  ImGui::PlotLines("Step (ms)", history.data(), (int)history.size(),
+                   (int)profiler.GetHistoryOffset(), nullptr, 0.0f, FLT_MAX,
+                   ImVec2(0, 60));
+
+  frame.text("Total: %.3f ms (avg %.3f ms)", last.totalMs, average.totalMs);
+  for (size_t i = 0; i < PhysicsProfiler::PhaseCount; ++i) {
+    auto phase = (PhysicsProfiler::Phase)i;
+    frame.text("%-20s %7.3f ms (avg %.3f)", PhysicsProfiler::PhaseName(phase),
+               last.phaseMs[i], average.phaseMs[i]);
+  }
+
+  ImGui::Separator();
+  frame.text("Substeps: %d", last.substeps);
+  frame.text("Awake bodies: %d", last.awakeBodies);
+  frame.text("Broadphase pairs: %d", last.broadPhasePairs);
+  frame.text("Contact pairs: %d", last.contactPairs);
+  frame.text("Contact points: %d", last.contactPoints);
+
+  ImGui::Separator();
+  frame.text("Step rate: %d hz", physics.GetStepSettings().stepHz);
+  frame.text("Step limit: %s",
+             PhysicsProfiler::StepLimitName(last.stepLimit));
+  frame.text("Backlog: %.2f ms (avg %.2f)", last.backlogMs, average.backlogMs);
+  frame.text("Dropped: %.2f ms (avg %.2f)", last.droppedMs, average.droppedMs);
 }
 
 void TutorialGame::Clear() {
@@ -140,6 +197,8 @@ void TutorialGame::Clear() {
 
 void TutorialGame::InitLvlOne() {
   Clear();
+  // So threaded physics only picks the level up once it's all there
+  auto lock = world.LockWorld();
 
   pane = AddPaneToWorld(Vector3(10, 5, 0), Vector2(4, 2), .5f);
   pane->SetupConstraints(world);
@@ -184,12 +243,15 @@ void TutorialGame::InitLvlOne() {
   pendulum->SetName("Pendulum");
   pendulum->GetPhysicsObject()->GetMaterial().SetLinearDamping(0);
   pendulum->GetPhysicsObject()->SetAxisLocks(PhysicsObject::AxisLock::LinearX);
+  // Fast enough at the bottom of its swing to go straight through things
+  pendulum->GetPhysicsObject()->SetContinuousCollision(true);
   pendulum->Sync(300);
   world.AddConstraint(new TiedConstraint(pendulumAttachment, pendulum, 44));
 }
 
 void TutorialGame::InitLvlTwo() {
   Clear();
+  auto lock = world.LockWorld();
 
   AddFloorToWorld(Vector3(0, -5, 0));
   AddFloorToWorld(Vector3(0, 10, 0));
@@ -252,6 +314,7 @@ GameObject *TutorialGame::AddFloorToWorld(const Vector3 &position) {
       new PhysicsObject(floor->GetTransform(), floor->GetBoundingVolume()));
 
   floor->GetPhysicsObject()->SetInverseMass(0);
+  floor->GetPhysicsObject()->SetBodyType(PhysicsObject::BodyType::Static);
   floor->GetPhysicsObject()->InitCubeInertia();
 
   world.AddGameObject(floor);
@@ -283,6 +346,9 @@ GameObject *TutorialGame::AddSphereToWorld(const Vector3 &position,
       new PhysicsObject(sphere->GetTransform(), sphere->GetBoundingVolume()));
 
   sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+  if (inverseMass == 0.0f) {
+    sphere->GetPhysicsObject()->SetBodyType(PhysicsObject::BodyType::Static);
+  }
   sphere->GetPhysicsObject()->InitSphereInertia();
 
   sphere->SetCurrentTransformAsReset();
@@ -307,6 +373,9 @@ GameObject *TutorialGame::AddCubeToWorld(const Vector3 &position,
       new PhysicsObject(cube->GetTransform(), cube->GetBoundingVolume()));
 
   cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+  if (inverseMass == 0.0f) {
+    cube->GetPhysicsObject()->SetBodyType(PhysicsObject::BodyType::Static);
+  }
   cube->GetPhysicsObject()->InitCubeInertia();
 
   cube->SetCurrentTransformAsReset();
@@ -332,6 +401,9 @@ GameObject *TutorialGame::AddOBBToWorld(const Vector3 &position,
   obb->SetPhysicsObject(
       new PhysicsObject(obb->GetTransform(), obb->GetBoundingVolume()));
   obb->GetPhysicsObject()->SetInverseMass(inverseMass);
+  if (inverseMass == 0.0f) {
+    obb->GetPhysicsObject()->SetBodyType(PhysicsObject::BodyType::Static);
+  }
   obb->GetPhysicsObject()->InitCubeInertia();
   world.AddGameObject(obb);
   obb->SetCurrentTransformAsReset();
@@ -354,6 +426,9 @@ GameObject *TutorialGame::AddCapsuleToWorld(const Vector3 &position,
   capsule->SetPhysicsObject(
       new PhysicsObject(capsule->GetTransform(), capsule->GetBoundingVolume()));
   capsule->GetPhysicsObject()->SetInverseMass(inverseMass);
+  if (inverseMass == 0.0f) {
+    capsule->GetPhysicsObject()->SetBodyType(PhysicsObject::BodyType::Static);
+  }
   capsule->GetPhysicsObject()->InitSphereInertia();
   world.AddGameObject(capsule);
 
@@ -507,6 +582,7 @@ GameObject *TutorialGame::AddLevelEndToWorld(const Vector3 &position,
   levelEnd->SetPhysicsObject(new PhysicsObject(levelEnd->GetTransform(),
                                                levelEnd->GetBoundingVolume()));
   levelEnd->GetPhysicsObject()->SetInverseMass(0.0f);
+  levelEnd->GetPhysicsObject()->SetBodyType(PhysicsObject::BodyType::Static);
   world.AddGameObject(levelEnd);
 
   return levelEnd;
@@ -631,16 +707,14 @@ void TutorialGame::CreateAABBGrid(int numRows, int numCols, float rowSpacing,
   }
 }
 
-void TutorialGame::BridgeConstraintTest() {
+void TutorialGame::BridgeConstraintTest(int numLinks,
+                                        const Vector3 &startPos) {
   const Vector3 cubeDims = Vector3(8, 8, 8);
 
   constexpr float invCubeMass = 5.0f;
-  constexpr int numLinks = 10;
   constexpr float maxDistance = 30.f;
   constexpr float cubeDistance = 20.f;
 
-  const Vector3 startPos(300, 50, 300);
-
   auto start = AddCubeToWorld(startPos, cubeDims, 0.0f);
   auto end = AddCubeToWorld(
       startPos + Vector3((numLinks + 2) * cubeDistance, 0, 0), cubeDims, 0.0f);
@@ -56,9 +56,12 @@ protected:
   void CreateAABBGrid(int numRows, int numCols, float rowSpacing,
                       float colSpacing, const NCL::Maths::Vector3 &cubeDims);
 
-  void BridgeConstraintTest();
+  void BridgeConstraintTest(
+      int numLinks = 10,
+      const NCL::Maths::Vector3 &startPos = NCL::Maths::Vector3(300, 50, 300));
 
   void DebugUi();
+  void PhysicsProfilerUi();
 
   GameObject *AddFloorToWorld(const NCL::Maths::Vector3 &position);
   GameObject *AddSphereToWorld(const NCL::Maths::Vector3 &position,
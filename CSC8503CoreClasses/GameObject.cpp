@@ -38,6 +38,11 @@ void GameObject::UpdateBroadphaseAABB() {
   if (!boundingVolume) {
     return;
   }
+  // Most of the level never moves, so doesn't need redoing
+  if (broadphaseGeneration == transform.GetGeneration()) {
+    return;
+  }
+  broadphaseGeneration = transform.GetGeneration();
   switch (boundingVolume->type) {
   case VolumeType::AABB: {
     broadphaseAABB = ((AABBVolume &)*boundingVolume).GetHalfDimensions();
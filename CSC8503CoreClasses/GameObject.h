@@ -27,7 +27,10 @@ public:
   GameObject(const std::string &name = "");
   ~GameObject();
 
-  void SetBoundingVolume(CollisionVolume *vol) { boundingVolume = vol; }
+  void SetBoundingVolume(CollisionVolume *vol) {
+    boundingVolume = vol;
+    broadphaseGeneration.reset();
+  }
 
   bool IsActive() const { return !tags.has(Tag::Inactive); }
 
@@ -64,6 +67,8 @@ public:
     // std::cout << "OnCollisionBegin event occured!\n";
   }
 
+  virtual void OnCollisionStay(GameObject *otherObject) {}
+
   virtual void OnCollisionEnd(GameObject *otherObject) {
     // std::cout << "OnCollisionEnd event occured!\n";
   }
@@ -94,5 +99,7 @@ protected:
   std::string name;
 
   Vector3 broadphaseAABB;
+  // Transform generation broadphaseAABB was last built for
+  std::optional<uint32_t> broadphaseGeneration;
 };
 } // namespace NCL::CSC8503
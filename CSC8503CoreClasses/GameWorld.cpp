@@ -2,13 +2,20 @@
 #include "Camera.h"
 #include "GameObject.h"
 #include "GamePlayer.h"
+#include "collisions/AABBVolume.h"
+#include "collisions/CapsuleVolume.h"
 #include "collisions/CollisionDetection.h"
+#include "collisions/SphereVolume.h"
 #include "constraints/Constraint.h"
+#include "physics/PhysicsObject.h"
 
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
 #include <random>
 
 #include "collisions/CollisionDetection.h"
-#include "collisions/QuadTree.h"
 #include "collisions/Ray.h"
 
 using namespace NCL;
@@ -21,50 +28,118 @@ GameWorld::GameWorld() {
   worldStateCounter = 0;
 }
 
-GameWorld::~GameWorld() {}
+GameWorld::~GameWorld() {
+  // Physics is long gone by now, so nothing can still be using these
+  for (GameObject *o : pendingObjectDeletes) {
+    delete o;
+  }
+  for (Constraint *c : pendingConstraintDeletes) {
+    delete c;
+  }
+  for (GameObject *o : releasedObjects) {
+    delete o;
+  }
+  for (Constraint *c : releasedConstraints) {
+    delete c;
+  }
+}
 
 void GameWorld::Clear() {
+  auto lock = LockWorld();
+  for (GameObject *o : gameObjects) {
+    if (physicsCommands) {
+      removedObjects.push_back(o);
+    } else if (PhysicsObject *phys = o->GetPhysicsObject()) {
+      phys->LeaveStore();
+    }
+  }
   gameObjects.clear();
   constraints.clear();
   worldIDCounter = 0;
   worldStateCounter = 0;
+
+  // The state counter starting again could line up with the last sync
+  queryTree.Clear();
+  queryProxies.clear();
+  queryMovers.clear();
+  queryWorldState = -1;
 }
 
 void GameWorld::ClearAndErase() {
-  for (auto &i : gameObjects) {
-    delete i;
-  }
-  for (auto &i : constraints) {
-    delete i;
+  auto lock = LockWorld();
+  if (physicsCommands) {
+    pendingObjectDeletes.insert(pendingObjectDeletes.end(),
+                                gameObjects.begin(), gameObjects.end());
+    pendingConstraintDeletes.insert(pendingConstraintDeletes.end(),
+                                    constraints.begin(), constraints.end());
+  } else {
+    for (auto &i : gameObjects) {
+      delete i;
+    }
+    gameObjects.clear();
+    for (auto &i : constraints) {
+      delete i;
+    }
   }
   Clear();
 }
 
 void GameWorld::AddGameObject(GameObject *o) {
+  auto lock = LockWorld();
   gameObjects.emplace_back(o);
   o->SetWorldID(worldIDCounter++);
   worldStateCounter++;
 }
 
 void GameWorld::AddPlayerObject(GamePlayer *o) {
+  auto lock = LockWorld();
   players.emplace(o->GetId(), o);
   AddGameObject(o);
 }
 
+/*
+The physics system won't look at a removed object again, so it has to take
+its motion back out of the body store. A threaded step could be using it
+right now though, so then it's left for physics to do once the step's done,
+and the object isn't deleted until it has.
+*/
 void GameWorld::RemoveGameObject(GameObject *o, bool andDelete) {
+  auto lock = LockWorld();
   gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o),
                     gameObjects.end());
-  if (andDelete) {
-    delete o;
+  if (physicsCommands) {
+    removedObjects.push_back(o);
+    if (andDelete) {
+      pendingObjectDeletes.push_back(o);
+    }
+  } else {
+    if (PhysicsObject *phys = o->GetPhysicsObject()) {
+      phys->LeaveStore();
+    }
+    if (andDelete) {
+      delete o;
+    }
   }
   worldStateCounter++;
 }
 
 void GameWorld::RemovePlayerObject(GamePlayer *o, bool andDelete) {
+  auto lock = LockWorld();
   players.erase(o->GetId());
   RemoveGameObject(o, andDelete);
 }
 
+void GameWorld::ReleaseRemoved() {
+  removedObjects.clear();
+  releasedObjects.insert(releasedObjects.end(), pendingObjectDeletes.begin(),
+                         pendingObjectDeletes.end());
+  pendingObjectDeletes.clear();
+  releasedConstraints.insert(releasedConstraints.end(),
+                             pendingConstraintDeletes.begin(),
+                             pendingConstraintDeletes.end());
+  pendingConstraintDeletes.clear();
+}
+
 void GameWorld::GetObjectIterators(GameObjectIterator &first,
                                    GameObjectIterator &last) const {
 
@@ -79,6 +154,12 @@ void GameWorld::OperateOnContents(GameObjectFunc f) {
 }
 
 void GameWorld::UpdateWorld(float dt) {
+  std::vector<GameObject *> deleteObjects;
+  std::vector<Constraint *> deleteConstraints;
+  auto lock = LockWorld();
+  std::swap(deleteObjects, releasedObjects);
+  std::swap(deleteConstraints, releasedConstraints);
+
   auto rng = std::default_random_engine{};
 
   unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
@@ -91,93 +172,451 @@ void GameWorld::UpdateWorld(float dt) {
   if (shuffleConstraints) {
     std::shuffle(constraints.begin(), constraints.end(), e);
   }
+  lock.unlock();
+
+  for (GameObject *o : deleteObjects) {
+    delete o;
+  }
+  for (Constraint *c : deleteConstraints) {
+    delete c;
+  }
 }
 
-bool GameWorld::Raycast(
-    Ray &r, RayCollision &collision, std::optional<float> maxDist,
-    const std::span<const GameObject *const> ignoreThis) const {
-  auto distanceCheck = [&](const RayCollision &c) {
-    if (maxDist.has_value()) {
-      return c.rayDistance <= maxDist.value();
-    }
-    return true;
+/*
+Objects are only added to and removed from the query tree when the world
+changes. Static bodies are taken at their word that they won't move, so only
+everything else is checked for having moved before each query, and even then
+only reinserted once it's left its fat bounds.
+
+Every query holds the world lock, so threaded physics can't move anything
+while the tree is brought up to date or searched.
+*/
+void GameWorld::UpdateQueryTree() const {
+  auto mightMove = [](const GameObject *o) {
+    auto phys = o->GetPhysicsObject();
+    return !phys || phys->GetBodyType() != PhysicsObject::BodyType::Static;
   };
 
-  Vector3 rayPos = r.GetPosition();
-  float maxDistSq = maxDist.has_value() ? maxDist.value() * maxDist.value()
-                                        : std::numeric_limits<float>::max();
+  if (queryWorldState != worldStateCounter) {
+    queryWorldState = worldStateCounter;
+    ++querySyncStamp;
 
-  for (auto &i : gameObjects) {
-    if (!i->GetBoundingVolume()) { // objects might not be collideable etc...
-      continue;
+    for (GameObject *o : gameObjects) {
+      if (!o->GetBoundingVolume()) {
+        continue;
+      }
+      o->UpdateBroadphaseAABB();
+
+      auto existing = queryProxies.find(o->GetWorldID());
+      if (existing != queryProxies.end()) {
+        // IDs restart if the world is cleared
+        if (queryTree.GetObject(existing->second.proxy) == o) {
+          existing->second.syncStamp = querySyncStamp;
+          continue;
+        }
+        queryTree.Remove(existing->second.proxy);
+      }
+
+      Vector3 halfSize;
+      o->GetBroadphaseAABB(halfSize);
+      const Transform &t = o->GetTransform();
+      int proxy =
+          queryTree.Insert(o, Bounds::FromCentre(t.GetPosition(), halfSize));
+      queryProxies[o->GetWorldID()] = {proxy, querySyncStamp,
+                                       t.GetGeneration()};
     }
 
-    for (auto &obj : ignoreThis) {
-      if (i == obj)
-        goto next;
+    for (auto it = queryProxies.begin(); it != queryProxies.end();) {
+      if (it->second.syncStamp != querySyncStamp) {
+        queryTree.Remove(it->second.proxy);
+        it = queryProxies.erase(it);
+      } else {
+        ++it;
+      }
     }
 
-    {
-      // Distance pre check
-      Vector3 objPos = i->GetTransform().GetPosition();
-      Vector3 rel = objPos - rayPos;
-      float maxExtent = i->GetBoundingVolume()->GetMaxExtent();
-      float distSqToObj =
-          Vector::Dot(rel, rel) +
-          (maxExtent * maxExtent); // Take into account max extent.
-      if (distSqToObj > maxDistSq) {
-        continue;
+    queryMovers.clear();
+    for (GameObject *o : gameObjects) {
+      auto proxy = queryProxies.find(o->GetWorldID());
+      if (proxy != queryProxies.end() && mightMove(o)) {
+        queryMovers.push_back({o, &proxy->second});
       }
+    }
+  }
+
+  for (auto [o, proxy] : queryMovers) {
+    const Transform &t = o->GetTransform();
+    if (proxy->generation == t.GetGeneration()) {
+      continue;
+    }
+    proxy->generation = t.GetGeneration();
+
+    o->UpdateBroadphaseAABB();
+    Vector3 halfSize;
+    o->GetBroadphaseAABB(halfSize);
+    queryTree.Move(proxy->proxy,
+                   Bounds::FromCentre(t.GetPosition(), halfSize));
+  }
+}
 
-      RayCollision thisCollision;
-      if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
-        if (thisCollision.rayDistance < collision.rayDistance &&
-            distanceCheck(thisCollision)) {
+bool GameWorld::Raycast(
+    Ray &r, RayCollision &collision, std::optional<float> maxDist,
+    const std::span<const GameObject *const> ignoreThis) const {
+  auto lock = LockWorld();
+  UpdateQueryTree();
+
+  float maxDistance = std::min(
+      maxDist.value_or(std::numeric_limits<float>::max()),
+      collision.rayDistance);
+
+  queryTree.RayCast(
+      r.GetPosition(), r.GetDirection(), maxDistance,
+      [&](int proxy, float &limit) {
+        GameObject *i = queryTree.GetObject(proxy);
+        if (std::find(ignoreThis.begin(), ignoreThis.end(), i) !=
+            ignoreThis.end()) {
+          return true;
+        }
+
+        RayCollision thisCollision;
+        if (CollisionDetection::RayIntersection(r, *i, thisCollision) &&
+            thisCollision.rayDistance < collision.rayDistance &&
+            thisCollision.rayDistance <= limit) {
           thisCollision.node = i;
           collision = thisCollision;
+          // Nothing further away can beat this one
+          limit = thisCollision.rayDistance;
         }
+        return true;
+      });
+
+  return collision.node != nullptr;
+}
+
+bool GameWorld::RaycastHitCheck(Ray &r, std::optional<float> maxDist,
+                                const GameObject *const ignoreThis) const {
+  auto lock = LockWorld();
+  UpdateQueryTree();
+
+  bool hit = false;
+  queryTree.RayCast(
+      r.GetPosition(), r.GetDirection(),
+      maxDist.value_or(std::numeric_limits<float>::max()),
+      [&](int proxy, float &limit) {
+        GameObject *i = queryTree.GetObject(proxy);
+        if (i == ignoreThis) {
+          return true;
+        }
+
+        RayCollision thisCollision;
+        hit = CollisionDetection::RayIntersection(r, *i, thisCollision) &&
+              thisCollision.rayDistance <= limit;
+        return !hit;
+      });
+  return hit;
+}
+
+/*
+Rays are grouped into packets in the order they're given, so rays that start
+near each other and head the same way should be given together. The tree is
+brought up to date once for the whole batch, and is only read after that, so
+packets can be cast from any number of threads at once.
+*/
+void GameWorld::RaycastBatch(std::span<const RayQuery> queries,
+                             std::span<RayCollision> results,
+                             ThreadPool *pool) const {
+  assert(results.size() >= queries.size());
+  auto lock = LockWorld();
+  UpdateQueryTree();
+
+  constexpr size_t Lanes = RayPacket::Lanes;
+  size_t packets = (queries.size() + Lanes - 1) / Lanes;
+  auto castPackets = [&](size_t begin, size_t end, unsigned) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t first = i * Lanes;
+      size_t count = std::min(Lanes, queries.size() - first);
+      RaycastPacket(queries.subspan(first, count),
+                    results.subspan(first, count));
+    }
+  };
+
+  // Packets handed to a thread at a time, enough to be worth the handoff
+  constexpr size_t packetChunk = 16;
+  if (pool) {
+    pool->ParallelFor(packets, packetChunk, castPackets);
+  } else {
+    castPackets(0, packets, 0);
+  }
+}
+
+void GameWorld::RaycastPacket(std::span<const RayQuery> queries,
+                              std::span<RayCollision> results) const {
+  RayPacket packet;
+  float maxDistance[RayPacket::Lanes];
+  int mask = 0;
+  for (int i = 0; i < (int)queries.size(); ++i) {
+    packet.Set(i, queries[i].ray);
+    maxDistance[i] =
+        queries[i].maxDist.value_or(std::numeric_limits<float>::max());
+    results[i] = RayCollision();
+    mask |= 1 << i;
+  }
+
+  queryTree.RayCastPacket(packet, mask, maxDistance, [&](int proxy, int lanes) {
+    GameObject *o = queryTree.GetObject(proxy);
+    for (int i = 0; i < (int)queries.size(); ++i) {
+      if (queries[i].ignore == o) {
+        lanes &= ~(1 << i);
+      }
+    }
+
+    RayCollision hits[RayPacket::Lanes];
+    lanes = CollisionDetection::RayPacketIntersection(packet, *o, lanes, hits);
+
+    int done = 0;
+    for (int i = 0; i < (int)queries.size(); ++i) {
+      if (!(lanes & (1 << i)) || hits[i].rayDistance > maxDistance[i] ||
+          hits[i].rayDistance >= results[i].rayDistance) {
+        continue;
+      }
+      hits[i].node = o;
+      results[i] = hits[i];
+      maxDistance[i] = hits[i].rayDistance;
+      if (queries[i].anyHit) {
+        done |= 1 << i;
       }
     }
-  next:;
+    return done;
+  });
+}
+
+bool QueryFilter::Accepts(const GameObject &o) const {
+  if (&o == ignore) {
+    return false;
   }
-  if (collision.node) {
-    return true;
+  const auto tags = o.GetTags().flags;
+  if ((tags & requireTags.flags) != requireTags.flags ||
+      (tags & excludeTags.flags) ||
+      (o.GetLayers().flags & excludeLayers.flags)) {
+    return false;
   }
-  return false;
+  const CollisionVolume *volume = o.GetBoundingVolume();
+  return includeTriggers || !volume || !volume->isTrigger();
 }
 
-bool GameWorld::RaycastHitCheck(Ray &r, std::optional<float> maxDist,
-                                const GameObject *const ignoreThis) const {
-  RayCollision collision;
+size_t GameWorld::OverlapVolume(const CollisionVolume &volume,
+                                const Transform &t, const Bounds &bounds,
+                                std::span<GameObject *> results,
+                                const QueryFilter &filter) const {
+  auto lock = LockWorld();
+  UpdateQueryTree();
+
+  size_t found = 0;
+  queryTree.Query(bounds, [&](int proxy) {
+    GameObject *o = queryTree.GetObject(proxy);
+    if (!filter.Accepts(*o)) {
+      return true;
+    }
+    CollisionDetection::CollisionInfo info;
+    bool swapped = false;
+    if (CollisionDetection::VolumeIntersection(volume, t,
+                                               *o->GetBoundingVolume(),
+                                               o->GetTransform(), info,
+                                               swapped)) {
+      if (found < results.size()) {
+        results[found] = o;
+      }
+      ++found;
+    }
+    return true;
+  });
+  return found;
+}
+
+size_t GameWorld::OverlapSphere(const Vector3 &centre, float radius,
+                                std::span<GameObject *> results,
+                                const QueryFilter &filter) const {
+  SphereVolume volume(radius);
+  Transform t;
+  t.SetPosition(centre);
+  return OverlapVolume(
+      volume, t, Bounds::FromCentre(centre, Vector3(radius, radius, radius)),
+      results, filter);
+}
 
-  auto distanceCheck = [&](const RayCollision &c) {
-    if (maxDist.has_value()) {
-      return c.rayDistance <= maxDist.value();
+size_t GameWorld::OverlapAABB(const Vector3 &centre, const Vector3 &halfSize,
+                              std::span<GameObject *> results,
+                              const QueryFilter &filter) const {
+  AABBVolume volume(halfSize);
+  Transform t;
+  t.SetPosition(centre);
+  return OverlapVolume(volume, t, Bounds::FromCentre(centre, halfSize),
+                       results, filter);
+}
+
+// The world space box around a capsule, however it's turned
+static Vector3 CapsuleHalfSize(const Quaternion &orientation, float halfHeight,
+                               float radius) {
+  Vector3 up = orientation * Vector3(0, halfHeight, 0);
+  return Vector3(std::abs(up.x) + radius, std::abs(up.y) + radius,
+                 std::abs(up.z) + radius);
+}
+
+size_t GameWorld::OverlapCapsule(const Vector3 &position,
+                                 const Quaternion &orientation,
+                                 float halfHeight, float radius,
+                                 std::span<GameObject *> results,
+                                 const QueryFilter &filter) const {
+  CapsuleVolume volume(halfHeight, radius);
+  Transform t;
+  t.SetPositionAndOrientation(position, orientation);
+  return OverlapVolume(
+      volume, t,
+      Bounds::FromCentre(position,
+                         CapsuleHalfSize(orientation, halfHeight, radius)),
+      results, filter);
+}
+
+bool GameWorld::SphereCast(const Vector3 &start, float radius,
+                           const Vector3 &motion, ShapeCastHit &hit,
+                           const QueryFilter &filter) const {
+  auto lock = LockWorld();
+  UpdateQueryTree();
+  hit = ShapeCastHit();
+
+  Vector3 halfSize(radius, radius, radius);
+  Bounds swept = Bounds::Union(Bounds::FromCentre(start, halfSize),
+                               Bounds::FromCentre(start + motion, halfSize));
+  queryTree.Query(swept, [&](int proxy) {
+    GameObject *o = queryTree.GetObject(proxy);
+    float fraction;
+    if (filter.Accepts(*o) &&
+        CollisionDetection::SweptSphereIntersection(start, motion, radius, *o,
+                                                    fraction) &&
+        (!hit.object || fraction < hit.fraction)) {
+      hit.object = o;
+      hit.fraction = fraction;
     }
     return true;
+  });
+
+  hit.position = start + motion * hit.fraction;
+  return hit;
+}
+
+/*
+Each object is only stepped through over the part of the motion where the
+shape's box and the object's box overlap, which the slab test gives from both
+ends, so a long cast past a small object costs a handful of steps rather than
+the whole length's worth. Once the step that first overlaps is found, halving
+the gap between it and the step before gets the time of impact to within a
+thousandth of a step.
+*/
+bool GameWorld::SteppedCast(const CollisionVolume &volume,
+                            const Quaternion &orientation,
+                            const Vector3 &start, const Vector3 &motion,
+                            const Vector3 &halfSize, float step,
+                            ShapeCastHit &hit,
+                            const QueryFilter &filter) const {
+  auto lock = LockWorld();
+  UpdateQueryTree();
+  hit = ShapeCastHit();
+
+  float length = Vector::Length(motion);
+  if (length <= 0.0f || step <= 0.0f) {
+    return false;
+  }
+  Vector3 invMotion(1.0f / motion.x, 1.0f / motion.y, 1.0f / motion.z);
+
+  Transform t;
+  auto overlaps = [&](const GameObject &o, float fraction) {
+    t.SetPositionAndOrientation(start + motion * fraction, orientation);
+    CollisionDetection::CollisionInfo info;
+    bool swapped = false;
+    return CollisionDetection::VolumeIntersection(
+        volume, t, *o.GetBoundingVolume(), o.GetTransform(), info, swapped);
   };
 
-  for (auto &i : gameObjects) {
-    if (!i->GetBoundingVolume()) { // objects might not be collideable etc...
-      continue;
+  Bounds swept = Bounds::Union(Bounds::FromCentre(start, halfSize),
+                               Bounds::FromCentre(start + motion, halfSize));
+  queryTree.Query(swept, [&](int proxy) {
+    GameObject *o = queryTree.GetObject(proxy);
+    if (!filter.Accepts(*o)) {
+      return true;
     }
-    if (i == ignoreThis) {
-      continue;
+
+    Vector3 objectSize;
+    o->GetBroadphaseAABB(objectSize);
+    Bounds reach = Bounds::FromCentre(o->GetTransform().GetPosition(),
+                                      objectSize + halfSize);
+    float enter, leave;
+    if (!reach.RayEntry(start, invMotion, 1.0f, enter) ||
+        !reach.RayEntry(start + motion, -invMotion, 1.0f, leave)) {
+      return true;
+    }
+    leave = 1.0f - leave;
+    if (hit.object && enter >= hit.fraction) {
+      return true;
     }
 
-    RayCollision thisCollision;
-    if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
-      if (distanceCheck(thisCollision)) {
-        return true;
+    if (overlaps(*o, enter)) {
+      // Only a hit if it wasn't overlapping to begin with
+      if (enter > 0.0f) {
+        hit.object = o;
+        hit.fraction = enter;
       }
+      return true;
     }
-  }
-  return false;
+
+    int steps = std::max(1, (int)std::ceil((leave - enter) * length / step));
+    float stepFraction = (leave - enter) / steps;
+    for (int i = 1; i <= steps; ++i) {
+      float before = enter + stepFraction * (i - 1);
+      float after = enter + stepFraction * i;
+      if (hit.object && before >= hit.fraction) {
+        break;
+      }
+      if (!overlaps(*o, after)) {
+        continue;
+      }
+      for (int j = 0; j < 10; ++j) {
+        float mid = (before + after) * 0.5f;
+        (overlaps(*o, mid) ? after : before) = mid;
+      }
+      if (!hit.object || after < hit.fraction) {
+        hit.object = o;
+        hit.fraction = after;
+      }
+      break;
+    }
+    return true;
+  });
+
+  hit.position = start + motion * hit.fraction;
+  return hit;
+}
+
+bool GameWorld::AABBCast(const Vector3 &start, const Vector3 &halfSize,
+                         const Vector3 &motion, ShapeCastHit &hit,
+                         const QueryFilter &filter) const {
+  AABBVolume volume(halfSize);
+  return SteppedCast(volume, Quaternion(), start, motion, halfSize,
+                     Vector::GetMinElement(halfSize), hit, filter);
+}
+
+bool GameWorld::CapsuleCast(const Vector3 &start, const Quaternion &orientation,
+                            float halfHeight, float radius,
+                            const Vector3 &motion, ShapeCastHit &hit,
+                            const QueryFilter &filter) const {
+  CapsuleVolume volume(halfHeight, radius);
+  return SteppedCast(volume, orientation, start, motion,
+                     CapsuleHalfSize(orientation, halfHeight, radius), radius,
+                     hit, filter);
 }
 
 bool GameWorld::IsOnGround(GameObject *object,
                            std::optional<float> checkDist) const {
-  Vector3 rayPos = object->GetTransform().GetPosition();
+  Vector3 rayPos = GetPhysicsState(*object).position;
   Vector3 rayDir = Vector3(0, -1, 0);
   Ray r = Ray(rayPos, rayDir);
   float checkDistance = checkDist.has_value() ? checkDist.value() : 0.1f;
@@ -188,8 +627,9 @@ GameWorld::LookingAt
 GameWorld::ObjectLookAt(GameObject *object,
                         std::optional<float> maxDist) const {
 
-  Vector3 rayPos = object->GetTransform().GetPosition();
-  Vector3 rayDir = object->GetTransform().GetOrientation() * Vector3(0, 0, -1);
+  PhysicsState state = GetPhysicsState(*object);
+  Vector3 rayPos = state.position;
+  Vector3 rayDir = state.orientation * Vector3(0, 0, -1);
 
   Ray r = Ray(rayPos, rayDir);
   RayCollision collision;
@@ -203,16 +643,63 @@ GameWorld::ObjectLookAt(GameObject *object,
   return {nullptr, RayCollision()};
 }
 
+/*
+Physics only publishes the bodies it moves. Anything else is only moved from
+the game's thread, and a body added since the last step was published hasn't
+been moved yet, and in either case the transform is only written with the
+world locked. Only physics knows how fast a body it hasn't published is going.
+*/
+PhysicsState GameWorld::GetPhysicsState(const GameObject &o) const {
+  if (physicsCommands && physicsSnapshots) {
+    const PhysicsSnapshot &snapshot = physicsSnapshots->Read();
+    if (const PhysicsSnapshot::Body *b = snapshot.Find(o, o.GetWorldID())) {
+      return {b->position, b->orientation, b->linearVelocity,
+              b->angularVelocity, b->generation};
+    }
+    auto lock = LockWorld();
+    const Transform &t = o.GetTransform();
+    return {t.GetPosition(), t.GetOrientation(), Vector3(), Vector3(),
+            t.GetGeneration()};
+  }
+
+  const Transform &t = o.GetTransform();
+  PhysicsState state = {t.GetPosition(), t.GetOrientation(), Vector3(),
+                        Vector3(), t.GetGeneration()};
+  if (const PhysicsObject *phys = o.GetPhysicsObject()) {
+    state.linearVelocity = phys->GetLinearVelocity();
+    state.angularVelocity = phys->GetAngularVelocity();
+  }
+  return state;
+}
+
+void GameWorld::ChangePhysics(GameObject &o, PhysicsCommand::Action action) {
+  if (!o.GetPhysicsObject()) {
+    return;
+  }
+  if (physicsCommands) {
+    physicsCommands->lock()->push_back(
+        {&o, o.GetWorldID(), std::move(action)});
+  } else {
+    PhysicsCommand::Apply(o, action);
+  }
+}
+
 /*
 Constraint Tutorial Stuff
 */
 
-void GameWorld::AddConstraint(Constraint *c) { constraints.emplace_back(c); }
+void GameWorld::AddConstraint(Constraint *c) {
+  auto lock = LockWorld();
+  constraints.emplace_back(c);
+}
 
 void GameWorld::RemoveConstraint(Constraint *c, bool andDelete) {
+  auto lock = LockWorld();
   constraints.erase(std::remove(constraints.begin(), constraints.end(), c),
                     constraints.end());
-  if (andDelete) {
+  if (andDelete && physicsCommands) {
+    pendingConstraintDeletes.push_back(c);
+  } else if (andDelete) {
     delete c;
   }
 }
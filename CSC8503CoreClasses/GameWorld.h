@@ -1,9 +1,17 @@
 #pragma once
 #include "./Camera.h"
+#include "GameObject.h"
 #include "IteratorRange.h"
+#include "Mutex.h"
+#include "TripleBuffer.h"
 #include "ai/pathfinding/PathfindingService.h"
+#include "collisions/AABBTree.h"
 #include "collisions/Ray.h"
+#include "physics/PhysicsCommands.h"
+#include "physics/PhysicsSnapshot.h"
+#include <mutex>
 #include <span>
+#include <unordered_map>
 
 namespace NCL {
 namespace Maths {
@@ -11,15 +19,28 @@ class Ray;
 } // namespace Maths
 class Camera;
 class PerspectiveCamera;
+class ThreadPool;
 
 namespace CSC8503 {
-class GameObject;
 class GamePlayer;
 class Constraint;
 
 typedef std::function<void(GameObject *)> GameObjectFunc;
 typedef std::vector<GameObject *>::const_iterator GameObjectIterator;
 
+/// @brief Which objects a shape query cares about. An object passes if it
+/// has every required tag, none of the excluded tags and layers, and isn't
+/// a trigger unless those are asked for
+struct QueryFilter {
+  Bitflag<GameObject::Tag> requireTags;
+  Bitflag<GameObject::Tag> excludeTags;
+  Bitflag<GameObject::Layer> excludeLayers;
+  const GameObject *ignore = nullptr;
+  bool includeTriggers = false;
+
+  bool Accepts(const GameObject &o) const;
+};
+
 class GameWorld {
 public:
   GameWorld();
@@ -45,6 +66,9 @@ public:
 
   void ShuffleObjects(bool state) { shuffleObjects = state; }
 
+  /// @brief Nearest object the ray hits. Rays only visit the parts of the
+  /// world they pass through, nearest first, so cost grows with the log of
+  /// the object count rather than the count itself
   bool Raycast(Ray &r, RayCollision &collision,
                std::optional<float> maxDist = std::nullopt,
                const GameObject *const ignore = nullptr) const {
@@ -56,9 +80,74 @@ public:
                std::optional<float> maxDist = std::nullopt,
                const std::span<const GameObject *const> ignore = {}) const;
 
+  /// @brief Whether the ray hits anything at all, stopping at the first
+  /// thing it finds
   bool RaycastHitCheck(Ray &r, std::optional<float> maxDist = std::nullopt,
                        const GameObject *const ignore = nullptr) const;
 
+  struct RayQuery {
+    Ray ray;
+    std::optional<float> maxDist = std::nullopt;
+    const GameObject *ignore = nullptr;
+    // Stop at the first thing hit, like RaycastHitCheck, rather than
+    // finding the nearest
+    bool anyHit = false;
+  };
+
+  /// @brief Raycast for a whole batch of rays, filling in a RayCollision for
+  /// each, with a null node for misses. Rays are cast a packet at a time,
+  /// sharing one walk of the tree, and packets can be spread over a pool
+  void RaycastBatch(std::span<const RayQuery> queries,
+                    std::span<RayCollision> results,
+                    ThreadPool *pool = nullptr) const;
+
+  /*
+  The overlap queries write what they find into results and return how many
+  they found, which can be more than results holds, in which case only the
+  first results.size() are written. Neither they nor the casts allocate.
+  */
+  size_t OverlapSphere(const Vector3 &centre, float radius,
+                       std::span<GameObject *> results,
+                       const QueryFilter &filter = {}) const;
+  size_t OverlapAABB(const Vector3 &centre, const Vector3 &halfSize,
+                     std::span<GameObject *> results,
+                     const QueryFilter &filter = {}) const;
+  /// @brief The capsule runs halfHeight either way along its up axis, plus
+  /// the radius, the same as CapsuleVolume
+  size_t OverlapCapsule(const Vector3 &position, const Quaternion &orientation,
+                        float halfHeight, float radius,
+                        std::span<GameObject *> results,
+                        const QueryFilter &filter = {}) const;
+
+  struct ShapeCastHit {
+    GameObject *object = nullptr;
+    // How far along the motion the shape got before touching, 0 to 1
+    float fraction = 1.0f;
+    // Where the shape's centre was at that point
+    Vector3 position;
+
+    operator bool() const { return object != nullptr; }
+  };
+
+  /*
+  The casts find the first thing a shape moving from start by motion would
+  touch. Anything the shape already overlaps at the start is ignored, so a
+  shape resting against something can still be cast away from it.
+
+  Sphere casts are exact. Box and capsule casts step along the motion no
+  more than half the shape's thinnest width at a time, then narrow down the
+  first overlapping step, so they can't pass through anything thicker than
+  that, but can be a hair late with glancing hits.
+  */
+  bool SphereCast(const Vector3 &start, float radius, const Vector3 &motion,
+                  ShapeCastHit &hit, const QueryFilter &filter = {}) const;
+  bool AABBCast(const Vector3 &start, const Vector3 &halfSize,
+                const Vector3 &motion, ShapeCastHit &hit,
+                const QueryFilter &filter = {}) const;
+  bool CapsuleCast(const Vector3 &start, const Quaternion &orientation,
+                   float halfHeight, float radius, const Vector3 &motion,
+                   ShapeCastHit &hit, const QueryFilter &filter = {}) const;
+
   bool IsOnGround(GameObject *object,
                   std::optional<float> checkDist = std::nullopt) const;
 
@@ -72,6 +161,23 @@ public:
   LookingAt ObjectLookAt(GameObject *object,
                          std::optional<float> maxDist = std::nullopt) const;
 
+  /// @brief Where an object is and how it's moving. While physics is
+  /// threaded that's as of the latest step it's published, so gameplay code
+  /// can read it without waiting on the step that's running
+  PhysicsState GetPhysicsState(const GameObject &o) const;
+
+  /// @brief Change an object's physics. While physics is threaded that's
+  /// queued for the start of its next step, otherwise it happens now
+  void ChangePhysics(GameObject &o, PhysicsCommand::Action action);
+
+  /// @brief Adding, removing and querying objects lock the world themselves,
+  /// and threaded physics holds it while it picks up changes to the world
+  /// and hands back where everything moved to. Hold it to make several
+  /// changes that physics should only see all together
+  std::unique_lock<std::recursive_mutex> LockWorld() const {
+    return std::unique_lock(worldMutex);
+  }
+
   virtual void UpdateWorld(float dt);
 
   void OperateOnContents(GameObjectFunc f);
@@ -136,10 +242,46 @@ public:
 
   Vector3 GetSunColour() const { return sunColour; }
 
+  /// @brief While physics is on its own thread, where to read the latest
+  /// body transforms from, rather than the objects it's busy moving
+  void SetPhysicsSnapshots(TripleBuffer<PhysicsSnapshot> *s) {
+    physicsSnapshots = s;
+  }
+  TripleBuffer<PhysicsSnapshot> *GetPhysicsSnapshots() {
+    return physicsSnapshots;
+  }
+
+  /// @brief While physics is on its own thread, where ChangePhysics queues
+  /// changes for it. Objects removed in the meantime are held on to until
+  /// physics has let go of them
+  void SetPhysicsCommands(Mutex<std::vector<PhysicsCommand>> *queue) {
+    physicsCommands = queue;
+  }
+
+  /// @brief Objects removed since physics last let go of any. Only for
+  /// threaded physics, with the world locked
+  const std::vector<GameObject *> &GetRemovedObjects() const {
+    return removedObjects;
+  }
+  /// @brief Physics has let go of everything removed so far, so whichever
+  /// were to be deleted can be on the next UpdateWorld
+  void ReleaseRemoved();
+
   PathfindingService &pathfind() { return pathfinding; }
   const PathfindingService &pathfind() const { return pathfinding; }
 
 protected:
+  void UpdateQueryTree() const;
+  void RaycastPacket(std::span<const RayQuery> queries,
+                     std::span<RayCollision> results) const;
+  size_t OverlapVolume(const CollisionVolume &volume, const Transform &t,
+                       const Bounds &bounds, std::span<GameObject *> results,
+                       const QueryFilter &filter) const;
+  bool SteppedCast(const CollisionVolume &volume, const Quaternion &orientation,
+                   const Vector3 &start, const Vector3 &motion,
+                   const Vector3 &halfSize, float step, ShapeCastHit &hit,
+                   const QueryFilter &filter) const;
+
   std::vector<GameObject *> gameObjects = {};
   std::map<int, GamePlayer *> players = {};
   std::vector<Constraint *> constraints = {};
@@ -148,6 +290,20 @@ protected:
 
   PathfindingService pathfinding;
 
+  TripleBuffer<PhysicsSnapshot> *physicsSnapshots = nullptr;
+  Mutex<std::vector<PhysicsCommand>> *physicsCommands = nullptr;
+
+  mutable std::recursive_mutex worldMutex;
+
+  // Taken out of the world while physics was threaded, so it could still be
+  // using them, and those of them and of the constraints to delete after
+  std::vector<GameObject *> removedObjects;
+  std::vector<GameObject *> pendingObjectDeletes;
+  std::vector<Constraint *> pendingConstraintDeletes;
+  // Physics has let go of these, so they're deleted on the next UpdateWorld
+  std::vector<GameObject *> releasedObjects;
+  std::vector<Constraint *> releasedConstraints;
+
   bool shuffleConstraints;
   bool shuffleObjects;
   int worldIDCounter;
@@ -155,6 +311,21 @@ protected:
 
   Vector3 sunPosition;
   Vector3 sunColour;
+
+  struct QueryProxy {
+    int proxy;
+    int syncStamp;
+    uint32_t generation;
+  };
+
+  // Every object that can be hit by a ray, keyed by world ID. Brought up to
+  // date before each query, which is why it's mutable
+  mutable AABBTree<GameObject *> queryTree;
+  mutable std::unordered_map<int, QueryProxy> queryProxies;
+  // The ones that aren't static bodies, so might have moved since
+  mutable std::vector<std::pair<GameObject *, QueryProxy *>> queryMovers;
+  mutable int queryWorldState = -1;
+  mutable int querySyncStamp = 0;
 };
 } // namespace CSC8503
 } // namespace NCL
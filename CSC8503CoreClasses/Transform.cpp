@@ -1,5 +1,7 @@
 #include "Transform.h"
 
+#include <algorithm>
+
 using namespace NCL::CSC8503;
 
 Transform::Transform()	{
@@ -10,27 +12,47 @@ Transform::~Transform()	{
 
 }
 
-void Transform::UpdateMatrix() {
+Transform& Transform::operator=(const Transform& other) {
+	matrix = other.matrix;
+	matrixDirty = other.matrixDirty;
+	orientation = other.orientation;
+	position = other.position;
+	scale = other.scale;
+	// Has to move past our old generation, or anything that cached it would
+	// think nothing had changed
+	generation = std::max(generation, other.generation) + 1;
+	return *this;
+}
+
+void Transform::UpdateMatrix() const {
 	matrix =
 		Matrix::Translation(position) *
 		Quaternion::RotationMatrix<Matrix4>(orientation) *
 		Matrix::Scale(scale);
+	matrixDirty = false;
 }
 
 Transform& Transform::SetPosition(const Vector3& worldPos) {
 	position = worldPos;
-	UpdateMatrix();
+	MarkChanged();
 	return *this;
 }
 
 Transform& Transform::SetScale(const Vector3& worldScale) {
 	scale = worldScale;
-	UpdateMatrix();
+	MarkChanged();
 	return *this;
 }
 
 Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
 	orientation = worldOrientation;
-	UpdateMatrix();
+	MarkChanged();
+	return *this;
+}
+
+Transform& Transform::SetPositionAndOrientation(const Vector3& worldPos, const Quaternion& worldOrientation) {
+	position = worldPos;
+	orientation = worldOrientation;
+	MarkChanged();
 	return *this;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 using std::vector;
@@ -13,9 +14,15 @@ public:
   Transform();
   ~Transform();
 
+  Transform(const Transform &other) = default;
+  Transform &operator=(const Transform &other);
+
   Transform &SetPosition(const Vector3 &worldPos);
   Transform &SetScale(const Vector3 &worldScale);
   Transform &SetOrientation(const Quaternion &newOr);
+  /// @brief Set both at once, counting as a single change
+  Transform &SetPositionAndOrientation(const Vector3 &worldPos,
+                                       const Quaternion &newOr);
 
   Vector3 GetPosition() const { return position; }
 
@@ -23,11 +30,30 @@ public:
 
   Quaternion GetOrientation() const { return orientation; }
 
-  Matrix4 GetMatrix() const { return matrix; }
-  void UpdateMatrix();
+  /// @brief The matrix is only rebuilt here, if anything has changed since
+  /// it was last asked for
+  const Matrix4 &GetMatrix() const {
+    if (matrixDirty) {
+      UpdateMatrix();
+    }
+    return matrix;
+  }
+
+  /// @brief Bumped every time the transform changes, so anything caching
+  /// something derived from it can tell if it needs redoing
+  uint32_t GetGeneration() const { return generation; }
 
 protected:
-  Matrix4 matrix;
+  void UpdateMatrix() const;
+  void MarkChanged() {
+    matrixDirty = true;
+    ++generation;
+  }
+
+  mutable Matrix4 matrix;
+  mutable bool matrixDirty = true;
+  uint32_t generation = 0;
+
   Quaternion orientation;
   Vector3 position;
 
@@ -0,0 +1,547 @@
+#pragma once
+#include "Bounds.h"
+#include "RayPacket.h"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+/*
+A persistent dynamic bounding volume hierarchy, used by the broadphase.
+
+Every object is stored as a leaf with a 'fat' bounding box - its real bounds
+grown by a margin, and stretched along the distance it is expected to travel
+next step. Objects only have to be reinserted once their real bounds leave the
+fat ones, so most frames nothing in the tree changes at all.
+
+Nodes live in a single pool and are recycled through a free list, so once the
+tree has grown to the size of the scene, inserting and removing does not touch
+the heap.
+*/
+template <class T> class AABBTree {
+public:
+  static constexpr int NullNode = -1;
+
+  AABBTree(float margin = 0.1f) : margin(margin) {}
+  ~AABBTree() = default;
+
+  int Insert(T object, const Bounds &bounds,
+             const Vector3 &displacement = Vector3()) {
+    int proxy = AllocateNode();
+    Node &node = nodes[proxy];
+    node.bounds = FatBounds(bounds, displacement);
+    node.object = object;
+    node.height = 0;
+
+    InsertLeaf(proxy);
+    ++proxyCount;
+    return proxy;
+  }
+
+  void Remove(int proxy) {
+    assert(proxy >= 0 && proxy < (int)nodes.size() && nodes[proxy].IsLeaf());
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --proxyCount;
+  }
+
+  /// @brief Update the bounds of a proxy.
+  /// @return true if the proxy left its fat bounds and had to be reinserted
+  bool Move(int proxy, const Bounds &bounds,
+            const Vector3 &displacement = Vector3()) {
+    assert(proxy >= 0 && proxy < (int)nodes.size() && nodes[proxy].IsLeaf());
+
+    if (nodes[proxy].bounds.Contains(bounds)) {
+      // Still inside, unless the fat box has become far too large for the
+      // object, in which case it's worth shrinking it back down
+      Bounds huge = FatBounds(bounds, displacement * 4.0f);
+      huge.Expand(Vector3(margin, margin, margin) * 4.0f);
+      if (huge.Contains(nodes[proxy].bounds)) {
+        return false;
+      }
+    }
+
+    RemoveLeaf(proxy);
+    nodes[proxy].bounds = FatBounds(bounds, displacement);
+    InsertLeaf(proxy);
+    return true;
+  }
+
+  T &GetObject(int proxy) { return nodes[proxy].object; }
+  const T &GetObject(int proxy) const { return nodes[proxy].object; }
+
+  const Bounds &GetFatBounds(int proxy) const { return nodes[proxy].bounds; }
+
+  size_t GetProxyCount() const { return proxyCount; }
+
+  int GetHeight() const { return root == NullNode ? 0 : nodes[root].height; }
+
+  void Clear() {
+    nodes.clear();
+    root = NullNode;
+    freeList = NullNode;
+    proxyCount = 0;
+  }
+
+  /// @brief Call func(proxy) for every proxy whose fat bounds overlap the
+  /// given bounds. Returning false from func stops the query.
+  template <typename F> void Query(const Bounds &bounds, F &&func) const {
+    TraversalStack<int> stack;
+    stack.Push(root);
+
+    while (!stack.Empty()) {
+      int id = stack.Pop();
+      if (id == NullNode) {
+        continue;
+      }
+
+      const Node &node = nodes[id];
+      if (!node.bounds.Overlaps(bounds)) {
+        continue;
+      }
+
+      if (node.IsLeaf()) {
+        if (!func(id)) {
+          return;
+        }
+      } else {
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+      }
+    }
+  }
+
+  /// @brief Call func(proxy, maxDistance) for every proxy whose fat bounds
+  /// the ray passes through before maxDistance. Whichever child the ray
+  /// reaches first is always looked at first, so func can bring maxDistance
+  /// in to the nearest hit so far and skip most of what's behind it.
+  /// Returning false from func stops the cast.
+  template <typename F>
+  void RayCast(const Vector3 &origin, const Vector3 &direction,
+               float maxDistance, F &&func) const {
+    if (root == NullNode) {
+      return;
+    }
+
+    Vector3 invDir(1.0f / direction.x, 1.0f / direction.y,
+                   1.0f / direction.z);
+    float entry;
+    if (!nodes[root].bounds.RayEntry(origin, invDir, maxDistance, entry)) {
+      return;
+    }
+
+    TraversalStack<RayNode> stack;
+    stack.Push({root, entry});
+
+    while (!stack.Empty()) {
+      RayNode current = stack.Pop();
+      // Something nearer may have been found since this was pushed
+      if (current.entry > maxDistance) {
+        continue;
+      }
+
+      const Node &node = nodes[current.id];
+      if (node.IsLeaf()) {
+        if (!func(current.id, maxDistance)) {
+          return;
+        }
+        continue;
+      }
+
+      RayNode near = {node.child1};
+      RayNode far = {node.child2};
+      bool hitNear = nodes[near.id].bounds.RayEntry(origin, invDir,
+                                                    maxDistance, near.entry);
+      bool hitFar = nodes[far.id].bounds.RayEntry(origin, invDir, maxDistance,
+                                                  far.entry);
+      if (hitNear && hitFar && far.entry < near.entry) {
+        std::swap(near, far);
+      } else if (!hitNear) {
+        std::swap(near, far);
+        std::swap(hitNear, hitFar);
+      }
+
+      // Nearest on top
+      if (hitFar) {
+        stack.Push(far);
+      }
+      if (hitNear) {
+        stack.Push(near);
+      }
+    }
+  }
+
+  /// @brief RayCast for a packet of rays at once, walking the tree once for
+  /// all of them. Calls func(proxy, lanes) for every proxy that any of the
+  /// lanes' rays pass through before their max distance, with lanes saying
+  /// which. func can bring in maxDistance for any lane, and returns the lanes
+  /// that are done and don't need anything else
+  template <typename F>
+  void RayCastPacket(const RayPacket &packet, int mask,
+                     float (&maxDistance)[RayPacket::Lanes], F &&func) const {
+    if (root == NullNode || mask == 0) {
+      return;
+    }
+
+    PacketNode start = {root};
+    start.mask =
+        packet.Entry(nodes[root].bounds, mask, maxDistance, start.entry);
+    if (start.mask == 0) {
+      return;
+    }
+
+    TraversalStack<PacketNode> stack;
+    stack.Push(start);
+
+    while (!stack.Empty()) {
+      PacketNode current = stack.Pop();
+      // Lanes may have finished, or found something nearer, since this was
+      // pushed
+      current.mask &= mask;
+      for (int i = 0; i < RayPacket::Lanes; ++i) {
+        if (current.entry[i] > maxDistance[i]) {
+          current.mask &= ~(1 << i);
+        }
+      }
+      if (current.mask == 0) {
+        continue;
+      }
+
+      const Node &node = nodes[current.id];
+      if (node.IsLeaf()) {
+        mask &= ~func(current.id, current.mask);
+        if (mask == 0) {
+          return;
+        }
+        continue;
+      }
+
+      PacketNode near = {node.child1};
+      PacketNode far = {node.child2};
+      near.mask = packet.Entry(nodes[near.id].bounds, current.mask,
+                               maxDistance, near.entry);
+      far.mask = packet.Entry(nodes[far.id].bounds, current.mask, maxDistance,
+                              far.entry);
+      if (near.mask == 0 ||
+          (far.mask != 0 && far.Nearest() < near.Nearest())) {
+        std::swap(near, far);
+      }
+
+      // Nearest on top
+      if (far.mask != 0) {
+        stack.Push(far);
+      }
+      if (near.mask != 0) {
+        stack.Push(near);
+      }
+    }
+  }
+
+  /// @brief Call func(a, b) once for every pair of objects whose fat bounds
+  /// overlap
+  template <typename F> void OperateOnPairs(F &&func) const {
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+      const Node &node = nodes[i];
+      if (node.height != 0) {
+        continue;
+      }
+
+      Query(node.bounds, [&](int other) {
+        if (other > i) {
+          func(node.object, nodes[other].object);
+        }
+        return true;
+      });
+    }
+  }
+
+protected:
+  struct Node {
+    Bounds bounds;
+    T object = {};
+
+    // Doubles as the next free node while the node is in the free list
+    int parent = NullNode;
+    int child1 = NullNode;
+    int child2 = NullNode;
+
+    // 0 for leaves, -1 for free nodes
+    int height = -1;
+
+    bool IsLeaf() const { return child1 == NullNode; }
+  };
+
+  struct RayNode {
+    int id;
+    // How far along the ray it enters the node's bounds
+    float entry = 0.0f;
+  };
+
+  struct PacketNode {
+    int id;
+    // Which lanes' rays reach the node's bounds, and where they go in
+    int mask = 0;
+    float entry[RayPacket::Lanes] = {};
+
+    float Nearest() const {
+      float nearest = FLT_MAX;
+      for (int i = 0; i < RayPacket::Lanes; ++i) {
+        if (mask & (1 << i)) {
+          nearest = std::min(nearest, entry[i]);
+        }
+      }
+      return nearest;
+    }
+  };
+
+  /*
+  Depth first traversal stack that only touches the heap if the tree is
+  deeper than we'd ever expect a balanced one to get.
+  */
+  template <typename E> class TraversalStack {
+  public:
+    void Push(const E &e) {
+      if (count < InlineSize) {
+        inlineStack[count++] = e;
+      } else {
+        overflow.push_back(e);
+        ++count;
+      }
+    }
+
+    E Pop() {
+      --count;
+      if (count < InlineSize) {
+        return inlineStack[count];
+      }
+      E e = overflow.back();
+      overflow.pop_back();
+      return e;
+    }
+
+    bool Empty() const { return count == 0; }
+
+  protected:
+    static constexpr int InlineSize = 128;
+    E inlineStack[InlineSize];
+    std::vector<E> overflow;
+    int count = 0;
+  };
+
+  Bounds FatBounds(const Bounds &bounds, const Vector3 &displacement) const {
+    Bounds fat = bounds;
+    fat.Expand(Vector3(margin, margin, margin));
+    fat.Extend(displacement);
+    return fat;
+  }
+
+  int AllocateNode() {
+    if (freeList == NullNode) {
+      nodes.emplace_back();
+      return (int)nodes.size() - 1;
+    }
+
+    int id = freeList;
+    freeList = nodes[id].parent;
+    nodes[id] = Node();
+    return id;
+  }
+
+  void FreeNode(int id) {
+    nodes[id].parent = freeList;
+    nodes[id].child1 = NullNode;
+    nodes[id].child2 = NullNode;
+    nodes[id].height = -1;
+    nodes[id].object = {};
+    freeList = id;
+  }
+
+  void InsertLeaf(int leaf) {
+    if (root == NullNode) {
+      root = leaf;
+      nodes[root].parent = NullNode;
+      return;
+    }
+
+    // Walk down the tree, picking whichever child is cheapest to grow by
+    // surface area, until it's cheaper to make a new parent here
+    Bounds leafBounds = nodes[leaf].bounds;
+    int index = root;
+    while (!nodes[index].IsLeaf()) {
+      const Node &node = nodes[index];
+      int child1 = node.child1;
+      int child2 = node.child2;
+
+      float area = node.bounds.SurfaceArea();
+      float combinedArea = Bounds::Union(node.bounds, leafBounds).SurfaceArea();
+
+      float cost = 2.0f * combinedArea;
+      float inheritanceCost = 2.0f * (combinedArea - area);
+
+      auto descendCost = [&](int child) {
+        Bounds b = Bounds::Union(leafBounds, nodes[child].bounds);
+        if (nodes[child].IsLeaf()) {
+          return b.SurfaceArea() + inheritanceCost;
+        }
+        return b.SurfaceArea() - nodes[child].bounds.SurfaceArea() +
+               inheritanceCost;
+      };
+
+      float cost1 = descendCost(child1);
+      float cost2 = descendCost(child2);
+
+      if (cost < cost1 && cost < cost2) {
+        break;
+      }
+
+      index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].bounds = Bounds::Union(leafBounds, nodes[sibling].bounds);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != NullNode) {
+      if (nodes[oldParent].child1 == sibling) {
+        nodes[oldParent].child1 = newParent;
+      } else {
+        nodes[oldParent].child2 = newParent;
+      }
+    } else {
+      root = newParent;
+    }
+
+    Refit(nodes[leaf].parent);
+  }
+
+  void RemoveLeaf(int leaf) {
+    if (leaf == root) {
+      root = NullNode;
+      return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                               : nodes[parent].child1;
+
+    if (grandParent != NullNode) {
+      if (nodes[grandParent].child1 == parent) {
+        nodes[grandParent].child1 = sibling;
+      } else {
+        nodes[grandParent].child2 = sibling;
+      }
+      nodes[sibling].parent = grandParent;
+      FreeNode(parent);
+
+      Refit(grandParent);
+    } else {
+      root = sibling;
+      nodes[sibling].parent = NullNode;
+      FreeNode(parent);
+    }
+  }
+
+  // Walk back up to the root, rebalancing and fixing up bounds and heights
+  void Refit(int index) {
+    while (index != NullNode) {
+      index = Balance(index);
+
+      Node &node = nodes[index];
+      const Node &child1 = nodes[node.child1];
+      const Node &child2 = nodes[node.child2];
+
+      node.height = 1 + std::max(child1.height, child2.height);
+      node.bounds = Bounds::Union(child1.bounds, child2.bounds);
+
+      index = node.parent;
+    }
+  }
+
+  /*
+  If one side of node a is more than one level deeper than the other, rotate
+  the deeper child up into a's place. Returns the index of the node now at
+  a's position in the tree.
+  */
+  int Balance(int a) {
+    Node &A = nodes[a];
+    if (A.IsLeaf() || A.height < 2) {
+      return a;
+    }
+
+    int b = A.child1;
+    int c = A.child2;
+
+    int balance = nodes[c].height - nodes[b].height;
+
+    if (balance > 1) {
+      return Rotate(a, c, b);
+    }
+    if (balance < -1) {
+      return Rotate(a, b, c);
+    }
+    return a;
+  }
+
+  // Promote child 'up' over a, keeping 'other' as a's remaining child
+  int Rotate(int a, int up, int other) {
+    Node &A = nodes[a];
+    Node &U = nodes[up];
+
+    int f = U.child1;
+    int g = U.child2;
+
+    U.child1 = a;
+    U.parent = A.parent;
+    A.parent = up;
+
+    if (U.parent != NullNode) {
+      if (nodes[U.parent].child1 == a) {
+        nodes[U.parent].child1 = up;
+      } else {
+        nodes[U.parent].child2 = up;
+      }
+    } else {
+      root = up;
+    }
+
+    // Keep the taller of up's children beneath up, and give the other to a
+    int keep = nodes[f].height > nodes[g].height ? f : g;
+    int give = keep == f ? g : f;
+
+    U.child2 = keep;
+    if (A.child1 == up) {
+      A.child1 = give;
+    } else {
+      A.child2 = give;
+    }
+    nodes[give].parent = a;
+
+    A.bounds = Bounds::Union(nodes[other].bounds, nodes[give].bounds);
+    A.height = 1 + std::max(nodes[other].height, nodes[give].height);
+
+    U.bounds = Bounds::Union(A.bounds, nodes[keep].bounds);
+    U.height = 1 + std::max(A.height, nodes[keep].height);
+
+    return up;
+  }
+
+  std::vector<Node> nodes;
+  int root = NullNode;
+  int freeList = NullNode;
+  size_t proxyCount = 0;
+  float margin;
+};
+} // namespace CSC8503
+} // namespace NCL
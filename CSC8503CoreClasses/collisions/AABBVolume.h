@@ -11,8 +11,10 @@ public:
   }
   ~AABBVolume() = default;
 
+  // As far as the corners reach, anything less and the quick distance check
+  // in ObjectIntersection throws away boxes touching corner first
   float GetMaxExtent() const override {
-    return Maths::Vector::GetAbsMaxElement(halfSizes) * 1.4f;
+    return Maths::Vector::Length(halfSizes);
   }
 
   Vector3
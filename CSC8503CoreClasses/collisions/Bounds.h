@@ -0,0 +1,98 @@
+#pragma once
+#include "Vector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+/// @brief World space axis aligned box stored as min / max corners, used by
+/// the broadphase acceleration structures.
+struct Bounds {
+  Vector3 min;
+  Vector3 max;
+
+  Bounds() = default;
+  Bounds(const Vector3 &min, const Vector3 &max) : min(min), max(max) {}
+
+  static Bounds FromCentre(const Vector3 &centre, const Vector3 &halfSize) {
+    return Bounds(centre - halfSize, centre + halfSize);
+  }
+
+  static Bounds Union(const Bounds &a, const Bounds &b) {
+    return Bounds(Vector3(std::min(a.min.x, b.min.x),
+                          std::min(a.min.y, b.min.y),
+                          std::min(a.min.z, b.min.z)),
+                  Vector3(std::max(a.max.x, b.max.x),
+                          std::max(a.max.y, b.max.y),
+                          std::max(a.max.z, b.max.z)));
+  }
+
+  Vector3 Centre() const { return (min + max) * 0.5f; }
+  Vector3 HalfSize() const { return (max - min) * 0.5f; }
+
+  float SurfaceArea() const {
+    Vector3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+
+  bool Contains(const Bounds &other) const {
+    return min.x <= other.min.x && min.y <= other.min.y &&
+           min.z <= other.min.z && max.x >= other.max.x &&
+           max.y >= other.max.y && max.z >= other.max.z;
+  }
+
+  bool Overlaps(const Bounds &other) const {
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+  }
+
+  /// @brief How far along a ray it first enters the box, 0 if it starts
+  /// inside. invDir is one over each component of the ray's direction, so
+  /// infinite on any axis the ray doesn't move along
+  bool RayEntry(const Vector3 &origin, const Vector3 &invDir,
+                float maxDistance, float &entry) const {
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int i = 0; i < 3; ++i) {
+      // A ray parallel to a slab never crosses it, so it's either inside it
+      // the whole way or never. Left to the maths below, a ray starting on
+      // one of its faces would give 0 * inf
+      if (std::isinf(invDir[i])) {
+        if (origin[i] < min[i] || origin[i] > max[i]) {
+          return false;
+        }
+        continue;
+      }
+      float t1 = (min[i] - origin[i]) * invDir[i];
+      float t2 = (max[i] - origin[i]) * invDir[i];
+      tMin = std::max(tMin, std::min(t1, t2));
+      tMax = std::min(tMax, std::max(t1, t2));
+    }
+    entry = tMin;
+    return tMin <= tMax;
+  }
+
+  Bounds &Expand(const Vector3 &amount) {
+    min -= amount;
+    max += amount;
+    return *this;
+  }
+
+  /// @brief Stretch the box along a displacement, so it covers everywhere the
+  /// box will be over the next step
+  Bounds &Extend(const Vector3 &displacement) {
+    for (int i = 0; i < 3; ++i) {
+      if (displacement[i] < 0.0f) {
+        min[i] += displacement[i];
+      } else {
+        max[i] += displacement[i];
+      }
+    }
+    return *this;
+  }
+};
+} // namespace CSC8503
+} // namespace NCL
@@ -2,6 +2,7 @@
 #include "AABBVolume.h"
 #include "CollisionVolume.h"
 #include "Debug.h"
+#include "GJK.h"
 #include "Maths.h"
 #include "OBBVolume.h"
 #include "SphereVolume.h"
@@ -9,6 +10,7 @@
 #include "Window.h"
 #include "logging/logger.h"
 #include <array>
+#include <cfloat>
 #include <span>
 
 using namespace NCL;
@@ -70,6 +72,75 @@ bool CollisionDetection::RayIntersection(const Ray &r, GameObject &object,
   return hasCollided;
 }
 
+int CollisionDetection::RayPacketIntersection(
+    const RayPacket &packet, GameObject &object, int mask,
+    RayCollision collisions[RayPacket::Lanes]) {
+  const CollisionVolume *volume = object.GetBoundingVolume();
+  if (mask == 0 || !volume ||
+      (object.GetLayers() & GameObject::Layer::RaycastIgnore)) {
+    return 0;
+  }
+
+  const Transform &worldTransform = object.GetTransform();
+  float distance[RayPacket::Lanes];
+  int hits = 0;
+
+  switch (volume->type) {
+  case VolumeType::AABB: {
+    const AABBVolume &box = (const AABBVolume &)*volume;
+    hits = packet.IntersectBox(worldTransform.GetPosition(),
+                               box.GetHalfDimensions(), mask, distance);
+    for (int i = 0; i < RayPacket::Lanes; ++i) {
+      if (hits & (1 << i)) {
+        collisions[i].collidedAt = packet.GetPoint(i, distance[i]);
+      }
+    }
+  } break;
+  case VolumeType::OBB: {
+    Quaternion rot = worldTransform.GetOrientation();
+    Vector3 pos = worldTransform.GetPosition();
+    Matrix3 transform = Quaternion::RotationMatrix<Matrix3>(rot);
+    Matrix3 invTransform = Quaternion::RotationMatrix<Matrix3>(rot.Conjugate());
+
+    RayPacket local = packet.Transformed(invTransform, pos);
+    hits = local.IntersectBox(Vector3(),
+                              ((const OBBVolume &)*volume).GetHalfDimensions(),
+                              mask, distance);
+    for (int i = 0; i < RayPacket::Lanes; ++i) {
+      if (hits & (1 << i)) {
+        collisions[i].collidedAt =
+            transform * local.GetPoint(i, distance[i]) + pos;
+      }
+    }
+  } break;
+  case VolumeType::Sphere:
+    hits = packet.IntersectSphere(worldTransform.GetPosition(),
+                                  ((const SphereVolume &)*volume).GetRadius(),
+                                  mask, distance);
+    for (int i = 0; i < RayPacket::Lanes; ++i) {
+      if (hits & (1 << i)) {
+        collisions[i].collidedAt = packet.GetPoint(i, distance[i]);
+      }
+    }
+    break;
+  default:
+    for (int i = 0; i < RayPacket::Lanes; ++i) {
+      if ((mask & (1 << i)) &&
+          RayIntersection(packet.GetRay(i), object, collisions[i])) {
+        hits |= 1 << i;
+      }
+    }
+    return hits;
+  }
+
+  for (int i = 0; i < RayPacket::Lanes; ++i) {
+    if (hits & (1 << i)) {
+      collisions[i].rayDistance = distance[i];
+    }
+  }
+  return hits;
+}
+
 bool CollisionDetection::RayBoxIntersection(const Ray &r, const Vector3 &boxPos,
                                             const Vector3 &boxSize,
                                             RayCollision &collision) {
@@ -250,6 +321,165 @@ bool CollisionDetection::RayCapsuleIntersection(const Ray &r,
   return true;
 }
 
+/*
+Sweeping a sphere against a shape is the same as casting a ray against the
+shape grown by the sphere's radius, so each of these is a ray test over
+[0, 1] of the motion. Boxes are grown as boxes, with square corners rather
+than rounded ones, so they can report a hit a little early but never late.
+*/
+namespace {
+// Earliest t in [0, 1] that start + motion * t is radius from centre
+bool SweepPointSphere(const Vector3 &start, const Vector3 &motion,
+                      const Vector3 &centre, float radius, float &t) {
+  Vector3 m = start - centre;
+  float a = Vector::Dot(motion, motion);
+  float b = Vector::Dot(m, motion);
+  float c = Vector::Dot(m, m) - radius * radius;
+  if (c <= 0.0f) {
+    t = 0.0f;
+    return true;
+  }
+  if (b >= 0.0f || a == 0.0f) {
+    return false;
+  }
+  float discriminant = b * b - a * c;
+  if (discriminant < 0.0f) {
+    return false;
+  }
+  t = (-b - sqrtf(discriminant)) / a;
+  return t <= 1.0f;
+}
+
+bool SweepPointBox(const Vector3 &start, const Vector3 &motion,
+                   const Vector3 &halfSize, float &t) {
+  float enter = 0.0f;
+  float exit = 1.0f;
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(motion[i]) < 1e-8f) {
+      if (start[i] < -halfSize[i] || start[i] > halfSize[i]) {
+        return false;
+      }
+      continue;
+    }
+    float inv = 1.0f / motion[i];
+    float t0 = (-halfSize[i] - start[i]) * inv;
+    float t1 = (halfSize[i] - start[i]) * inv;
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    enter = std::max(enter, t0);
+    exit = std::min(exit, t1);
+    if (enter > exit) {
+      return false;
+    }
+  }
+  t = enter;
+  return true;
+}
+
+bool SweepPointCapsule(const Vector3 &start, const Vector3 &motion,
+                       const Vector3 &a, const Vector3 &b, float radius,
+                       float &t) {
+  Vector3 axis = b - a;
+  float axisLengthSq = Vector::Dot(axis, axis);
+  if (axisLengthSq == 0.0f) {
+    return SweepPointSphere(start, motion, a, radius, t);
+  }
+
+  float startAlong =
+      std::clamp(Vector::Dot(start - a, axis) / axisLengthSq, 0.0f, 1.0f);
+  Vector3 fromAxis = start - (a + axis * startAlong);
+  if (Vector::Dot(fromAxis, fromAxis) <= radius * radius) {
+    t = 0.0f;
+    return true;
+  }
+
+  // The round ends
+  t = FLT_MAX;
+  float capT;
+  if (SweepPointSphere(start, motion, a, radius, capT)) {
+    t = capT;
+  }
+  if (SweepPointSphere(start, motion, b, radius, capT)) {
+    t = std::min(t, capT);
+  }
+
+  // The side, with everything projected onto the plane across the axis
+  Vector3 m = start - a;
+  Vector3 mPerp = m - axis * (Vector::Dot(m, axis) / axisLengthSq);
+  Vector3 dPerp = motion - axis * (Vector::Dot(motion, axis) / axisLengthSq);
+  float qa = Vector::Dot(dPerp, dPerp);
+  float qb = Vector::Dot(mPerp, dPerp);
+  float qc = Vector::Dot(mPerp, mPerp) - radius * radius;
+  if (qa > 0.0f && qb < 0.0f) {
+    float discriminant = qb * qb - qa * qc;
+    if (discriminant >= 0.0f) {
+      float sideT = std::max(0.0f, (-qb - sqrtf(discriminant)) / qa);
+      float along =
+          Vector::Dot(m + motion * sideT, axis) / axisLengthSq;
+      if (sideT <= 1.0f && along >= 0.0f && along <= 1.0f) {
+        t = std::min(t, sideT);
+      }
+    }
+  }
+  return t <= 1.0f;
+}
+} // namespace
+
+bool CollisionDetection::SweptSphereIntersection(const Vector3 &start,
+                                                 const Vector3 &motion,
+                                                 float radius,
+                                                 const GameObject &object,
+                                                 float &hitFraction) {
+  const CollisionVolume *volume = object.GetBoundingVolume();
+  if (!volume) {
+    return false;
+  }
+  const Transform &transform = object.GetTransform();
+  Vector3 position = transform.GetPosition();
+
+  float t = 1.0f;
+  bool hit = false;
+  switch (volume->type) {
+  case VolumeType::Sphere: {
+    float r = ((const SphereVolume &)*volume).GetRadius() + radius;
+    hit = SweepPointSphere(start, motion, position, r, t);
+    break;
+  }
+  case VolumeType::AABB: {
+    Vector3 halfSize = ((const AABBVolume &)*volume).GetHalfDimensions() +
+                       Vector3(radius, radius, radius);
+    hit = SweepPointBox(start - position, motion, halfSize, t);
+    break;
+  }
+  case VolumeType::OBB: {
+    Vector3 halfSize = ((const OBBVolume &)*volume).GetHalfDimensions() +
+                       Vector3(radius, radius, radius);
+    Quaternion invOrientation = transform.GetOrientation().Conjugate();
+    hit = SweepPointBox(invOrientation * (start - position),
+                        invOrientation * motion, halfSize, t);
+    break;
+  }
+  case VolumeType::Capsule: {
+    const CapsuleVolume &capsule = (const CapsuleVolume &)*volume;
+    Vector3 up = transform.GetOrientation() *
+                 Vector3(0, capsule.GetHalfHeight(), 0);
+    hit = SweepPointCapsule(start, motion, position + up, position - up,
+                            capsule.GetRadius() + radius, t);
+    break;
+  }
+  default:
+    break;
+  }
+
+  // Starting inside is the narrowphase's problem, not a hit
+  if (!hit || t <= 0.0f) {
+    return false;
+  }
+  hitFraction = t;
+  return true;
+}
+
 bool CollisionDetection::ObjectIntersection(GameObject *a, GameObject *b,
                                             CollisionInfo &collisionInfo) {
   const CollisionVolume *volA = a->GetBoundingVolume();
@@ -275,16 +505,84 @@ bool CollisionDetection::ObjectIntersection(GameObject *a, GameObject *b,
     return false;
   }
 
+  bool swapped = false;
+  if (!VolumeIntersection(*volA, transformA, *volB, transformB, collisionInfo,
+                          swapped)) {
+    return false;
+  }
+  if (swapped) {
+    collisionInfo.a = b;
+    collisionInfo.b = a;
+  }
+  return true;
+}
+
+/*
+Spheres and boxes that don't turn are quick enough to check without working
+out where they touch. Anything else has no cheaper test than the full one, so
+just throws the contact away.
+*/
+bool CollisionDetection::ObjectOverlap(const GameObject &a,
+                                       const GameObject &b) {
+  const CollisionVolume *volA = a.GetBoundingVolume();
+  const CollisionVolume *volB = b.GetBoundingVolume();
+  if (!volA || !volB) {
+    return false;
+  }
+
+  const Transform &transformA = a.GetTransform();
+  const Transform &transformB = b.GetTransform();
+  Vector3 relPos = transformB.GetPosition() - transformA.GetPosition();
+  float maxExtent = volA->GetMaxExtent() + volB->GetMaxExtent();
+  if (Vector::Dot(relPos, relPos) > maxExtent * maxExtent) {
+    return false;
+  }
+
+  if (volB->type == VolumeType::AABB && volA->type == VolumeType::Sphere) {
+    std::swap(volA, volB);
+    relPos = -relPos;
+  }
+  if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Sphere) {
+    float radii = ((const SphereVolume *)volA)->GetRadius() +
+                  ((const SphereVolume *)volB)->GetRadius();
+    return Vector::Dot(relPos, relPos) < radii * radii;
+  }
+  if (volA->type == VolumeType::AABB && volB->type == VolumeType::AABB) {
+    return AABBTest(Vector3(), relPos,
+                    ((const AABBVolume *)volA)->GetHalfDimensions(),
+                    ((const AABBVolume *)volB)->GetHalfDimensions());
+  }
+  if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
+    Vector3 halfSize = ((const AABBVolume *)volA)->GetHalfDimensions();
+    float radius = ((const SphereVolume *)volB)->GetRadius();
+    Vector3 outside = relPos - Vector::Clamp(relPos, -halfSize, halfSize);
+    return Vector::Dot(outside, outside) < radius * radius;
+  }
+
+  CollisionInfo info;
+  bool swapped = false;
+  return VolumeIntersection(*volA, transformA, *volB, transformB, info,
+                            swapped);
+}
+
+bool CollisionDetection::VolumeIntersection(const CollisionVolume &volA,
+                                            const Transform &transformA,
+                                            const CollisionVolume &volB,
+                                            const Transform &transformB,
+                                            CollisionInfo &collisionInfo,
+                                            bool &swapped) {
 #define A(FN, TYPEA, TYPEB)                                                    \
-  FN((TYPEA &)*volA, transformA, (TYPEB &)*volB, transformB, collisionInfo);
+  FN((const TYPEA &)volA, transformA, (const TYPEB &)volB, transformB,         \
+     collisionInfo);
 
 #define B(FN, TYPEB, TYPEA)                                                    \
-  collisionInfo.a = b, collisionInfo.b = a,                                    \
-  FN((TYPEB &)*volB, transformB, (TYPEA &)*volA, transformA, collisionInfo);
+  swapped = true,                                                              \
+  FN((const TYPEB &)volB, transformB, (const TYPEA &)volA, transformA,         \
+     collisionInfo);
 
-  switch (volA->type) {
+  switch (volA.type) {
   case VolumeType::AABB:
-    switch (volB->type) {
+    switch (volB.type) {
     case VolumeType::AABB:
       return A(AABBIntersection, AABBVolume, AABBVolume);
     case VolumeType::Sphere:
@@ -297,7 +595,7 @@ bool CollisionDetection::ObjectIntersection(GameObject *a, GameObject *b,
     break;
 
   case VolumeType::Sphere:
-    switch (volB->type) {
+    switch (volB.type) {
     case VolumeType::AABB:
       return B(AABBSphereIntersection, AABBVolume, SphereVolume);
     case VolumeType::Sphere:
@@ -309,7 +607,7 @@ bool CollisionDetection::ObjectIntersection(GameObject *a, GameObject *b,
     }
     break;
   case VolumeType::OBB:
-    switch (volB->type) {
+    switch (volB.type) {
     case VolumeType::AABB:
       return B(AABBOBBIntersection, AABBVolume, OBBVolume);
     case VolumeType::Sphere:
@@ -321,7 +619,7 @@ bool CollisionDetection::ObjectIntersection(GameObject *a, GameObject *b,
     }
     break;
   case VolumeType::Capsule:
-    switch (volB->type) {
+    switch (volB.type) {
     case VolumeType::AABB:
       return B(AABBCapsuleIntersection, AABBVolume, CapsuleVolume);
     case VolumeType::Sphere:
@@ -336,14 +634,386 @@ bool CollisionDetection::ObjectIntersection(GameObject *a, GameObject *b,
   return false;
 }
 
+CollisionDetection::PairKind
+CollisionDetection::GetPairKind(const GameObject &a, const GameObject &b) {
+  const CollisionVolume *volA = a.GetBoundingVolume();
+  const CollisionVolume *volB = b.GetBoundingVolume();
+  if (!volA || !volB) {
+    return PairKind::Other;
+  }
+  if (volA->isTrigger() || volB->isTrigger()) {
+    return PairKind::Trigger;
+  }
+
+  VolumeType typeA = volA->type;
+  VolumeType typeB = volB->type;
+  if (typeA == VolumeType::Sphere && typeB == VolumeType::Sphere) {
+    return PairKind::SphereSphere;
+  }
+  if (typeA == VolumeType::AABB && typeB == VolumeType::AABB) {
+    return PairKind::AABBAABB;
+  }
+  if ((typeA == VolumeType::AABB && typeB == VolumeType::Sphere) ||
+      (typeA == VolumeType::Sphere && typeB == VolumeType::AABB)) {
+    return PairKind::AABBSphere;
+  }
+  if (typeA == VolumeType::Capsule && typeB == VolumeType::Capsule) {
+    return PairKind::CapsuleCapsule;
+  }
+  return PairKind::Other;
+}
+
+/*
+The batched tests gather each lane's pair into arrays a component at a time,
+then run the same sums as the single pair tests across all the lanes, in the
+same order, so they give exactly the same contacts. Lanes past count are left
+zeroed, which every test treats as a miss, and are masked off anyway.
+
+Unlike ObjectIntersection there's no quick max extent check first, the tests
+are cheap enough that it would cost more than it saves.
+*/
+namespace {
+struct PairLanes {
+  // A's and B's positions, or the top of each capsule's segment
+  alignas(16) float a[3][4] = {};
+  alignas(16) float b[3][4] = {};
+  // Box half sizes, or radii in the first row
+  alignas(16) float aSize[3][4] = {};
+  alignas(16) float bSize[3][4] = {};
+  // Each capsule's segment, top to bottom
+  alignas(16) float aSegment[3][4] = {};
+  alignas(16) float bSegment[3][4] = {};
+
+  alignas(16) float normal[3][4];
+  alignas(16) float localA[3][4];
+  alignas(16) float localB[3][4];
+  alignas(16) float penetration[4];
+
+  static void Set(float (&v)[3][4], int lane, const Vector3 &value) {
+    v[0][lane] = value.x;
+    v[1][lane] = value.y;
+    v[2][lane] = value.z;
+  }
+  static Vector3 Get(const float (&v)[3][4], int lane) {
+    return Vector3(v[0][lane], v[1][lane], v[2][lane]);
+  }
+};
+
+#ifdef RAYPACKET_SSE
+struct Lanes3 {
+  __m128 x, y, z;
+
+  static Lanes3 Load(const float (&v)[3][4]) {
+    return {_mm_load_ps(v[0]), _mm_load_ps(v[1]), _mm_load_ps(v[2])};
+  }
+  void Store(float (&v)[3][4]) const {
+    _mm_store_ps(v[0], x);
+    _mm_store_ps(v[1], y);
+    _mm_store_ps(v[2], z);
+  }
+
+  Lanes3 operator+(const Lanes3 &o) const {
+    return {_mm_add_ps(x, o.x), _mm_add_ps(y, o.y), _mm_add_ps(z, o.z)};
+  }
+  Lanes3 operator-(const Lanes3 &o) const {
+    return {_mm_sub_ps(x, o.x), _mm_sub_ps(y, o.y), _mm_sub_ps(z, o.z)};
+  }
+  Lanes3 operator*(__m128 s) const {
+    return {_mm_mul_ps(x, s), _mm_mul_ps(y, s), _mm_mul_ps(z, s)};
+  }
+  Lanes3 operator-() const {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    return {_mm_xor_ps(x, sign), _mm_xor_ps(y, sign), _mm_xor_ps(z, sign)};
+  }
+
+  static __m128 Dot(const Lanes3 &a, const Lanes3 &b) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)),
+                      _mm_mul_ps(a.z, b.z));
+  }
+  // The same as Vector::Normalise, zero length staying zero
+  Lanes3 Normalised(__m128 length) const {
+    __m128 nonZero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+    __m128 r = _mm_and_ps(nonZero, _mm_div_ps(_mm_set1_ps(1.0f), length));
+    return *this * r;
+  }
+};
+
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128 Clamp01(__m128 v) {
+  return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+// SphereIntersection, for spheres at ca and cb
+int SphereLanes(PairLanes &p, const Lanes3 &ca, const Lanes3 &cb) {
+  __m128 ra = _mm_load_ps(p.aSize[0]);
+  __m128 rb = _mm_load_ps(p.bSize[0]);
+  __m128 radii = _mm_add_ps(ra, rb);
+
+  Lanes3 delta = cb - ca;
+  __m128 distSq = Lanes3::Dot(delta, delta);
+  __m128 hit = _mm_cmplt_ps(distSq, _mm_mul_ps(radii, radii));
+
+  __m128 length = _mm_sqrt_ps(distSq);
+  Lanes3 normal = delta.Normalised(length);
+  _mm_store_ps(p.penetration, _mm_sub_ps(radii, length));
+  normal.Store(p.normal);
+  (normal * ra).Store(p.localA);
+  (-normal * rb).Store(p.localB);
+  return _mm_movemask_ps(hit);
+}
+
+int SphereSphereLanes(PairLanes &p) {
+  return SphereLanes(p, Lanes3::Load(p.a), Lanes3::Load(p.b));
+}
+
+int AABBAABBLanes(PairLanes &p) {
+  Lanes3 posA = Lanes3::Load(p.a);
+  Lanes3 posB = Lanes3::Load(p.b);
+  Lanes3 sizeA = Lanes3::Load(p.aSize);
+  Lanes3 sizeB = Lanes3::Load(p.bSize);
+
+  // AABBTest
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  Lanes3 delta = posB - posA;
+  Lanes3 total = sizeA + sizeB;
+  __m128 hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, delta.x), total.x),
+                 _mm_cmplt_ps(_mm_andnot_ps(sign, delta.y), total.y)),
+      _mm_cmplt_ps(_mm_andnot_ps(sign, delta.z), total.z));
+
+  Lanes3 maxA = posA + sizeA;
+  Lanes3 minA = posA - sizeA;
+  Lanes3 maxB = posB + sizeB;
+  Lanes3 minB = posB - sizeB;
+
+  // The faces in AABBIntersection's order, the first of any ties winning
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  __m128 penetration = _mm_set1_ps(std::numeric_limits<float>::max());
+  Lanes3 normal = {zero, zero, zero};
+  auto face = [&](__m128 distance, int axis, __m128 direction) {
+    __m128 better = _mm_cmplt_ps(distance, penetration);
+    penetration = Select(better, distance, penetration);
+    normal.x = Select(better, axis == 0 ? direction : zero, normal.x);
+    normal.y = Select(better, axis == 1 ? direction : zero, normal.y);
+    normal.z = Select(better, axis == 2 ? direction : zero, normal.z);
+  };
+  face(_mm_sub_ps(maxB.x, minA.x), 0, minusOne);
+  face(_mm_sub_ps(maxA.x, minB.x), 0, one);
+  face(_mm_sub_ps(maxB.y, minA.y), 1, minusOne);
+  face(_mm_sub_ps(maxA.y, minB.y), 1, one);
+  face(_mm_sub_ps(maxB.z, minA.z), 2, minusOne);
+  face(_mm_sub_ps(maxA.z, minB.z), 2, one);
+
+  _mm_store_ps(p.penetration, penetration);
+  normal.Store(p.normal);
+  Lanes3{zero, zero, zero}.Store(p.localA);
+  Lanes3{zero, zero, zero}.Store(p.localB);
+  return _mm_movemask_ps(hit);
+}
+
+int AABBSphereLanes(PairLanes &p) {
+  Lanes3 boxSize = Lanes3::Load(p.aSize);
+  Lanes3 delta = Lanes3::Load(p.b) - Lanes3::Load(p.a);
+  Lanes3 closest = {
+      _mm_min_ps(_mm_max_ps(delta.x, (-boxSize).x), boxSize.x),
+      _mm_min_ps(_mm_max_ps(delta.y, (-boxSize).y), boxSize.y),
+      _mm_min_ps(_mm_max_ps(delta.z, (-boxSize).z), boxSize.z)};
+  Lanes3 local = delta - closest;
+
+  __m128 radius = _mm_load_ps(p.bSize[0]);
+  __m128 distSq = Lanes3::Dot(local, local);
+  __m128 hit = _mm_cmplt_ps(distSq, _mm_mul_ps(radius, radius));
+
+  __m128 length = _mm_sqrt_ps(distSq);
+  Lanes3 normal = local.Normalised(length);
+  const __m128 zero = _mm_setzero_ps();
+  _mm_store_ps(p.penetration, _mm_sub_ps(radius, length));
+  normal.Store(p.normal);
+  Lanes3{zero, zero, zero}.Store(p.localA);
+  (-normal * radius).Store(p.localB);
+  return _mm_movemask_ps(hit);
+}
+
+// CapsuleIntersection, finding the closest points of the two segments with
+// every branch worked out and the right one picked per lane
+int CapsuleCapsuleLanes(PairLanes &p) {
+  Lanes3 topA = Lanes3::Load(p.a);
+  Lanes3 topB = Lanes3::Load(p.b);
+  Lanes3 d1 = Lanes3::Load(p.aSegment);
+  Lanes3 d2 = Lanes3::Load(p.bSegment);
+  Lanes3 r = topA - topB;
+
+  const __m128 eps = _mm_set1_ps(1e-6f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+
+  __m128 a = Lanes3::Dot(d1, d1);
+  __m128 e = Lanes3::Dot(d2, d2);
+  __m128 f = Lanes3::Dot(d2, r);
+  __m128 b = Lanes3::Dot(d1, d2);
+  __m128 c = Lanes3::Dot(d1, r);
+  __m128 aPoint = _mm_cmple_ps(a, eps);
+  __m128 ePoint = _mm_cmple_ps(e, eps);
+
+  // Both segments long enough to be segments
+  __m128 denom = _mm_sub_ps(_mm_mul_ps(a, e), _mm_mul_ps(b, b));
+  __m128 s = _mm_and_ps(
+      _mm_cmpneq_ps(denom, zero),
+      Clamp01(_mm_div_ps(_mm_sub_ps(_mm_mul_ps(b, f), _mm_mul_ps(c, e)),
+                         denom)));
+  __m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(b, s), f), e);
+  __m128 sFromTop = Clamp01(_mm_div_ps(_mm_xor_ps(c, sign), a));
+  __m128 below = _mm_cmplt_ps(t, zero);
+  __m128 above = _mm_cmpgt_ps(t, one);
+  s = Select(below, sFromTop, s);
+  t = Select(below, zero, t);
+  s = Select(above, Clamp01(_mm_div_ps(_mm_sub_ps(b, c), a)), s);
+  t = Select(above, one, t);
+
+  // Either or both of them a point
+  __m128 onlyA = _mm_andnot_ps(ePoint, aPoint);
+  __m128 onlyE = _mm_andnot_ps(aPoint, ePoint);
+  __m128 both = _mm_and_ps(aPoint, ePoint);
+  s = Select(onlyA, zero, s);
+  t = Select(onlyA, Clamp01(_mm_div_ps(f, e)), t);
+  s = Select(onlyE, sFromTop, s);
+  t = Select(onlyE, zero, t);
+  s = _mm_andnot_ps(both, s);
+  t = _mm_andnot_ps(both, t);
+
+  return SphereLanes(p, topA + d1 * s, topB + d2 * t);
+}
+#endif
+} // namespace
+
+int CollisionDetection::BatchIntersection(PairKind kind,
+                                          CollisionInfo infos[BatchLanes],
+                                          int count) {
+  // Nothing pushes a trigger out, so there's no contact worth working out
+  if (kind == PairKind::Trigger) {
+    int hits = 0;
+    for (int lane = 0; lane < count; ++lane) {
+      if (ObjectOverlap(*infos[lane].a, *infos[lane].b)) {
+        hits |= 1 << lane;
+      }
+    }
+    return hits;
+  }
+
+  for (int lane = 0; lane < count; ++lane) {
+    // Boxes go first, the same way round ObjectIntersection has them
+    if (kind == PairKind::AABBSphere &&
+        infos[lane].a->GetBoundingVolume()->type == VolumeType::Sphere) {
+      std::swap(infos[lane].a, infos[lane].b);
+    }
+  }
+
+#ifdef RAYPACKET_SSE
+  if (kind != PairKind::Other) {
+    PairLanes p;
+    for (int lane = 0; lane < count; ++lane) {
+      const GameObject &a = *infos[lane].a;
+      const GameObject &b = *infos[lane].b;
+      const Transform &tA = a.GetTransform();
+      const Transform &tB = b.GetTransform();
+      PairLanes::Set(p.a, lane, tA.GetPosition());
+      PairLanes::Set(p.b, lane, tB.GetPosition());
+
+      auto size = [](const CollisionVolume &volume) {
+        switch (volume.type) {
+        case VolumeType::AABB:
+          return ((const AABBVolume &)volume).GetHalfDimensions();
+        case VolumeType::Sphere:
+          return Vector3(((const SphereVolume &)volume).GetRadius(), 0, 0);
+        default:
+          return Vector3(((const CapsuleVolume &)volume).GetRadius(), 0, 0);
+        }
+      };
+      PairLanes::Set(p.aSize, lane, size(*a.GetBoundingVolume()));
+      PairLanes::Set(p.bSize, lane, size(*b.GetBoundingVolume()));
+
+      if (kind == PairKind::CapsuleCapsule) {
+        auto segment = [](const Transform &t, const CollisionVolume &volume,
+                          float(&top)[3][4], float(&segment)[3][4],
+                          int lane) {
+          float halfHeight = ((const CapsuleVolume &)volume).GetHalfHeight();
+          Vector3 topPos =
+              t.GetPosition() +
+              (t.GetOrientation() * Vector3(0, halfHeight, 0));
+          Vector3 bottomPos =
+              t.GetPosition() +
+              (t.GetOrientation() * Vector3(0, -halfHeight, 0));
+          PairLanes::Set(top, lane, topPos);
+          PairLanes::Set(segment, lane, bottomPos - topPos);
+        };
+        segment(tA, *a.GetBoundingVolume(), p.a, p.aSegment, lane);
+        segment(tB, *b.GetBoundingVolume(), p.b, p.bSegment, lane);
+      }
+    }
+
+    int hits = 0;
+    switch (kind) {
+    case PairKind::SphereSphere:
+      hits = SphereSphereLanes(p);
+      break;
+    case PairKind::AABBAABB:
+      hits = AABBAABBLanes(p);
+      break;
+    case PairKind::AABBSphere:
+      hits = AABBSphereLanes(p);
+      break;
+    default:
+      hits = CapsuleCapsuleLanes(p);
+      break;
+    }
+    hits &= (1 << count) - 1;
+
+    for (int lane = 0; lane < count; ++lane) {
+      if (hits & (1 << lane)) {
+        infos[lane].AddContactPoint(PairLanes::Get(p.localA, lane),
+                                    PairLanes::Get(p.localB, lane),
+                                    PairLanes::Get(p.normal, lane),
+                                    p.penetration[lane]);
+      }
+    }
+    return hits;
+  }
+#endif
+
+  int hits = 0;
+  for (int lane = 0; lane < count; ++lane) {
+    CollisionInfo &info = infos[lane];
+    if (kind == PairKind::Other) {
+      if (ObjectIntersection(info.a, info.b, info)) {
+        hits |= 1 << lane;
+      }
+      continue;
+    }
+    bool swapped = false;
+    if (VolumeIntersection(*info.a->GetBoundingVolume(),
+                           info.a->GetTransform(),
+                           *info.b->GetBoundingVolume(),
+                           info.b->GetTransform(), info, swapped)) {
+      hits |= 1 << lane;
+    }
+  }
+  return hits;
+}
+
 bool CollisionDetection::AABBTest(const Vector3 &posA, const Vector3 &posB,
                                   const Vector3 &halfSizeA,
                                   const Vector3 &halfSizeB) {
   Vector3 delta = posB - posA;
   Vector3 totalSize = halfSizeA + halfSizeB;
 
-  if (abs(delta.x) < totalSize.x && abs(delta.y) < totalSize.y &&
-      abs(delta.z) < totalSize.z) {
+  if (std::abs(delta.x) < totalSize.x && std::abs(delta.y) < totalSize.y &&
+      std::abs(delta.z) < totalSize.z) {
     return true;
   }
   return false;
@@ -486,10 +1156,8 @@ bool CollisionDetection::AABBOBBIntersection(const AABBVolume &volumeA,
                                              const OBBVolume &volumeB,
                                              const Transform &worldTransformB,
                                              CollisionInfo &collisionInfo) {
-  OBBVolume boxA(volumeA.GetHalfDimensions());
-
-  return OBBIntersection(boxA, worldTransformA, volumeB, worldTransformB,
-                         collisionInfo);
+  return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB,
+                            collisionInfo);
 }
 
 bool CollisionDetection::AABBCapsuleIntersection(
@@ -519,120 +1187,216 @@ bool CollisionDetection::AABBCapsuleIntersection(
                                 collisionInfo);
 }
 
+/*
+The separating axis test for two boxes, done in A's space, where B's
+rotation relative to A is R[i][j] = Ai . Bj. Each box's reach along an axis
+then comes straight from its half sizes and R, without building either box's
+corners, see Ericson's Real-Time Collision Detection, 4.4.1.
+
+The 15 axes are taken three at a time, a group per SIMD register: A's faces,
+B's faces, then each of A's axes crossed with all three of B's. An axis's
+index is its group * 3 + its lane, the lane left over is padding.
+*/
+namespace {
+struct BoxPair {
+  alignas(16) float r[3][4];
+  alignas(16) float absR[3][4];
+  // absR the other way round, so B's axes can be read a column at a time
+  alignas(16) float absRT[3][4];
+  alignas(16) float a[4];
+  alignas(16) float b[4];
+  // B's centre in A's space
+  alignas(16) float t[4];
+};
+
+constexpr int BoxAxisGroups = 5;
+
+#ifdef RAYPACKET_SSE
+// How far each axis in the group overlaps, unnormalised, and the squared
+// length of the axis it was measured along
+void BoxAxisGroup(const BoxPair &p, int group, float overlap[4],
+                  float lengthSq[4]) {
+  auto weighted = [](const float w[4], const float (&v)[3][4]) {
+    return _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(w[0]), _mm_load_ps(v[0])),
+                   _mm_mul_ps(_mm_set1_ps(w[1]), _mm_load_ps(v[1]))),
+        _mm_mul_ps(_mm_set1_ps(w[2]), _mm_load_ps(v[2])));
+  };
+  auto abs = [](__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); };
+  // Lane j takes element j + 1 and j + 2, wrapping round
+  auto next = [](__m128 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
+  };
+  auto after = [](__m128 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 0, 2));
+  };
+
+  __m128 ra, rb, distance;
+  __m128 length = _mm_set1_ps(1.0f);
+  if (group == 0) {
+    ra = _mm_load_ps(p.a);
+    rb = weighted(p.b, p.absRT);
+    distance = abs(_mm_load_ps(p.t));
+  } else if (group == 1) {
+    ra = weighted(p.a, p.absR);
+    rb = _mm_load_ps(p.b);
+    distance = abs(weighted(p.t, p.r));
+  } else {
+    int i = group - 2;
+    int i1 = (i + 1) % 3;
+    int i2 = (i + 2) % 3;
+    __m128 row = _mm_load_ps(p.absR[i]);
+    __m128 b = _mm_load_ps(p.b);
+    ra = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.a[i1]), _mm_load_ps(p.absR[i2])),
+                    _mm_mul_ps(_mm_set1_ps(p.a[i2]), _mm_load_ps(p.absR[i1])));
+    rb = _mm_add_ps(_mm_mul_ps(next(b), after(row)),
+                    _mm_mul_ps(after(b), next(row)));
+    distance = abs(
+        _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(p.t[i2]), _mm_load_ps(p.r[i1])),
+                   _mm_mul_ps(_mm_set1_ps(p.t[i1]), _mm_load_ps(p.r[i2]))));
+    __m128 r = _mm_load_ps(p.r[i]);
+    length = _mm_sub_ps(length, _mm_mul_ps(r, r));
+  }
+  _mm_storeu_ps(overlap, _mm_sub_ps(_mm_add_ps(ra, rb), distance));
+  _mm_storeu_ps(lengthSq, length);
+}
+#else
+void BoxAxisGroup(const BoxPair &p, int group, float overlap[4],
+                  float lengthSq[4]) {
+  for (int lane = 0; lane < 3; ++lane) {
+    float ra, rb, distance;
+    lengthSq[lane] = 1.0f;
+    if (group == 0) {
+      ra = p.a[lane];
+      rb = p.b[0] * p.absR[lane][0] + p.b[1] * p.absR[lane][1] +
+           p.b[2] * p.absR[lane][2];
+      distance = std::abs(p.t[lane]);
+    } else if (group == 1) {
+      ra = p.a[0] * p.absR[0][lane] + p.a[1] * p.absR[1][lane] +
+           p.a[2] * p.absR[2][lane];
+      rb = p.b[lane];
+      distance = std::abs(p.t[0] * p.r[0][lane] + p.t[1] * p.r[1][lane] +
+                          p.t[2] * p.r[2][lane]);
+    } else {
+      int i = group - 2;
+      int i1 = (i + 1) % 3;
+      int i2 = (i + 2) % 3;
+      int j1 = (lane + 1) % 3;
+      int j2 = (lane + 2) % 3;
+      ra = p.a[i1] * p.absR[i2][lane] + p.a[i2] * p.absR[i1][lane];
+      rb = p.b[j1] * p.absR[i][j2] + p.b[j2] * p.absR[i][j1];
+      distance = std::abs(p.t[i2] * p.r[i1][lane] - p.t[i1] * p.r[i2][lane]);
+      lengthSq[lane] -= p.r[i][lane] * p.r[i][lane];
+    }
+    overlap[lane] = ra + rb - distance;
+  }
+}
+#endif
+} // namespace
+
+/*
+collisionInfo.separatingAxis is tried before anything else, and when the
+boxes turn out to be apart it's left holding the axis that showed it. Boxes
+that were apart one step are nearly always apart the same way the next, so
+handing it back then usually settles the pair in a single group.
+*/
 bool CollisionDetection::OBBIntersection(const OBBVolume &volumeA,
                                          const Transform &worldTransformA,
                                          const OBBVolume &volumeB,
                                          const Transform &worldTransformB,
                                          CollisionInfo &collisionInfo) {
-  auto aPos = worldTransformA.GetPosition();
-  auto aSize = volumeA.GetHalfDimensions();
-  auto aRot = worldTransformA.GetOrientation();
-
-  auto bPos = worldTransformB.GetPosition();
-  auto bSize = volumeB.GetHalfDimensions();
-  auto bRot = worldTransformB.GetOrientation();
-
-  struct Axes {
-    Vector3 right;
-    Vector3 up;
-    Vector3 forward;
-
-    Axes(const Quaternion &q) {
-      constexpr Vector3 UP(0, 1, 0);
-      constexpr Vector3 RIGHT(1, 0, 0);
-      constexpr Vector3 FORWARD(0, 0, 1);
-      right = q * RIGHT;
-      up = q * UP;
-      forward = q * FORWARD;
-    }
-  };
-
-  Axes aAxes(aRot);
-  Axes bAxes(bRot);
-
-  struct MinMax {
-    float min;
-    float max;
+  const Quaternion &aRot = worldTransformA.GetOrientation();
+  const Quaternion &bRot = worldTransformB.GetOrientation();
+  const Vector3 basis[3] = {Vector3(1, 0, 0), Vector3(0, 1, 0),
+                            Vector3(0, 0, 1)};
+  Vector3 aAxes[3];
+  Vector3 bAxes[3];
+  for (int i = 0; i < 3; ++i) {
+    aAxes[i] = aRot * basis[i];
+    bAxes[i] = bRot * basis[i];
+  }
 
-    bool contains(float value) const { return value >= min && value <= max; }
-  };
+  Vector3 offset =
+      worldTransformB.GetPosition() - worldTransformA.GetPosition();
+  Vector3 aSize = volumeA.GetHalfDimensions();
+  Vector3 bSize = volumeB.GetHalfDimensions();
 
-  auto getMinMax = [&](const Vector3 &axis,
-                       std::span<Vector3> corners) -> MinMax {
-    MinMax res{
-        .min = std::numeric_limits<float>::max(),
-        .max = -std::numeric_limits<float>::max(),
-    };
-
-    for (const auto &corner : corners) {
-      float projection = Vector::Dot(corner, axis);
-      res.min = std::min(res.min, projection);
-      res.max = std::max(res.max, projection);
+  BoxPair pair = {};
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      pair.r[i][j] = Vector::Dot(aAxes[i], bAxes[j]);
+      pair.absR[i][j] = std::abs(pair.r[i][j]);
+      pair.absRT[j][i] = pair.absR[i][j];
     }
+    pair.a[i] = aSize[i];
+    pair.b[i] = bSize[i];
+    pair.t[i] = Vector::Dot(offset, aAxes[i]);
+  }
 
-    return res;
-  };
+  // Edges this close to parallel give no axis, and a face axis covers them
+  constexpr float parallel = 0.0001f;
 
-  auto getCorners = [&](const Vector3 &pos, const Vector3 &size,
-                        const Axes &axes) -> std::array<Vector3, 8> {
-    std::array<Vector3, 8> corners;
-    int index = 0;
-    for (int x = -1; x <= 1; x += 2) {
-      for (int y = -1; y <= 1; y += 2) {
-        for (int z = -1; z <= 1; z += 2) {
-          Vector3 corner = pos + axes.right * size.x * (float)x +
-                           axes.up * size.y * (float)y +
-                           axes.forward * size.z * (float)z;
-          corners[index++] = corner;
-        }
+  auto separated = [&](int group, float overlap[4], float lengthSq[4]) {
+    BoxAxisGroup(pair, group, overlap, lengthSq);
+    for (int lane = 0; lane < 3; ++lane) {
+      if (overlap[lane] < 0.0f && lengthSq[lane] > parallel) {
+        collisionInfo.separatingAxis = group * 3 + lane;
+        return true;
       }
     }
-    return corners;
-  };
-
-  auto aCorners = getCorners(aPos, aSize, aAxes);
-  auto bCorners = getCorners(bPos, bSize, bAxes);
-
-  std::array<Vector3, 15> testAxes = {
-      aAxes.right,
-      aAxes.up,
-      aAxes.forward,
-      bAxes.right,
-      bAxes.up,
-      bAxes.forward,
-      Vector::Cross(aAxes.right, bAxes.right),
-      Vector::Cross(aAxes.right, bAxes.up),
-      Vector::Cross(aAxes.right, bAxes.forward),
-      Vector::Cross(aAxes.up, bAxes.right),
-      Vector::Cross(aAxes.up, bAxes.up),
-      Vector::Cross(aAxes.up, bAxes.forward),
-      Vector::Cross(aAxes.forward, bAxes.right),
-      Vector::Cross(aAxes.forward, bAxes.up),
-      Vector::Cross(aAxes.forward, bAxes.forward),
+    return false;
   };
 
-  float leastPenetration = std::numeric_limits<float>::max();
-  NCL::Maths::Vector3 bestAxis;
+  alignas(16) float overlap[BoxAxisGroups][4];
+  alignas(16) float lengthSq[BoxAxisGroups][4];
 
-  for (const auto &axis : testAxes) {
-    if (Vector::Dot(axis, axis) < 0.0001f) {
-      continue;
-    }
-    Vector3 normAxis = Vector::Normalise(axis);
-    MinMax aMinMax = getMinMax(normAxis, aCorners);
-    MinMax bMinMax = getMinMax(normAxis, bCorners);
-    if (!(aMinMax.contains(bMinMax.min) || bMinMax.contains(aMinMax.min))) {
+  int cachedGroup = collisionInfo.separatingAxis / 3;
+  bool haveCached = collisionInfo.separatingAxis >= 0 &&
+                    collisionInfo.separatingAxis < BoxAxisGroups * 3;
+  if (haveCached &&
+      separated(cachedGroup, overlap[cachedGroup], lengthSq[cachedGroup])) {
+    return false;
+  }
+  for (int group = 0; group < BoxAxisGroups; ++group) {
+    if ((!haveCached || group != cachedGroup) &&
+        separated(group, overlap[group], lengthSq[group])) {
       return false;
     }
+  }
+  collisionInfo.separatingAxis = -1;
 
-    float pen1 = aMinMax.max - bMinMax.min;
-    if (pen1 < leastPenetration) {
-      leastPenetration = pen1;
-      bestAxis = normAxis;
+  // Every axis overlaps, so push apart along whichever overlaps least
+  float leastPenetration = std::numeric_limits<float>::max();
+  int bestAxis = 0;
+  for (int group = 0; group < BoxAxisGroups; ++group) {
+    for (int lane = 0; lane < 3; ++lane) {
+      if (lengthSq[group][lane] <= parallel) {
+        continue;
+      }
+      float penetration =
+          overlap[group][lane] / std::sqrt(lengthSq[group][lane]);
+      if (penetration < leastPenetration) {
+        leastPenetration = penetration;
+        bestAxis = group * 3 + lane;
+      }
     }
   }
 
-  collisionInfo.AddContactPoint(Vector3(), Vector3(), bestAxis,
+  Vector3 normal;
+  if (bestAxis < 3) {
+    normal = aAxes[bestAxis];
+  } else if (bestAxis < 6) {
+    normal = bAxes[bestAxis - 3];
+  } else {
+    normal = Vector::Normalise(
+        Vector::Cross(aAxes[(bestAxis - 6) / 3], bAxes[(bestAxis - 6) % 3]));
+  }
+  // Pointing from A to B, like the other tests
+  if (Vector::Dot(normal, offset) < 0.0f) {
+    normal = -normal;
+  }
+
+  collisionInfo.AddContactPoint(Vector3(), Vector3(), normal,
                                 leastPenetration);
 
   return true;
@@ -643,14 +1407,35 @@ bool CollisionDetection::OBBSphereIntersection(const OBBVolume &volumeA,
                                                const SphereVolume &volumeB,
                                                const Transform &worldTransformB,
                                                CollisionInfo &collisionInfo) {
-  return false;
+  return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB,
+                            collisionInfo);
 }
 
 bool CollisionDetection::OBBCapsuleIntersection(
     const OBBVolume &volumeA, const Transform &worldTransformA,
     const CapsuleVolume &volumeB, const Transform &worldTransformB,
     CollisionInfo &collisionInfo) {
-  return false;
+  return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB,
+                            collisionInfo);
+}
+
+bool CollisionDetection::ConvexIntersection(const CollisionVolume &volumeA,
+                                            const Transform &worldTransformA,
+                                            const CollisionVolume &volumeB,
+                                            const Transform &worldTransformB,
+                                            CollisionInfo &collisionInfo) {
+  ConvexShape shapeA = ConvexShape::FromVolume(volumeA, worldTransformA);
+  ConvexShape shapeB = ConvexShape::FromVolume(volumeB, worldTransformB);
+
+  GJK::Contact contact;
+  if (!GJK::Intersect(shapeA, shapeB, collisionInfo.searchDirection,
+                      contact)) {
+    return false;
+  }
+  collisionInfo.AddContactPoint(contact.pointA - worldTransformA.GetPosition(),
+                                contact.pointB - worldTransformB.GetPosition(),
+                                contact.normal, contact.penetration);
+  return true;
 }
 
 bool CollisionDetection::CapsuleIntersection(const CapsuleVolume &volumeA,
@@ -9,6 +9,7 @@
 #include "CapsuleVolume.h"
 #include "OBBVolume.h"
 #include "Ray.h"
+#include "RayPacket.h"
 #include "SphereVolume.h"
 
 using NCL::Camera;
@@ -31,7 +32,16 @@ public:
 
     ContactPoint point;
 
-    CollisionInfo() : a(nullptr), b(nullptr), framesLeft(0), point() {}
+    // For box pairs, the axis that last kept them apart, or -1. Tried first
+    // by OBBIntersection, which sets it again
+    int separatingAxis;
+    // For pairs tested with GJK, where its search last finished, or zero.
+    // Starting from there again finds the answer in an iteration or two
+    Vector3 searchDirection;
+
+    CollisionInfo()
+        : a(nullptr), b(nullptr), framesLeft(0), point(), separatingAxis(-1),
+          searchDirection() {}
 
     void AddContactPoint(const Vector3 &localA, const Vector3 &localB,
                          const Vector3 &normal, float p) {
@@ -76,6 +86,13 @@ public:
   static bool RayIntersection(const Ray &r, GameObject &object,
                               RayCollision &collisions);
 
+  /// @brief RayIntersection for every lane of a packet in mask at once,
+  /// returning which lanes hit. Boxes and spheres are done a lane per SIMD
+  /// lane, anything else one ray at a time
+  static int RayPacketIntersection(const RayPacket &packet, GameObject &object,
+                                   int mask,
+                                   RayCollision collisions[RayPacket::Lanes]);
+
   static bool RayAABBIntersection(const Ray &r, const Transform &worldTransform,
                                   const AABBVolume &volume,
                                   RayCollision &collision);
@@ -94,12 +111,65 @@ public:
   static bool RayPlaneIntersection(const Ray &r, const Plane &p,
                                    RayCollision &collisions);
 
+  /// @brief When a sphere moving from start by motion first touches the
+  /// object, as a fraction of the motion. Objects the sphere already
+  /// overlaps at the start don't count
+  static bool SweptSphereIntersection(const Vector3 &start,
+                                      const Vector3 &motion, float radius,
+                                      const GameObject &object,
+                                      float &hitFraction);
+
   static bool AABBTest(const Vector3 &posA, const Vector3 &posB,
                        const Vector3 &halfSizeA, const Vector3 &halfSizeB);
 
   static bool ObjectIntersection(GameObject *a, GameObject *b,
                                  CollisionInfo &collisionInfo);
 
+  /// @brief Just whether two objects' volumes overlap, without working out
+  /// any contact, which is all a trigger needs
+  static bool ObjectOverlap(const GameObject &a, const GameObject &b);
+
+  static constexpr int BatchLanes = 4;
+
+  /// @brief Pairings of volumes with a batched test. Anything with a trigger
+  /// is a Trigger, whatever its volumes, and is only tested for overlap.
+  /// Anything else is Other, and is tested a pair at a time
+  enum class PairKind : uint8_t {
+    SphereSphere,
+    AABBAABB,
+    AABBSphere,
+    CapsuleCapsule,
+    Trigger,
+    Other,
+  };
+  static constexpr int PairKindCount = (int)PairKind::Other + 1;
+
+  static PairKind GetPairKind(const GameObject &a, const GameObject &b);
+
+  /// @brief ObjectIntersection for up to BatchLanes pairs of the same kind,
+  /// each with its a and b set, returning which of them hit. The common
+  /// pairings are tested a pair per SIMD lane
+  static int BatchIntersection(PairKind kind,
+                               CollisionInfo infos[BatchLanes], int count);
+
+  /// @brief ObjectIntersection for volumes that needn't belong to objects.
+  /// Some pairs are only tested with b first, which sets swapped, and then
+  /// the contact is given from b's side
+  static bool VolumeIntersection(const CollisionVolume &volA,
+                                 const Transform &transformA,
+                                 const CollisionVolume &volB,
+                                 const Transform &transformB,
+                                 CollisionInfo &collisionInfo, bool &swapped);
+
+  /// @brief The general test for any two convex volumes, GJK for how far
+  /// apart they are and EPA for how deep they overlap, for pairs without a
+  /// quicker test of their own
+  static bool ConvexIntersection(const CollisionVolume &volumeA,
+                                 const Transform &worldTransformA,
+                                 const CollisionVolume &volumeB,
+                                 const Transform &worldTransformB,
+                                 CollisionInfo &collisionInfo);
+
   static bool SphereIntersection(const SphereVolume &volumeA,
                                  const Transform &worldTransformA,
                                  const SphereVolume &volumeB,
@@ -40,10 +40,7 @@ public:
     return *this;
   }
 
-  bool isTrigger() const {
-    if (flags.has(VolumeFlags::Trigger))
-      return true;
-  }
+  bool isTrigger() const { return flags.has(VolumeFlags::Trigger); }
 
   VolumeType type;
   Bitflag<VolumeFlags> flags = Bitflag<VolumeFlags>(0);
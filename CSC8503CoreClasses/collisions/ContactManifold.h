@@ -0,0 +1,201 @@
+#pragma once
+#include "Quaternion.h"
+#include "Transform.h"
+#include "Vector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+/*
+The contact points between a pair of objects, kept from one step to the next.
+
+The narrowphase only finds one point per step, but points found on earlier
+steps are kept for as long as the objects haven't moved apart or slid away
+from them, so a box resting on the floor builds up a few points to stand on.
+Each point remembers the impulses the solver applied to it last step, which
+are applied again up front (warm starting), so a stack starts each step
+already close to balanced instead of having to be solved from nothing.
+
+Points are stored relative to each object, so they follow the objects around.
+The normal points from A to B.
+*/
+struct ContactManifold {
+  static constexpr int MaxPoints = 4;
+
+  struct Point {
+    // Relative to each object's position, in the object's own space
+    Vector3 anchorA;
+    Vector3 anchorB;
+
+    // The same, rotated into world space as of the last refresh
+    Vector3 rA;
+    Vector3 rB;
+
+    float penetration = 0.0f;
+    // How deep, and where the anchors were relative to each other, when the
+    // point was found, so penetration can be kept up to date as they move
+    float foundPenetration = 0.0f;
+    Vector3 foundSeparation;
+
+    // Accumulated over the solver iterations, and kept for warm starting
+    float normalImpulse = 0.0f;
+    float tangentImpulse[2] = {0.0f, 0.0f};
+
+    // Filled in by the solver each step
+    float normalMass = 0.0f;
+    float tangentMass[2] = {0.0f, 0.0f};
+    float bias = 0.0f;
+  };
+
+  Point points[MaxPoints];
+  int pointCount = 0;
+
+  Vector3 normal;
+  Vector3 tangents[2];
+
+  /// @brief How far apart objects can get, or slide, before a point is
+  /// dropped
+  static constexpr float BreakingDistance = 0.02f;
+  /// @brief How close a new point has to be to an old one to count as the same
+  static constexpr float MergeDistance = 0.05f;
+  /// @brief New normals further off than this reset the manifold
+  static constexpr float NormalTolerance = 0.95f;
+
+  void Clear() { pointCount = 0; }
+
+  /// @brief Move the points along with the objects, and drop any the objects
+  /// have separated or slid away from
+  void Refresh(const Transform &a, const Transform &b) {
+    Quaternion qA = a.GetOrientation();
+    Quaternion qB = b.GetOrientation();
+    Vector3 posA = a.GetPosition();
+    Vector3 posB = b.GetPosition();
+
+    for (int i = 0; i < pointCount;) {
+      Point &p = points[i];
+      Vector3 rA = qA * p.anchorA;
+      Vector3 rB = qB * p.anchorB;
+
+      Vector3 moved = ((posA + rA) - (posB + rB)) - p.foundSeparation;
+      float along = Vector::Dot(moved, normal);
+      float penetration = p.foundPenetration + along;
+      Vector3 slide = moved - normal * along;
+
+      if (penetration < -BreakingDistance ||
+          Vector::LengthSquared(slide) > BreakingDistance * BreakingDistance) {
+        points[i] = points[--pointCount];
+        continue;
+      }
+      p.rA = rA;
+      p.rB = rB;
+      p.penetration = penetration;
+      ++i;
+    }
+  }
+
+  /// @brief Add a newly found contact, given relative to each object's
+  /// position in world space. If it lands on a point we already have, that
+  /// point is updated and keeps its impulses
+  void AddPoint(const Transform &a, const Transform &b, const Vector3 &localA,
+                const Vector3 &localB, const Vector3 &newNormal,
+                float penetration) {
+    if (pointCount > 0 && Vector::Dot(normal, newNormal) < NormalTolerance) {
+      Clear();
+    }
+    SetNormal(newNormal);
+
+    Point p;
+    p.anchorA = a.GetOrientation().Conjugate() * localA;
+    p.anchorB = b.GetOrientation().Conjugate() * localB;
+    p.rA = localA;
+    p.rB = localB;
+    p.penetration = penetration;
+    p.foundPenetration = penetration;
+    p.foundSeparation =
+        (a.GetPosition() + localA) - (b.GetPosition() + localB);
+
+    const float mergeSq = MergeDistance * MergeDistance;
+    for (int i = 0; i < pointCount; ++i) {
+      Point &old = points[i];
+      if (Vector::LengthSquared(old.rA - p.rA) < mergeSq &&
+          Vector::LengthSquared(old.rB - p.rB) < mergeSq) {
+        p.normalImpulse = old.normalImpulse;
+        p.tangentImpulse[0] = old.tangentImpulse[0];
+        p.tangentImpulse[1] = old.tangentImpulse[1];
+        old = p;
+        return;
+      }
+    }
+
+    if (pointCount < MaxPoints) {
+      points[pointCount++] = p;
+      return;
+    }
+    Replace(p);
+  }
+
+protected:
+  void SetNormal(const Vector3 &n) {
+    normal = n;
+    // Any axis not too close to the normal will do to build the tangents from
+    Vector3 axis =
+        std::abs(n.x) < 0.57735f ? Vector3(1, 0, 0) : Vector3(0, 1, 0);
+    tangents[0] = Vector::Normalise(Vector::Cross(n, axis));
+    tangents[1] = Vector::Cross(n, tangents[0]);
+  }
+
+  /*
+  Full up, so keep the deepest point, and then whichever others cover the
+  widest area, as a wide base is what stops things rocking.
+  */
+  void Replace(const Point &p) {
+    Point candidates[MaxPoints + 1];
+    std::copy(points, points + MaxPoints, candidates);
+    candidates[MaxPoints] = p;
+
+    int deepest = 0;
+    for (int i = 1; i <= MaxPoints; ++i) {
+      if (candidates[i].penetration > candidates[deepest].penetration) {
+        deepest = i;
+      }
+    }
+
+    // Dropping whichever point leaves the rest spread furthest apart
+    auto spread = [&](int skip) {
+      float total = 0.0f;
+      for (int i = 0; i <= MaxPoints; ++i) {
+        for (int j = i + 1; j <= MaxPoints; ++j) {
+          if (i != skip && j != skip) {
+            total += Vector::LengthSquared(candidates[i].rA - candidates[j].rA);
+          }
+        }
+      }
+      return total;
+    };
+
+    int drop = -1;
+    float best = -1.0f;
+    for (int i = 0; i <= MaxPoints; ++i) {
+      if (i == deepest) {
+        continue;
+      }
+      float s = spread(i);
+      if (s > best) {
+        best = s;
+        drop = i;
+      }
+    }
+
+    int count = 0;
+    for (int i = 0; i <= MaxPoints; ++i) {
+      if (i != drop) {
+        points[count++] = candidates[i];
+      }
+    }
+  }
+};
+} // namespace CSC8503
+} // namespace NCL
@@ -0,0 +1,618 @@
+#include "GJK.h"
+#include "AABBVolume.h"
+#include "CapsuleVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+
+#include <cfloat>
+#include <cmath>
+
+using namespace NCL;
+using namespace NCL::CSC8503;
+
+ConvexShape ConvexShape::FromVolume(const CollisionVolume &volume,
+                                    const Transform &transform) {
+  ConvexShape shape;
+  shape.centre = transform.GetPosition();
+
+  switch (volume.type) {
+  case VolumeType::Sphere:
+    shape.core = Core::Point;
+    shape.radius = ((const SphereVolume &)volume).GetRadius();
+    break;
+  case VolumeType::Capsule: {
+    const CapsuleVolume &capsule = (const CapsuleVolume &)volume;
+    shape.core = Core::Segment;
+    shape.segment = transform.GetOrientation() *
+                    Vector3(0, capsule.GetHalfHeight(), 0);
+    shape.radius = capsule.GetRadius();
+    break;
+  }
+  case VolumeType::AABB:
+    // Boxes that don't turn with their object
+    shape.core = Core::Box;
+    shape.halfSize = ((const AABBVolume &)volume).GetHalfDimensions();
+    break;
+  case VolumeType::OBB: {
+    const Quaternion &orientation = transform.GetOrientation();
+    shape.core = Core::Box;
+    shape.halfSize = ((const OBBVolume &)volume).GetHalfDimensions();
+    shape.rotation = Quaternion::RotationMatrix<Matrix3>(orientation);
+    shape.inverseRotation =
+        Quaternion::RotationMatrix<Matrix3>(orientation.Conjugate());
+    break;
+  }
+  default:
+    break;
+  }
+  return shape;
+}
+
+ConvexShape ConvexShape::FromHull(std::span<const Vector3> points,
+                                  const Transform &transform) {
+  const Quaternion &orientation = transform.GetOrientation();
+  ConvexShape shape;
+  shape.core = Core::Hull;
+  shape.centre = transform.GetPosition();
+  shape.rotation = Quaternion::RotationMatrix<Matrix3>(orientation);
+  shape.inverseRotation =
+      Quaternion::RotationMatrix<Matrix3>(orientation.Conjugate());
+  shape.points = points;
+  return shape;
+}
+
+Vector3 ConvexShape::CoreSupport(const Vector3 &direction) const {
+  switch (core) {
+  case Core::Segment:
+    return Vector::Dot(direction, segment) >= 0.0f ? centre + segment
+                                                   : centre - segment;
+  case Core::Box: {
+    Vector3 local = inverseRotation * direction;
+    Vector3 corner(local.x >= 0.0f ? halfSize.x : -halfSize.x,
+                   local.y >= 0.0f ? halfSize.y : -halfSize.y,
+                   local.z >= 0.0f ? halfSize.z : -halfSize.z);
+    return centre + rotation * corner;
+  }
+  case Core::Hull: {
+    Vector3 local = inverseRotation * direction;
+    Vector3 best;
+    float bestDot = -FLT_MAX;
+    for (const Vector3 &p : points) {
+      float d = Vector::Dot(p, local);
+      if (d > bestDot) {
+        bestDot = d;
+        best = p;
+      }
+    }
+    return centre + rotation * best;
+  }
+  default:
+    return centre;
+  }
+}
+
+/*
+The simplex is kept as points on the Minkowski difference A - B, along with
+the point on each shape that made them, so that once the closest point on the
+simplex is known as a blend of its corners, the same blend of the shapes'
+points gives the closest point on each shape.
+
+Finding the closest point on the simplex also trims it down to just the
+corners that point is a blend of, the Voronoi region approach from Ericson's
+Real-Time Collision Detection, 5.1.
+*/
+namespace {
+struct SimplexPoint {
+  Vector3 w;
+  Vector3 a;
+  Vector3 b;
+};
+
+SimplexPoint SupportPoint(const ConvexShape &a, const ConvexShape &b,
+                          const Vector3 &direction, bool cores) {
+  SimplexPoint p;
+  p.a = cores ? a.CoreSupport(direction) : a.Support(direction);
+  p.b = cores ? b.CoreSupport(-direction) : b.Support(-direction);
+  p.w = p.a - p.b;
+  return p;
+}
+
+struct Simplex {
+  SimplexPoint points[4];
+  float weights[4] = {};
+  int count = 0;
+
+  void Keep(std::initializer_list<std::pair<int, float>> kept) {
+    SimplexPoint old[4] = {points[0], points[1], points[2], points[3]};
+    count = 0;
+    for (auto [i, weight] : kept) {
+      points[count] = old[i];
+      weights[count] = weight;
+      ++count;
+    }
+  }
+
+  Vector3 Closest() const {
+    Vector3 v;
+    for (int i = 0; i < count; ++i) {
+      v += points[i].w * weights[i];
+    }
+    return v;
+  }
+
+  void ClosestOnShapes(Vector3 &a, Vector3 &b) const {
+    a = Vector3();
+    b = Vector3();
+    for (int i = 0; i < count; ++i) {
+      a += points[i].a * weights[i];
+      b += points[i].b * weights[i];
+    }
+  }
+
+  void SolveSegment(int i, int j) {
+    Vector3 a = points[i].w;
+    Vector3 ab = points[j].w - a;
+    float lengthSq = Vector::Dot(ab, ab);
+    float t = lengthSq > 0.0f ? -Vector::Dot(a, ab) / lengthSq : 0.0f;
+    if (t <= 0.0f) {
+      Keep({{i, 1.0f}});
+    } else if (t >= 1.0f) {
+      Keep({{j, 1.0f}});
+    } else {
+      Keep({{i, 1.0f - t}, {j, t}});
+    }
+  }
+
+  void SolveTriangle(int i, int j, int k) {
+    Vector3 a = points[i].w;
+    Vector3 b = points[j].w;
+    Vector3 c = points[k].w;
+    Vector3 ab = b - a;
+    Vector3 ac = c - a;
+
+    float d1 = -Vector::Dot(ab, a);
+    float d2 = -Vector::Dot(ac, a);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+      Keep({{i, 1.0f}});
+      return;
+    }
+    float d3 = -Vector::Dot(ab, b);
+    float d4 = -Vector::Dot(ac, b);
+    if (d3 >= 0.0f && d4 <= d3) {
+      Keep({{j, 1.0f}});
+      return;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+      float v = d1 / (d1 - d3);
+      Keep({{i, 1.0f - v}, {j, v}});
+      return;
+    }
+    float d5 = -Vector::Dot(ab, c);
+    float d6 = -Vector::Dot(ac, c);
+    if (d6 >= 0.0f && d5 <= d6) {
+      Keep({{k, 1.0f}});
+      return;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+      float w = d2 / (d2 - d6);
+      Keep({{i, 1.0f - w}, {k, w}});
+      return;
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+      float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+      Keep({{j, 1.0f - w}, {k, w}});
+      return;
+    }
+    float denom = 1.0f / (va + vb + vc);
+    float v = vb * denom;
+    float w = vc * denom;
+    Keep({{i, 1.0f - v - w}, {j, v}, {k, w}});
+  }
+
+  // Whether the origin is on the far side of face ijk from the other corner.
+  // A flat tetrahedron counts every face as facing the origin
+  bool FaceSeesOrigin(int i, int j, int k, int other) const {
+    Vector3 a = points[i].w;
+    Vector3 normal = Vector::Cross(points[j].w - a, points[k].w - a);
+    float origin = -Vector::Dot(normal, a);
+    float corner = Vector::Dot(normal, points[other].w - a);
+    return corner * corner < 1e-12f || origin * corner < 0.0f;
+  }
+
+  /// @return true if the origin is inside the tetrahedron
+  bool SolveTetrahedron() {
+    constexpr int faces[4][4] = {
+        {0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+
+    Simplex best;
+    float bestDistSq = FLT_MAX;
+    bool outside = false;
+    for (auto &f : faces) {
+      if (!FaceSeesOrigin(f[0], f[1], f[2], f[3])) {
+        continue;
+      }
+      outside = true;
+      Simplex face = *this;
+      face.SolveTriangle(f[0], f[1], f[2]);
+      Vector3 v = face.Closest();
+      float distSq = Vector::Dot(v, v);
+      if (distSq < bestDistSq) {
+        bestDistSq = distSq;
+        best = face;
+      }
+    }
+    if (!outside) {
+      return true;
+    }
+    *this = best;
+    return false;
+  }
+
+  /// @brief Trim to the corners nearest the origin
+  /// @return true if the origin is inside
+  bool Solve() {
+    switch (count) {
+    case 1:
+      weights[0] = 1.0f;
+      return false;
+    case 2:
+      SolveSegment(0, 1);
+      return false;
+    case 3:
+      SolveTriangle(0, 1, 2);
+      return false;
+    default:
+      return SolveTetrahedron();
+    }
+  }
+};
+
+constexpr int MaxIterations = 32;
+// Distances closer than this count as touching
+constexpr float TouchingSq = 1e-10f;
+constexpr float RelativeTolerance = 1e-5f;
+
+// Walks the simplex towards the origin, returning false if the cores overlap,
+// in which case the simplex is left around, or touching, the origin
+bool Walk(const ConvexShape &a, const ConvexShape &b, Vector3 &searchDirection,
+          Simplex &simplex) {
+  Vector3 v = searchDirection;
+  if (Vector::Dot(v, v) <= TouchingSq) {
+    v = a.centre - b.centre;
+    if (Vector::Dot(v, v) <= TouchingSq) {
+      v = Vector3(1, 0, 0);
+    }
+  }
+
+  simplex.points[0] = SupportPoint(a, b, -v, true);
+  simplex.weights[0] = 1.0f;
+  simplex.count = 1;
+  v = simplex.points[0].w;
+
+  for (int i = 0; i < MaxIterations; ++i) {
+    float distSq = Vector::Dot(v, v);
+    if (distSq <= TouchingSq) {
+      searchDirection = v;
+      return false;
+    }
+
+    SimplexPoint w = SupportPoint(a, b, -v, true);
+    // No point further towards the origin than the simplex already gets
+    if (distSq - Vector::Dot(v, w.w) <= RelativeTolerance * distSq) {
+      break;
+    }
+    bool repeated = false;
+    for (int j = 0; j < simplex.count; ++j) {
+      Vector3 d = simplex.points[j].w - w.w;
+      repeated |= Vector::Dot(d, d) <= TouchingSq;
+    }
+    if (repeated) {
+      break;
+    }
+
+    simplex.points[simplex.count++] = w;
+    if (simplex.Solve()) {
+      searchDirection = v;
+      return false;
+    }
+    v = simplex.Closest();
+  }
+
+  searchDirection = v;
+  return true;
+}
+
+bool Penetration(const ConvexShape &a, const ConvexShape &b,
+                 const Simplex &simplex, GJK::Contact &contact);
+} // namespace
+
+bool GJK::CoreDistance(const ConvexShape &a, const ConvexShape &b,
+                       Vector3 &searchDirection, Vector3 &pointA,
+                       Vector3 &pointB) {
+  Simplex simplex;
+  if (!Walk(a, b, searchDirection, simplex)) {
+    return false;
+  }
+  simplex.ClosestOnShapes(pointA, pointB);
+  return true;
+}
+
+bool GJK::Intersect(const ConvexShape &a, const ConvexShape &b,
+                    Vector3 &searchDirection, Contact &contact) {
+  Simplex simplex;
+  if (!Walk(a, b, searchDirection, simplex)) {
+    if (!Penetration(a, b, simplex, contact)) {
+      return false;
+    }
+    // Seen from B, A sits back along the normal
+    searchDirection = -contact.normal;
+    return true;
+  }
+
+  Vector3 coreA;
+  Vector3 coreB;
+  simplex.ClosestOnShapes(coreA, coreB);
+  Vector3 delta = coreB - coreA;
+  float distance = Vector::Length(delta);
+  float radii = a.radius + b.radius;
+  if (distance >= radii || distance <= 0.0f) {
+    return false;
+  }
+
+  contact.normal = delta / distance;
+  contact.penetration = radii - distance;
+  contact.pointA = coreA + contact.normal * a.radius;
+  contact.pointB = coreB - contact.normal * b.radius;
+  return true;
+}
+
+/*
+EPA starts from a tetrahedron around the origin inside the whole shapes'
+Minkowski difference, and keeps pushing out its face nearest the origin by
+adding the support point along that face's normal, until the face can't be
+pushed out any further. That face is then the difference's surface nearest the
+origin, and its distance is how far the shapes overlap.
+
+The polytope is kept in fixed arrays, so running out of room just stops early
+with the best face so far, rather than allocating.
+*/
+namespace {
+struct Polytope {
+  static constexpr int MaxPoints = 64;
+  static constexpr int MaxFaces = 128;
+
+  struct Face {
+    int v[3];
+    Vector3 normal;
+    float distance;
+  };
+
+  SimplexPoint points[MaxPoints];
+  int pointCount = 0;
+  Face faces[MaxFaces];
+  int faceCount = 0;
+
+  bool AddFace(int i, int j, int k) {
+    if (faceCount == MaxFaces) {
+      return false;
+    }
+    Vector3 a = points[i].w;
+    Vector3 normal = Vector::Cross(points[j].w - a, points[k].w - a);
+    float length = Vector::Length(normal);
+    if (length <= 1e-12f) {
+      // Too thin to have a direction, but still part of the surface
+      normal = a;
+      length = Vector::Length(normal);
+      if (length <= 1e-12f) {
+        return true;
+      }
+    }
+    normal = normal / length;
+    faces[faceCount++] = {{i, j, k}, normal, Vector::Dot(normal, a)};
+    return true;
+  }
+};
+
+// Weights of p, which lies in triangle abc's plane, from each corner
+void Barycentric(const Vector3 &p, const Vector3 &a, const Vector3 &b,
+                 const Vector3 &c, float &u, float &v, float &w) {
+  Vector3 v0 = b - a;
+  Vector3 v1 = c - a;
+  Vector3 v2 = p - a;
+  float d00 = Vector::Dot(v0, v0);
+  float d01 = Vector::Dot(v0, v1);
+  float d11 = Vector::Dot(v1, v1);
+  float d20 = Vector::Dot(v2, v0);
+  float d21 = Vector::Dot(v2, v1);
+  float denom = d00 * d11 - d01 * d01;
+  if (std::abs(denom) <= 1e-12f) {
+    u = 1.0f;
+    v = w = 0.0f;
+    return;
+  }
+  v = (d11 * d20 - d01 * d21) / denom;
+  w = (d00 * d21 - d01 * d20) / denom;
+  u = 1.0f - v - w;
+}
+
+bool Penetration(const ConvexShape &a, const ConvexShape &b,
+                 const Simplex &simplex, GJK::Contact &contact) {
+  Polytope polytope;
+
+  /*
+  GJK leaves a simplex of points on the cores around the origin, or touching
+  it. Those are inside the whole shapes too, so they're somewhere to start,
+  but with fewer than four it has to be made up to a tetrahedron first, by
+  adding support points off the line or plane the others make.
+  */
+  SimplexPoint start[4];
+  int count = simplex.count;
+  for (int i = 0; i < count; ++i) {
+    start[i] = simplex.points[i];
+  }
+  const Vector3 axes[3] = {Vector3(1, 0, 0), Vector3(0, 1, 0),
+                           Vector3(0, 0, 1)};
+  while (count < 4) {
+    Vector3 directions[6];
+    int directionCount = 0;
+    if (count == 1) {
+      for (const Vector3 &axis : axes) {
+        directions[directionCount++] = axis;
+        directions[directionCount++] = -axis;
+      }
+    } else if (count == 2) {
+      Vector3 line = start[1].w - start[0].w;
+      for (const Vector3 &axis : axes) {
+        directions[directionCount++] = Vector::Cross(line, axis);
+        directions[directionCount++] = -Vector::Cross(line, axis);
+      }
+    } else {
+      Vector3 normal =
+          Vector::Cross(start[1].w - start[0].w, start[2].w - start[0].w);
+      directions[directionCount++] = normal;
+      directions[directionCount++] = -normal;
+    }
+
+    // Whichever is furthest off what's there already
+    float bestOffset = 1e-6f;
+    int best = -1;
+    SimplexPoint bestPoint;
+    for (int i = 0; i < directionCount; ++i) {
+      if (Vector::Dot(directions[i], directions[i]) <= 1e-12f) {
+        continue;
+      }
+      SimplexPoint p = SupportPoint(a, b, directions[i], false);
+      Vector3 offset = p.w - start[0].w;
+      float size = Vector::Length(offset);
+      if (count == 2) {
+        size = Vector::Length(Vector::Cross(start[1].w - start[0].w, offset));
+      } else if (count == 3) {
+        size = std::abs(Vector::Dot(directions[0], offset));
+      }
+      if (size > bestOffset) {
+        bestOffset = size;
+        best = i;
+        bestPoint = p;
+      }
+    }
+    if (best < 0) {
+      return false;
+    }
+    start[count++] = bestPoint;
+  }
+
+  // Wound so every face's normal points out
+  Vector3 baseNormal =
+      Vector::Cross(start[1].w - start[0].w, start[2].w - start[0].w);
+  if (Vector::Dot(baseNormal, start[3].w - start[0].w) > 0.0f) {
+    std::swap(start[1], start[2]);
+  }
+  for (int i = 0; i < 4; ++i) {
+    polytope.points[i] = start[i];
+  }
+  polytope.pointCount = 4;
+  polytope.AddFace(0, 1, 2);
+  polytope.AddFace(0, 3, 1);
+  polytope.AddFace(0, 2, 3);
+  polytope.AddFace(1, 3, 2);
+
+  // The origin has to be inside for the nearest face to mean anything
+  for (int i = 0; i < polytope.faceCount; ++i) {
+    if (polytope.faces[i].distance < -1e-4f) {
+      return false;
+    }
+  }
+
+  constexpr float tolerance = 1e-4f;
+  constexpr float coplanar = 1e-5f;
+  int closest = 0;
+  for (int iteration = 0; iteration < MaxIterations * 2; ++iteration) {
+    closest = 0;
+    for (int i = 1; i < polytope.faceCount; ++i) {
+      if (polytope.faces[i].distance < polytope.faces[closest].distance) {
+        closest = i;
+      }
+    }
+    const Polytope::Face nearest = polytope.faces[closest];
+    SimplexPoint w = SupportPoint(a, b, nearest.normal, false);
+    if (Vector::Dot(w.w, nearest.normal) - nearest.distance <= tolerance ||
+        polytope.pointCount == Polytope::MaxPoints) {
+      break;
+    }
+
+    // Take out every face the new point can see, keeping the edges round
+    // the hole they leave, which are the ones only one of them had. Boxes
+    // put lots of points in the same plane, and a face the point is only
+    // just in front of by rounding would leave a hole apart from the rest
+    int edges[Polytope::MaxFaces * 3][2];
+    int edgeCount = 0;
+    int newPoint = polytope.pointCount;
+    polytope.points[polytope.pointCount++] = w;
+    for (int i = 0; i < polytope.faceCount;) {
+      const Polytope::Face &face = polytope.faces[i];
+      if (Vector::Dot(face.normal, w.w - polytope.points[face.v[0]].w) <=
+          coplanar) {
+        ++i;
+        continue;
+      }
+      for (int e = 0; e < 3; ++e) {
+        int from = face.v[e];
+        int to = face.v[(e + 1) % 3];
+        bool shared = false;
+        for (int k = 0; k < edgeCount; ++k) {
+          if (edges[k][0] == to && edges[k][1] == from) {
+            edges[k][0] = edges[edgeCount - 1][0];
+            edges[k][1] = edges[edgeCount - 1][1];
+            --edgeCount;
+            shared = true;
+            break;
+          }
+        }
+        if (!shared) {
+          edges[edgeCount][0] = from;
+          edges[edgeCount][1] = to;
+          ++edgeCount;
+        }
+      }
+      polytope.faces[i] = polytope.faces[--polytope.faceCount];
+    }
+
+    bool full = false;
+    for (int e = 0; e < edgeCount && !full; ++e) {
+      full = !polytope.AddFace(edges[e][0], edges[e][1], newPoint);
+    }
+    if (full || polytope.faceCount == 0) {
+      break;
+    }
+  }
+  if (polytope.faceCount == 0) {
+    return false;
+  }
+
+  closest = 0;
+  for (int i = 1; i < polytope.faceCount; ++i) {
+    if (polytope.faces[i].distance < polytope.faces[closest].distance) {
+      closest = i;
+    }
+  }
+  const Polytope::Face &face = polytope.faces[closest];
+  // Only touching
+  if (face.distance <= 0.0f) {
+    return false;
+  }
+  const SimplexPoint &fa = polytope.points[face.v[0]];
+  const SimplexPoint &fb = polytope.points[face.v[1]];
+  const SimplexPoint &fc = polytope.points[face.v[2]];
+  float u, v, w;
+  Barycentric(face.normal * face.distance, fa.w, fb.w, fc.w, u, v, w);
+
+  contact.normal = face.normal;
+  contact.penetration = face.distance;
+  contact.pointA = fa.a * u + fb.a * v + fc.a * w;
+  contact.pointB = fa.b * u + fb.b * v + fc.b * w;
+  return true;
+}
+} // namespace
@@ -0,0 +1,93 @@
+#pragma once
+#include "Matrix.h"
+#include "Transform.h"
+#include "Vector.h"
+
+#include <cstdint>
+#include <span>
+
+namespace NCL {
+class CollisionVolume;
+using namespace NCL::Maths;
+namespace CSC8503 {
+/*
+A convex volume as GJK sees it: a core shape, which is a point, a segment, a
+box or a hull of points, grown by a radius. Spheres are a point grown by their
+radius and capsules a segment grown by theirs, so neither needs rounding off
+with lots of support points, and the distance between two cores tells how
+deep the grown shapes overlap without going anywhere near EPA.
+
+Everything is in world space, worked out once when the shape is built, so
+support queries don't go back through the transform.
+*/
+struct ConvexShape {
+  enum class Core : uint8_t {
+    Point,
+    Segment,
+    Box,
+    Hull,
+  };
+
+  Core core = Core::Point;
+  Vector3 centre;
+  // A box's or hull's axes, and the other way round for local directions
+  Matrix3 rotation;
+  Matrix3 inverseRotation;
+  Vector3 halfSize;
+  // From the centre to one end of a segment, the other end is -segment
+  Vector3 segment;
+  float radius = 0.0f;
+  // A hull's points, in its own space, which must outlive the shape
+  std::span<const Vector3> points;
+
+  static ConvexShape FromVolume(const CollisionVolume &volume,
+                                const Transform &transform);
+  static ConvexShape FromHull(std::span<const Vector3> points,
+                              const Transform &transform);
+
+  /// @brief The core's furthest point along direction, which needn't be
+  /// normalised
+  Vector3 CoreSupport(const Vector3 &direction) const;
+
+  /// @brief The whole shape's furthest point along direction
+  Vector3 Support(const Vector3 &direction) const {
+    Vector3 point = CoreSupport(direction);
+    if (radius > 0.0f) {
+      point += Vector::Normalise(direction) * radius;
+    }
+    return point;
+  }
+};
+
+/*
+GJK finds how far apart two convex shapes are, by walking a simplex of points
+on their Minkowski difference towards the origin. Where the cores overlap, EPA
+grows that simplex out to the surface of the difference to find how deep.
+
+Both take a search direction to start from, and leave it holding where they
+finished, so handing it back next step starts the search next to the answer
+and a pair that has barely moved settles in an iteration or two.
+*/
+class GJK {
+public:
+  struct Contact {
+    // From A to B
+    Vector3 normal;
+    float penetration = 0.0f;
+    // On the surface of each shape, in world space
+    Vector3 pointA;
+    Vector3 pointB;
+  };
+
+  /// @brief The closest points between two shapes' cores, or false if the
+  /// cores overlap
+  static bool CoreDistance(const ConvexShape &a, const ConvexShape &b,
+                           Vector3 &searchDirection, Vector3 &pointA,
+                           Vector3 &pointB);
+
+  /// @brief Whether the two shapes overlap, and if so where and how deeply
+  static bool Intersect(const ConvexShape &a, const ConvexShape &b,
+                        Vector3 &searchDirection, Contact &contact);
+};
+} // namespace CSC8503
+} // namespace NCL
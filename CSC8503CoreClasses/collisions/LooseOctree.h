@@ -0,0 +1,223 @@
+#pragma once
+#include "Bounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+/*
+Loose octree, rebuilt from scratch whenever it's filled.
+
+The root is a cube fitted around everything inserted, so there's no fixed
+world size for objects to fall outside of, and it splits on all three axes,
+so floors stacked on top of each other end up in different cells.
+
+Every object goes in exactly one node: the smallest cell that's at least as
+big as the object, and has the object's centre in it. Each node's bounds
+are loosened to twice the size of its cell, which is enough to hold anything
+centred in it that's no bigger than the cell, so objects never straddle a
+split and never need storing twice.
+
+Nodes and entries live in flat arrays that are kept between builds, and
+entries are sorted by node, so each node's objects are contiguous.
+*/
+template <class T> class LooseOctree {
+public:
+  static constexpr int NullNode = -1;
+
+  struct Entry {
+    Bounds bounds;
+    T object;
+    int node = NullNode;
+  };
+
+  LooseOctree(int maxDepth = 8) : maxDepth(maxDepth) {}
+  ~LooseOctree() = default;
+
+  /// @brief Throw everything away, but keep the memory for the next build
+  void Clear() {
+    entries.clear();
+    nodes.clear();
+  }
+
+  /// @brief Add an object for the next Build
+  void Insert(T object, const Bounds &bounds) {
+    entries.push_back({bounds, object, NullNode});
+  }
+
+  /// @brief Fit the root around everything inserted and sort it all into
+  /// nodes. Nothing can be queried until this is done
+  void Build() {
+    nodes.clear();
+    sorted.clear();
+    if (entries.empty()) {
+      return;
+    }
+
+    Bounds all = entries[0].bounds;
+    for (const Entry &e : entries) {
+      all = Bounds::Union(all, e.bounds);
+    }
+    Vector3 extent = all.max - all.min;
+    rootSize = std::max(Vector::GetMaxElement(extent), 1.0f);
+    rootMin = all.Centre() - Vector3(rootSize, rootSize, rootSize) * 0.5f;
+
+    nodes.push_back(MakeNode(0, 0, 0, 0, NullNode));
+    for (Entry &e : entries) {
+      e.node = NodeFor(e.bounds);
+      ++nodes[e.node].count;
+    }
+
+    // Children are always made after their parents, so going backwards adds
+    // every subtree up before its parent gets to it
+    for (int i = (int)nodes.size() - 1; i > 0; --i) {
+      nodes[nodes[i].parent].subtreeCount += nodes[i].subtreeCount;
+    }
+
+    // Counting sort by node
+    int first = 0;
+    for (Node &n : nodes) {
+      n.first = first;
+      first += n.count;
+      n.count = 0;
+    }
+    sorted.resize(entries.size());
+    for (const Entry &e : entries) {
+      Node &n = nodes[e.node];
+      sorted[n.first + n.count++] = e;
+    }
+  }
+
+  /// @brief Call func(entry) for every object whose bounds overlap bounds.
+  /// Returning false from func stops the query.
+  template <typename F> void Query(const Bounds &bounds, F &&func) const {
+    QueryEntries(bounds, [&](int index) { return func(sorted[index]); });
+  }
+
+  /// @brief Call func(a, b) once for every pair of objects whose bounds
+  /// overlap
+  template <typename F> void OperateOnPairs(F &&func) const {
+    for (int i = 0; i < (int)sorted.size(); ++i) {
+      QueryEntries(sorted[i].bounds, [&](int other) {
+        if (other > i) {
+          func(sorted[i].object, sorted[other].object);
+        }
+        return true;
+      });
+    }
+  }
+
+  size_t GetEntryCount() const { return sorted.size(); }
+  size_t GetNodeCount() const { return nodes.size(); }
+
+protected:
+  struct Node {
+    Bounds looseBounds;
+    int children[8];
+    int parent;
+    int depth;
+    int x, y, z;
+
+    // Where this node's entries start in sorted, and how many there are
+    int first = 0;
+    int count = 0;
+    // Including every node below this one
+    int subtreeCount = 0;
+  };
+
+  Node MakeNode(int depth, int x, int y, int z, int parent) const {
+    Node n;
+    float cellSize = rootSize / (float)(1 << depth);
+    Vector3 cellMin =
+        rootMin + Vector3((float)x, (float)y, (float)z) * cellSize;
+    float half = cellSize * 0.5f;
+    n.looseBounds = Bounds(cellMin - Vector3(half, half, half),
+                           cellMin + Vector3(cellSize + half, cellSize + half,
+                                             cellSize + half));
+    std::fill(std::begin(n.children), std::end(n.children), NullNode);
+    n.parent = parent;
+    n.depth = depth;
+    n.x = x;
+    n.y = y;
+    n.z = z;
+    return n;
+  }
+
+  int NodeFor(const Bounds &bounds) {
+    // Deepest depth whose cells are still as big as the object
+    float size = Vector::GetMaxElement(bounds.max - bounds.min);
+    int depth = maxDepth;
+    if (size > 0.0f) {
+      depth = std::clamp((int)std::floor(std::log2(rootSize / size)), 0,
+                         maxDepth);
+    }
+
+    int cells = 1 << depth;
+    Vector3 cell = (bounds.Centre() - rootMin) * ((float)cells / rootSize);
+    int x = std::clamp((int)cell.x, 0, cells - 1);
+    int y = std::clamp((int)cell.y, 0, cells - 1);
+    int z = std::clamp((int)cell.z, 0, cells - 1);
+
+    int node = 0;
+    for (int d = 1; d <= depth; ++d) {
+      int shift = depth - d;
+      int cx = x >> shift;
+      int cy = y >> shift;
+      int cz = z >> shift;
+      int octant = (cx & 1) | ((cy & 1) << 1) | ((cz & 1) << 2);
+
+      int child = nodes[node].children[octant];
+      if (child == NullNode) {
+        child = (int)nodes.size();
+        nodes.push_back(MakeNode(d, cx, cy, cz, node));
+        nodes[node].children[octant] = child;
+      }
+      node = child;
+    }
+    ++nodes[node].subtreeCount;
+    return node;
+  }
+
+  template <typename F>
+  void QueryEntries(const Bounds &bounds, F &&func) const {
+    if (nodes.empty()) {
+      return;
+    }
+
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty()) {
+      const Node &node = nodes[stack.back()];
+      stack.pop_back();
+      if (node.subtreeCount == 0 || !node.looseBounds.Overlaps(bounds)) {
+        continue;
+      }
+
+      for (int i = node.first; i < node.first + node.count; ++i) {
+        if (sorted[i].bounds.Overlaps(bounds) && !func(i)) {
+          return;
+        }
+      }
+      for (int child : node.children) {
+        if (child != NullNode) {
+          stack.push_back(child);
+        }
+      }
+    }
+  }
+
+  int maxDepth;
+  float rootSize = 1.0f;
+  Vector3 rootMin;
+
+  std::vector<Entry> entries;
+  std::vector<Entry> sorted;
+  std::vector<Node> nodes;
+  mutable std::vector<int> stack;
+};
+} // namespace CSC8503
+} // namespace NCL
@@ -10,8 +10,10 @@ public:
   }
   ~OBBVolume() = default;
 
+  // As far as the corners reach, anything less and the quick distance check
+  // in ObjectIntersection throws away boxes touching corner first
   float GetMaxExtent() const override {
-    return Maths::Vector::GetAbsMaxElement(halfSizes) * 1.4f;
+    return Maths::Vector::Length(halfSizes);
   }
 
   Maths::Vector3 GetHalfDimensions() const { return halfSizes; }
@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace NCL {
+namespace CSC8503 {
+/*
+Flat hash map from a pair of object IDs to some per-pair data.
+
+Values are kept packed together in one array, so walking over every pair is a
+straight run through memory, and a small open addressed table of indices into
+that array gives O(1) lookup. Erasing moves the last value into the gap, so
+the array stays packed, but the order values are stored in is not kept.
+
+Keys are unordered pairs, so (a, b) and (b, a) are the same pair.
+*/
+template <class V> class PairCache {
+public:
+  using Key = uint64_t;
+
+  struct Entry {
+    Key key;
+    V value;
+  };
+
+  PairCache() = default;
+  ~PairCache() = default;
+
+  static Key MakeKey(int a, int b) {
+    if (a > b) {
+      std::swap(a, b);
+    }
+    return ((Key)(uint32_t)a << 32) | (Key)(uint32_t)b;
+  }
+
+  V *Find(Key key) {
+    if (entries.empty()) {
+      return nullptr;
+    }
+    size_t slot = FindSlot(key);
+    return table[slot] == Empty ? nullptr : &entries[table[slot]].value;
+  }
+
+  const V *Find(Key key) const {
+    return const_cast<PairCache *>(this)->Find(key);
+  }
+
+  /// @brief Find the value for a key, adding a default one if there isn't one
+  /// @return the value, and whether it was just added
+  std::pair<V &, bool> Insert(Key key) {
+    if ((entries.size() + 1) * 2 > table.size()) {
+      Rehash(table.empty() ? 64 : table.size() * 2);
+    }
+
+    size_t slot = FindSlot(key);
+    if (table[slot] != Empty) {
+      return {entries[table[slot]].value, false};
+    }
+
+    table[slot] = (int)entries.size();
+    entries.push_back({key, V()});
+    return {entries.back().value, true};
+  }
+
+  bool Erase(Key key) {
+    if (entries.empty()) {
+      return false;
+    }
+    size_t slot = FindSlot(key);
+    if (table[slot] == Empty) {
+      return false;
+    }
+    EraseSlot(slot);
+    return true;
+  }
+
+  /// @brief Erase every pair that pred(key, value) returns true for
+  template <typename F> void EraseIf(F &&pred) {
+    for (size_t i = 0; i < entries.size();) {
+      if (pred(entries[i].key, entries[i].value)) {
+        // The last entry is moved into i, so look at i again
+        EraseSlot(FindSlot(entries[i].key));
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  void Clear() {
+    entries.clear();
+    std::fill(table.begin(), table.end(), Empty);
+  }
+
+  size_t Size() const { return entries.size(); }
+  bool IsEmpty() const { return entries.empty(); }
+
+  typename std::vector<Entry>::iterator begin() { return entries.begin(); }
+  typename std::vector<Entry>::iterator end() { return entries.end(); }
+  typename std::vector<Entry>::const_iterator begin() const {
+    return entries.begin();
+  }
+  typename std::vector<Entry>::const_iterator end() const {
+    return entries.end();
+  }
+
+protected:
+  static constexpr int Empty = -1;
+
+  static size_t Hash(Key key) {
+    // splitmix64 finaliser, IDs are sequential so need spreading out
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return (size_t)key;
+  }
+
+  // Slot holding key, or the empty slot it would go in
+  size_t FindSlot(Key key) const {
+    size_t mask = table.size() - 1;
+    size_t slot = Hash(key) & mask;
+    while (table[slot] != Empty && entries[table[slot]].key != key) {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void EraseSlot(size_t slot) {
+    int index = table[slot];
+    int last = (int)entries.size() - 1;
+
+    if (index != last) {
+      // Point whichever slot refers to the last entry at its new home
+      table[FindSlot(entries[last].key)] = index;
+      entries[index] = std::move(entries[last]);
+    }
+    entries.pop_back();
+
+    // Shift back any entries that probed past this slot, so lookups never
+    // need tombstones
+    size_t mask = table.size() - 1;
+    size_t hole = slot;
+    size_t next = (slot + 1) & mask;
+    while (table[next] != Empty) {
+      size_t home = Hash(entries[table[next]].key) & mask;
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        table[hole] = table[next];
+        hole = next;
+      }
+      next = (next + 1) & mask;
+    }
+    table[hole] = Empty;
+  }
+
+  void Rehash(size_t size) {
+    assert((size & (size - 1)) == 0);
+    table.assign(size, Empty);
+    for (int i = 0; i < (int)entries.size(); ++i) {
+      table[FindSlot(entries[i].key)] = i;
+    }
+  }
+
+  std::vector<Entry> entries;
+  std::vector<int> table;
+};
+} // namespace CSC8503
+} // namespace NCL
@@ -1,2 +0,0 @@
-#include "QuadTree.h"
-using namespace NCL;
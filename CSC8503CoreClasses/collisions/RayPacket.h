@@ -0,0 +1,295 @@
+#pragma once
+#include "Bounds.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+#include <cfloat>
+#include <cmath>
+
+#include "Ray.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYPACKET_SSE
+#include <emmintrin.h>
+#endif
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+/*
+Four rays stored a component per array, so they can all be tested against the
+same box or sphere at once, a ray per SIMD lane. Which lanes are in play is
+passed around as a bit mask, lane i being bit i, and lanes outside the mask
+can hold anything.
+
+The volume tests give the same answers as the single ray ones in
+CollisionDetection, just four at a time.
+*/
+struct RayPacket {
+  static constexpr int Lanes = 4;
+  static constexpr int AllLanes = (1 << Lanes) - 1;
+
+  alignas(16) float originX[Lanes] = {};
+  alignas(16) float originY[Lanes] = {};
+  alignas(16) float originZ[Lanes] = {};
+  alignas(16) float dirX[Lanes] = {};
+  alignas(16) float dirY[Lanes] = {};
+  alignas(16) float dirZ[Lanes] = {};
+  alignas(16) float invDirX[Lanes] = {};
+  alignas(16) float invDirY[Lanes] = {};
+  alignas(16) float invDirZ[Lanes] = {};
+
+  void Set(int lane, const Vector3 &origin, const Vector3 &direction) {
+    originX[lane] = origin.x;
+    originY[lane] = origin.y;
+    originZ[lane] = origin.z;
+    dirX[lane] = direction.x;
+    dirY[lane] = direction.y;
+    dirZ[lane] = direction.z;
+    invDirX[lane] = 1.0f / direction.x;
+    invDirY[lane] = 1.0f / direction.y;
+    invDirZ[lane] = 1.0f / direction.z;
+  }
+  void Set(int lane, const Ray &r) {
+    Set(lane, r.GetPosition(), r.GetDirection());
+  }
+
+  Vector3 GetOrigin(int lane) const {
+    return Vector3(originX[lane], originY[lane], originZ[lane]);
+  }
+  Vector3 GetDirection(int lane) const {
+    return Vector3(dirX[lane], dirY[lane], dirZ[lane]);
+  }
+  Ray GetRay(int lane) const {
+    return Ray(GetOrigin(lane), GetDirection(lane));
+  }
+
+  /// @brief Where a lane's ray is after distance along it
+  Vector3 GetPoint(int lane, float distance) const {
+    return GetOrigin(lane) + GetDirection(lane) * distance;
+  }
+
+  /// @brief The same rays in a local space, moved by -offset and then
+  /// rotated by m
+  RayPacket Transformed(const Matrix3 &m, const Vector3 &offset) const {
+    RayPacket local;
+    for (int i = 0; i < Lanes; ++i) {
+      local.Set(i, m * (GetOrigin(i) - offset), m * GetDirection(i));
+    }
+    return local;
+  }
+
+  /// @brief Which lanes in mask have rays that enter the bounds before their
+  /// max distance, and where they enter, the same as Bounds::RayEntry
+  int Entry(const Bounds &b, int mask, const float maxDistance[Lanes],
+            float entry[Lanes]) const;
+
+  /// @brief Which lanes in mask hit the box, and how far along, the same as
+  /// CollisionDetection::RayBoxIntersection
+  int IntersectBox(const Vector3 &centre, const Vector3 &halfSize, int mask,
+                   float distance[Lanes]) const;
+
+  /// @brief Which lanes in mask hit the sphere, and how far along, the same
+  /// as CollisionDetection::RaySphereIntersection
+  int IntersectSphere(const Vector3 &centre, float radius, int mask,
+                      float distance[Lanes]) const;
+};
+
+#ifdef RAYPACKET_SSE
+inline int RayPacket::Entry(const Bounds &b, int mask,
+                            const float maxDistance[Lanes],
+                            float entry[Lanes]) const {
+  __m128 tMin = _mm_setzero_ps();
+  __m128 tMax = _mm_loadu_ps(maxDistance);
+  __m128 miss = _mm_setzero_ps();
+  const __m128 signBit = _mm_set1_ps(-0.0f);
+  const __m128 infinity = _mm_set1_ps(INFINITY);
+
+  auto slab = [&](const float *origin, const float *invDir, float min,
+                  float max) {
+    __m128 o = _mm_load_ps(origin);
+    __m128 inv = _mm_load_ps(invDir);
+    __m128 lo = _mm_set1_ps(min);
+    __m128 hi = _mm_set1_ps(max);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(lo, o), inv);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(hi, o), inv);
+    // Lanes parallel to the slab keep what they had, and miss outright if
+    // they're outside it, as in Bounds::RayEntry
+    __m128 parallel = _mm_cmpeq_ps(_mm_andnot_ps(signBit, inv), infinity);
+    __m128 outside = _mm_or_ps(_mm_cmplt_ps(o, lo), _mm_cmpgt_ps(o, hi));
+    miss = _mm_or_ps(miss, _mm_and_ps(parallel, outside));
+    tMin = _mm_or_ps(_mm_and_ps(parallel, tMin),
+                     _mm_andnot_ps(parallel,
+                                   _mm_max_ps(_mm_min_ps(t1, t2), tMin)));
+    tMax = _mm_or_ps(_mm_and_ps(parallel, tMax),
+                     _mm_andnot_ps(parallel,
+                                   _mm_min_ps(_mm_max_ps(t1, t2), tMax)));
+  };
+  slab(originX, invDirX, b.min.x, b.max.x);
+  slab(originY, invDirY, b.min.y, b.max.y);
+  slab(originZ, invDirZ, b.min.z, b.max.z);
+
+  _mm_storeu_ps(entry, tMin);
+  return _mm_movemask_ps(_mm_andnot_ps(miss, _mm_cmple_ps(tMin, tMax))) &
+         mask;
+}
+
+inline int RayPacket::IntersectBox(const Vector3 &centre,
+                                   const Vector3 &halfSize, int mask,
+                                   float distance[Lanes]) const {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 none = _mm_set1_ps(-1.0f);
+
+  // Only the side facing each ray can be where it goes in
+  auto entry = [&](const float *origin, const float *dir, float c, float h) {
+    __m128 o = _mm_load_ps(origin);
+    __m128 d = _mm_load_ps(dir);
+    __m128 toMin = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(c - h), o), d);
+    __m128 toMax = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(c + h), o), d);
+    __m128 positive = _mm_cmpgt_ps(d, zero);
+    __m128 negative = _mm_cmplt_ps(d, zero);
+    return _mm_or_ps(
+        _mm_or_ps(_mm_and_ps(positive, toMin), _mm_and_ps(negative, toMax)),
+        _mm_andnot_ps(_mm_or_ps(positive, negative), none));
+  };
+  __m128 best = _mm_max_ps(
+      _mm_max_ps(entry(originX, dirX, centre.x, halfSize.x),
+                 entry(originY, dirY, centre.y, halfSize.y)),
+      entry(originZ, dirZ, centre.z, halfSize.z));
+  __m128 hit = _mm_cmpge_ps(best, zero);
+
+  constexpr float bias = 0.0001f;
+  auto inside = [&](const float *origin, const float *dir, float c, float h) {
+    __m128 p = _mm_add_ps(_mm_load_ps(origin),
+                          _mm_mul_ps(_mm_load_ps(dir), best));
+    return _mm_and_ps(_mm_cmpge_ps(p, _mm_set1_ps((c - h) - bias)),
+                      _mm_cmple_ps(p, _mm_set1_ps((c + h) + bias)));
+  };
+  hit = _mm_and_ps(hit, inside(originX, dirX, centre.x, halfSize.x));
+  hit = _mm_and_ps(hit, inside(originY, dirY, centre.y, halfSize.y));
+  hit = _mm_and_ps(hit, inside(originZ, dirZ, centre.z, halfSize.z));
+
+  _mm_storeu_ps(distance, best);
+  return _mm_movemask_ps(hit) & mask;
+}
+
+inline int RayPacket::IntersectSphere(const Vector3 &centre, float radius,
+                                      int mask, float distance[Lanes]) const {
+  __m128 ox = _mm_load_ps(originX);
+  __m128 oy = _mm_load_ps(originY);
+  __m128 oz = _mm_load_ps(originZ);
+  __m128 dx = _mm_load_ps(dirX);
+  __m128 dy = _mm_load_ps(dirY);
+  __m128 dz = _mm_load_ps(dirZ);
+
+  __m128 cx = _mm_set1_ps(centre.x);
+  __m128 cy = _mm_set1_ps(centre.y);
+  __m128 cz = _mm_set1_ps(centre.z);
+
+  // How far along each ray it gets closest to the centre
+  __m128 proj = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(_mm_sub_ps(cx, ox), dx),
+                 _mm_mul_ps(_mm_sub_ps(cy, oy), dy)),
+      _mm_mul_ps(_mm_sub_ps(cz, oz), dz));
+
+  __m128 ex = _mm_sub_ps(cx, _mm_add_ps(ox, _mm_mul_ps(dx, proj)));
+  __m128 ey = _mm_sub_ps(cy, _mm_add_ps(oy, _mm_mul_ps(dy, proj)));
+  __m128 ez = _mm_sub_ps(cz, _mm_add_ps(oz, _mm_mul_ps(dz, proj)));
+  __m128 distSq =
+      _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)),
+                 _mm_mul_ps(ez, ez));
+
+  __m128 radiusSq = _mm_set1_ps(radius * radius);
+  __m128 hit = _mm_and_ps(_mm_cmpge_ps(proj, _mm_setzero_ps()),
+                          _mm_cmple_ps(distSq, radiusSq));
+
+  // Misses can have a negative under the root, keep them out of it
+  __m128 offset =
+      _mm_sqrt_ps(_mm_and_ps(hit, _mm_sub_ps(radiusSq, distSq)));
+  _mm_storeu_ps(distance, _mm_sub_ps(proj, offset));
+  return _mm_movemask_ps(hit) & mask;
+}
+#else
+inline int RayPacket::Entry(const Bounds &b, int mask,
+                            const float maxDistance[Lanes],
+                            float entry[Lanes]) const {
+  int hits = 0;
+  for (int i = 0; i < Lanes; ++i) {
+    if ((mask & (1 << i)) &&
+        b.RayEntry(GetOrigin(i), Vector3(invDirX[i], invDirY[i], invDirZ[i]),
+                   maxDistance[i], entry[i])) {
+      hits |= 1 << i;
+    }
+  }
+  return hits;
+}
+
+inline int RayPacket::IntersectBox(const Vector3 &centre,
+                                   const Vector3 &halfSize, int mask,
+                                   float distance[Lanes]) const {
+  Vector3 boxMin = centre - halfSize;
+  Vector3 boxMax = centre + halfSize;
+  constexpr float bias = 0.0001f;
+
+  int hits = 0;
+  for (int i = 0; i < Lanes; ++i) {
+    if (!(mask & (1 << i))) {
+      continue;
+    }
+    Vector3 o = GetOrigin(i);
+    Vector3 d = GetDirection(i);
+
+    Vector3 t(-1.0f, -1.0f, -1.0f);
+    for (int a = 0; a < 3; ++a) {
+      if (d[a] > 0.0f) {
+        t[a] = (boxMin[a] - o[a]) / d[a];
+      } else if (d[a] < 0.0f) {
+        t[a] = (boxMax[a] - o[a]) / d[a];
+      }
+    }
+    float best = Vector::GetMaxElement(t);
+    if (best < 0.0f) {
+      continue;
+    }
+
+    Vector3 p = o + d * best;
+    bool inside = true;
+    for (int a = 0; a < 3; ++a) {
+      inside &= p[a] >= boxMin[a] - bias && p[a] <= boxMax[a] + bias;
+    }
+    if (inside) {
+      distance[i] = best;
+      hits |= 1 << i;
+    }
+  }
+  return hits;
+}
+
+inline int RayPacket::IntersectSphere(const Vector3 &centre, float radius,
+                                      int mask, float distance[Lanes]) const {
+  int hits = 0;
+  for (int i = 0; i < Lanes; ++i) {
+    if (!(mask & (1 << i))) {
+      continue;
+    }
+    Vector3 o = GetOrigin(i);
+    Vector3 d = GetDirection(i);
+
+    float proj = Vector::Dot(centre - o, d);
+    if (proj < 0.0f) {
+      continue;
+    }
+    Vector3 closest = o + d * proj;
+    float distSq = Vector::Dot(centre - closest, centre - closest);
+    if (distSq > radius * radius) {
+      continue;
+    }
+    distance[i] = proj - std::sqrt(radius * radius - distSq);
+    hits |= 1 << i;
+  }
+  return hits;
+}
+#endif
+} // namespace CSC8503
+} // namespace NCL
@@ -0,0 +1,258 @@
+#pragma once
+#include "Bounds.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+/*
+Sort and sweep broadphase, that keeps its endpoints sorted between frames.
+
+Every proxy has a min and max endpoint along a single sweep axis. Objects
+rarely move far in a single step, so last step's order is nearly sorted
+already, and an insertion sort gets it back in order in O(n + swaps) rather
+than the O(n log n) of sorting from scratch.
+
+The sweep axis is picked by whichever one the proxies are most spread out
+along, and is reconsidered every so often, as a level that runs along x
+would otherwise have most of it overlapping on z.
+*/
+template <class T> class SweepAndPrune {
+public:
+  static constexpr int NullProxy = -1;
+
+  SweepAndPrune(int axisCheckInterval = 60)
+      : axisCheckInterval(axisCheckInterval) {}
+  ~SweepAndPrune() = default;
+
+  int Insert(T object, const Bounds &bounds) {
+    int proxy;
+    if (freeList != NullProxy) {
+      proxy = freeList;
+      freeList = proxies[proxy].nextFree;
+    } else {
+      proxy = (int)proxies.size();
+      proxies.emplace_back();
+    }
+
+    Proxy &p = proxies[proxy];
+    p.bounds = bounds;
+    p.object = object;
+    p.nextFree = NullProxy;
+    p.active = true;
+
+    // New endpoints go on the end, and get sorted into place next update
+    endpoints.push_back({bounds.min[axis], Endpoint::Pack(proxy, true)});
+    endpoints.push_back({bounds.max[axis], Endpoint::Pack(proxy, false)});
+
+    ++proxyCount;
+    return proxy;
+  }
+
+  void Remove(int proxy) {
+    assert(proxy >= 0 && proxy < (int)proxies.size() && proxies[proxy].active);
+
+    std::erase_if(endpoints, [proxy](const Endpoint &e) {
+      return e.GetProxy() == proxy;
+    });
+
+    Proxy &p = proxies[proxy];
+    p.active = false;
+    p.object = {};
+    p.nextFree = freeList;
+    freeList = proxy;
+
+    --proxyCount;
+  }
+
+  void Move(int proxy, const Bounds &bounds) {
+    assert(proxy >= 0 && proxy < (int)proxies.size() && proxies[proxy].active);
+    proxies[proxy].bounds = bounds;
+  }
+
+  /// @brief Pull the latest bounds into the endpoints and re-sort them
+  void Update() {
+    if (++updatesSinceAxisCheck >= axisCheckInterval) {
+      updatesSinceAxisCheck = 0;
+      int best = PickAxis();
+      if (best != axis) {
+        axis = best;
+        RefreshEndpoints();
+        // Order along a new axis has nothing to do with the old one
+        std::sort(endpoints.begin(), endpoints.end());
+        lastSwapCount = 0;
+        return;
+      }
+    }
+
+    RefreshEndpoints();
+    InsertionSort();
+  }
+
+  /// @brief Call func(a, b) once for every pair of objects whose bounds
+  /// overlap, as of the last Update
+  template <typename F> void OperateOnPairs(F &&func) {
+    open.clear();
+
+    for (const Endpoint &e : endpoints) {
+      int proxy = e.GetProxy();
+
+      if (!e.IsMin()) {
+        auto it = std::find(open.begin(), open.end(), proxy);
+        *it = open.back();
+        open.pop_back();
+        continue;
+      }
+
+      const Proxy &p = proxies[proxy];
+      for (int other : open) {
+        const Proxy &o = proxies[other];
+        if (p.bounds.Overlaps(o.bounds)) {
+          func(o.object, p.object);
+        }
+      }
+      open.push_back(proxy);
+    }
+  }
+
+  /// @brief Call func(object) for every proxy whose bounds overlap the given
+  /// bounds, as of the last Update. Returning false from func stops the query.
+  template <typename F> void Query(const Bounds &bounds, F &&func) const {
+    // Anything whose min endpoint is past the end of the bounds along the
+    // sweep axis can't overlap them, and neither can anything after it
+    for (const Endpoint &e : endpoints) {
+      if (e.value > bounds.max[axis]) {
+        return;
+      }
+      if (!e.IsMin()) {
+        continue;
+      }
+      const Proxy &p = proxies[e.GetProxy()];
+      if (p.bounds.Overlaps(bounds) && !func(p.object)) {
+        return;
+      }
+    }
+  }
+
+  T &GetObject(int proxy) { return proxies[proxy].object; }
+  const T &GetObject(int proxy) const { return proxies[proxy].object; }
+
+  size_t GetProxyCount() const { return proxyCount; }
+  int GetAxis() const { return axis; }
+
+  /// @brief How many swaps the last incremental sort needed
+  size_t GetLastSwapCount() const { return lastSwapCount; }
+
+  void Clear() {
+    proxies.clear();
+    endpoints.clear();
+    open.clear();
+    freeList = NullProxy;
+    proxyCount = 0;
+    axis = 0;
+    updatesSinceAxisCheck = 0;
+    lastSwapCount = 0;
+  }
+
+protected:
+  struct Proxy {
+    Bounds bounds;
+    T object = {};
+    int nextFree = NullProxy;
+    bool active = false;
+  };
+
+  // Proxy index and min / max flag packed together, to keep the array small
+  struct Endpoint {
+    float value;
+    unsigned int data;
+
+    static unsigned int Pack(int proxy, bool isMin) {
+      return ((unsigned int)proxy << 1) | (isMin ? 0u : 1u);
+    }
+
+    int GetProxy() const { return (int)(data >> 1); }
+    bool IsMin() const { return (data & 1) == 0; }
+
+    // Mins sort before maxes at the same value, so touching boxes still
+    // count as overlapping, the same as Bounds::Overlaps
+    bool operator<(const Endpoint &other) const {
+      if (value != other.value) {
+        return value < other.value;
+      }
+      return (data & 1) < (other.data & 1);
+    }
+  };
+
+  void RefreshEndpoints() {
+    for (Endpoint &e : endpoints) {
+      const Bounds &b = proxies[e.GetProxy()].bounds;
+      e.value = e.IsMin() ? b.min[axis] : b.max[axis];
+    }
+  }
+
+  void InsertionSort() {
+    lastSwapCount = 0;
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+      Endpoint key = endpoints[i];
+      size_t j = i;
+      while (j > 0 && key < endpoints[j - 1]) {
+        endpoints[j] = endpoints[j - 1];
+        --j;
+      }
+      lastSwapCount += i - j;
+      endpoints[j] = key;
+    }
+  }
+
+  // The axis with the largest variance in proxy centres
+  int PickAxis() const {
+    if (proxyCount < 2) {
+      return axis;
+    }
+
+    Vector3 sum;
+    Vector3 sumSq;
+    for (const Proxy &p : proxies) {
+      if (!p.active) {
+        continue;
+      }
+      Vector3 c = p.bounds.Centre();
+      sum += c;
+      sumSq += c * c;
+    }
+
+    float n = (float)proxyCount;
+    Vector3 variance = sumSq / n - (sum / n) * (sum / n);
+
+    int best = 0;
+    for (int i = 1; i < 3; ++i) {
+      if (variance[i] > variance[best]) {
+        best = i;
+      }
+    }
+
+    // Don't flip between axes that are nearly as good as each other
+    if (variance[best] < variance[axis] * 1.25f) {
+      return axis;
+    }
+    return best;
+  }
+
+  std::vector<Proxy> proxies;
+  std::vector<Endpoint> endpoints;
+  std::vector<int> open;
+
+  int freeList = NullProxy;
+  size_t proxyCount = 0;
+
+  int axis = 0;
+  int axisCheckInterval;
+  int updatesSinceAxisCheck = 0;
+  size_t lastSwapCount = 0;
+};
+} // namespace CSC8503
+} // namespace NCL
@@ -0,0 +1,50 @@
+#include "Constraint.h"
+#include "GameObject.h"
+#include "physics/PhysicsObject.h"
+
+using namespace NCL;
+using namespace Maths;
+using namespace CSC8503;
+
+Vector3 Constraint::PositionOf(const GameObject *o) {
+  const PhysicsObject *phys = o->GetPhysicsObject();
+  return phys ? phys->GetPosition() : o->GetTransform().GetPosition();
+}
+
+Quaternion Constraint::OrientationOf(const GameObject *o) {
+  const PhysicsObject *phys = o->GetPhysicsObject();
+  return phys ? phys->GetOrientation() : o->GetTransform().GetOrientation();
+}
+
+/*
+XPBD finds how far to move each object by treating the error as the length of
+a spring with the constraint's compliance, scaled by the substep's length
+squared so it gives the same amount however many substeps there are. Each
+object then moves by its share of that, going by its inverse mass and, for a
+point off its centre, its inverse inertia about that point.
+
+With small enough substeps a single pass per substep is enough for a chain of
+them to settle, where solving velocities needs several passes a step.
+*/
+void Constraint::CorrectPositions(GameObject *a, const Vector3 &offsetA,
+                                  GameObject *b, const Vector3 &offsetB,
+                                  const Vector3 &normal, float error,
+                                  float dt) const {
+  PhysicsObject *physA = a ? a->GetPhysicsObject() : nullptr;
+  PhysicsObject *physB = b ? b->GetPhysicsObject() : nullptr;
+
+  float weightA = physA ? physA->GetInverseMassAt(offsetA, normal) : 0.0f;
+  float weightB = physB ? physB->GetInverseMassAt(offsetB, normal) : 0.0f;
+  float alpha = compliance / (dt * dt);
+  if (weightA + weightB + alpha <= 0.0f) {
+    return;
+  }
+
+  float lambda = -error / (weightA + weightB + alpha);
+  if (physA) {
+    physA->ApplyPositionImpulse(normal * lambda, offsetA, dt);
+  }
+  if (physB) {
+    physB->ApplyPositionImpulse(-normal * lambda, offsetB, dt);
+  }
+}
@@ -1,7 +1,11 @@
 #pragma once
+#include "Quaternion.h"
+#include "Vector.h"
 
 namespace NCL {
 namespace CSC8503 {
+class GameObject;
+
 class Constraint {
 public:
   Constraint() {}
@@ -9,13 +13,46 @@ public:
 
   virtual void UpdateConstraint(float dt) = 0;
 
+  /// @brief Whether the constraint can be solved on positions, for the
+  /// physics system's XPBD solver. Those that can't are still solved on
+  /// velocities with UpdateConstraint, whichever solver is in use
+  virtual bool HasPositionSolve() const { return false; }
+
+  /// @brief One XPBD pass, moving the objects straight to where the
+  /// constraint wants them, given how long the substep is
+  virtual void SolvePosition(float dt) {}
+
+  /// @brief The objects the constraint links, so the physics system can tell
+  /// which objects have to sleep and wake together
+  virtual GameObject *GetObjectA() const = 0;
+  virtual GameObject *GetObjectB() const = 0;
+
   bool IsActive() const { return active; }
   void SetActive(bool state) { active = state; }
   void activate() { active = true; }
   void deactivate() { active = false; }
 
+  /// @brief How far the constraint gives under force, the inverse of its
+  /// stiffness. Zero is rigid. Only the XPBD solver uses it
+  float GetCompliance() const { return compliance; }
+  void SetCompliance(float c) { compliance = c; }
+
 protected:
+  /// @brief Where the physics system has the object, which part way through
+  /// a step can be ahead of its Transform. Positions should be solved on these
+  static Maths::Vector3 PositionOf(const GameObject *o);
+  static Maths::Quaternion OrientationOf(const GameObject *o);
+
+  /// @brief Pulls a point on each object together along normal, which points
+  /// from B to A, to take out error, XPBD style. Either object can be given
+  /// as null, or without physics, and is then treated as immovable
+  void CorrectPositions(GameObject *a, const Maths::Vector3 &offsetA,
+                        GameObject *b, const Maths::Vector3 &offsetB,
+                        const Maths::Vector3 &normal, float error,
+                        float dt) const;
+
   bool active = true;
+  float compliance = 0.0f;
 };
 } // namespace CSC8503
-} // namespace NCL
\ No newline at end of file
+} // namespace NCL
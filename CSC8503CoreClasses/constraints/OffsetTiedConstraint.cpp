@@ -9,8 +9,8 @@ using namespace Maths;
 using namespace CSC8503;
 
 Vector3 OffsetTiedConstraint::Obj::GetOffsetPos() const {
-  auto pos = object->GetTransform().GetPosition();
-  auto rot = object->GetTransform().GetOrientation();
+  auto pos = PositionOf(object);
+  auto rot = OrientationOf(object);
 
   return pos + (rot * offset);
 }
@@ -63,3 +63,24 @@ void OffsetTiedConstraint::UpdateConstraint(float dt) {
   physA->ApplyAngularImpulse(Vector::Cross(localPosA, aJ));
   physB->ApplyAngularImpulse(Vector::Cross(localPosB, bJ));
 }
+
+// Pulling on the attachment points rather than the centres turns the objects
+// too, so a pane hangs level from its corners
+void OffsetTiedConstraint::SolvePosition(float dt) {
+  if (!active)
+    return;
+  auto offsetPosA = objectA.GetOffsetPos();
+  auto offsetPosB = objectB.GetOffsetPos();
+
+  auto relPos = offsetPosA - offsetPosB;
+
+  float currentDistance = Vector::Length(relPos);
+  float error = currentDistance - distance;
+  if (error <= 0.0f) {
+    return;
+  }
+
+  CorrectPositions(objectA.object, offsetPosA - PositionOf(objectA.object),
+                   objectB.object, offsetPosB - PositionOf(objectB.object),
+                   relPos / currentDistance, error, dt);
+}
@@ -20,6 +20,12 @@ public:
 
   void UpdateConstraint(float dt) override;
 
+  bool HasPositionSolve() const override { return true; }
+  void SolvePosition(float dt) override;
+
+  GameObject *GetObjectA() const override { return objectA.object; }
+  GameObject *GetObjectB() const override { return objectB.object; }
+
   void SetObjA(Obj a) { objectA = a; }
   void SetObjB(Obj b) { objectB = b; }
 
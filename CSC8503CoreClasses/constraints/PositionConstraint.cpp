@@ -51,3 +51,18 @@ void PositionConstraint::UpdateConstraint(float dt) {
   physA->ApplyLinearImpulse(aJ);
   physB->ApplyLinearImpulse(bJ);
 }
+
+// Unlike the tied constraint, this pushes apart as well as pulling together
+void PositionConstraint::SolvePosition(float dt) {
+  if (!active)
+    return;
+  auto relPos = PositionOf(objectA) - PositionOf(objectB);
+
+  float currentDistance = Vector::Length(relPos);
+  if (currentDistance <= 0.0f) {
+    return;
+  }
+
+  CorrectPositions(objectA, Vector3(), objectB, Vector3(),
+                   relPos / currentDistance, currentDistance - distance, dt);
+}
@@ -52,3 +52,18 @@ void TiedConstraint::UpdateConstraint(float dt) {
   physA->ApplyLinearImpulse(aJ);
   physB->ApplyLinearImpulse(bJ);
 }
+
+void TiedConstraint::SolvePosition(float dt) {
+  if (!active)
+    return;
+  auto relPos = PositionOf(objectA) - PositionOf(objectB);
+
+  float currentDistance = Vector::Length(relPos);
+  float error = currentDistance - distance;
+  if (error <= 0.0f) {
+    return;
+  }
+
+  CorrectPositions(objectA, Vector3(), objectB, Vector3(),
+                   relPos / currentDistance, error, dt);
+}
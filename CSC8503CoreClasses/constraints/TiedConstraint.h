@@ -12,6 +12,12 @@ public:
 
   void UpdateConstraint(float dt) override;
 
+  bool HasPositionSolve() const override { return true; }
+  void SolvePosition(float dt) override;
+
+  GameObject *GetObjectA() const override { return objectA; }
+  GameObject *GetObjectB() const override { return objectB; }
+
 protected:
   GameObject *objectA;
   GameObject *objectB;
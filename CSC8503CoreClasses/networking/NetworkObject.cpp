@@ -1,5 +1,6 @@
 #include "NetworkObject.h"
 #include "./enet/enet.h"
+#include "GameWorld.h"
 #include "VectorFormat.h"
 #include "physics/PhysicsObject.h"
 
@@ -14,29 +15,64 @@ NetworkObject::NetworkObject(GameObject &o, int id) : object(o) {
 
 NetworkObject::~NetworkObject() {}
 
-bool NetworkObject::ReadPacket(GamePacket &p) {
+bool NetworkObject::ReadPacket(GamePacket &p, GameWorld &world) {
   switch (p.type) {
   case static_cast<uint16_t>(BasicNetworkMessages::Delta_State): {
-    return ReadDeltaPacket(GamePacket::as<DeltaPacket>(p));
+    return ReadDeltaPacket(GamePacket::as<DeltaPacket>(p), world);
   }
   case static_cast<uint16_t>(BasicNetworkMessages::Full_State): {
-    return ReadFullPacket(GamePacket::as<FullPacket>(p));
+    return ReadFullPacket(GamePacket::as<FullPacket>(p), world);
   }
   default:
     return false;
   }
 }
 
-bool NetworkObject::WritePacket(GamePacket **p, bool deltaFrame, int stateID) {
-  if (deltaFrame) {
-    if (!WriteDeltaPacket(p, stateID)) {
-      return WriteFullPacket(p);
-    }
+bool NetworkObject::WritePacket(GamePacket **p, bool deltaFrame, int stateID,
+                                int clientID, const GameWorld &world) {
+  ClientBaseline &baseline = clientBaselines[clientID];
+  uint32_t generation = world.GetPhysicsState(object).generation;
+  if (deltaFrame && baseline.ackedGeneration == generation) {
+    // Not moved since a full state this client has acked
+    return false;
+  }
+
+  if (deltaFrame && WriteDeltaPacket(p, stateID, world)) {
+    return true;
+  }
+
+  // Full states can be lost, so it isn't this client's baseline until acked
+  int fullID = lastFullState.stateID;
+  WriteFullPacket(p, world);
+  if (baseline.pending.size() >= MaxPendingStates) {
+    baseline.pending.erase(baseline.pending.begin());
+  }
+  baseline.pending.emplace_back(fullID, generation);
+  return true;
+}
+
+void NetworkObject::OnStateAcked(int clientID, int stateID) {
+  auto found = clientBaselines.find(clientID);
+  if (found == clientBaselines.end()) {
+    return;
+  }
+  ClientBaseline &baseline = found->second;
+  auto acked = std::find_if(
+      baseline.pending.begin(), baseline.pending.end(),
+      [stateID](const auto &pending) { return pending.first == stateID; });
+  if (acked == baseline.pending.end()) {
+    return;
   }
-  return WriteFullPacket(p);
+  // Anything sent before it is either lost or out of date now
+  baseline.ackedGeneration = acked->second;
+  baseline.pending.erase(baseline.pending.begin(), acked + 1);
+}
+
+void NetworkObject::RemoveClient(int clientID) {
+  clientBaselines.erase(clientID);
 }
 // Client objects recieve these packets
-bool NetworkObject::ReadDeltaPacket(DeltaPacket &p) {
+bool NetworkObject::ReadDeltaPacket(DeltaPacket &p, GameWorld &world) {
   if (p.objectID != networkID)
     return false;
 
@@ -63,12 +99,12 @@ bool NetworkObject::ReadDeltaPacket(DeltaPacket &p) {
   fullRot.z += (float)(p.orientation[2] * inv127);
   fullRot.w += (float)(p.orientation[3] * inv127);
 
-  object.GetTransform().SetPosition(fullPos).SetOrientation(fullRot);
+  MoveTo(world, fullPos, fullRot);
 
   return true;
 }
 
-bool NetworkObject::ReadFullPacket(FullPacket &p) {
+bool NetworkObject::ReadFullPacket(FullPacket &p, GameWorld &world) {
   if (p.objectID != networkID)
     return false;
 
@@ -82,15 +118,8 @@ bool NetworkObject::ReadFullPacket(FullPacket &p) {
 
   lastFullState = p.fullState;
 
-  object.GetTransform()
-      .SetPosition(lastFullState.position)
-      .SetOrientation(lastFullState.orientation);
-
-  PhysicsObject *phys = object.GetPhysicsObject();
-
-  if (phys) {
-    phys->SetLinearVelocity(lastFullState.velocity);
-  }
+  MoveTo(world, lastFullState.position, lastFullState.orientation,
+         lastFullState.velocity);
 
   stateHistory.push_back(lastFullState);
 
@@ -105,7 +134,8 @@ bool NetworkObject::ReadFullPacket(FullPacket &p) {
   return true;
 }
 
-bool NetworkObject::WriteDeltaPacket(GamePacket **p, int stateID) {
+bool NetworkObject::WriteDeltaPacket(GamePacket **p, int stateID,
+                                     const GameWorld &world) {
   DeltaPacket d = DeltaPacket();
 
   NetworkState state;
@@ -115,8 +145,9 @@ bool NetworkObject::WriteDeltaPacket(GamePacket **p, int stateID) {
   d.fullID = stateID;
   d.objectID = networkID;
 
-  auto currPos = object.GetTransform().GetPosition() - state.position;
-  auto currRot = object.GetTransform().GetOrientation() - state.orientation;
+  PhysicsState current = world.GetPhysicsState(object);
+  auto currPos = current.position - state.position;
+  auto currRot = current.orientation - state.orientation;
 
   d.pos[0] = (char)(currPos.x);
   d.pos[1] = (char)(currPos.y);
@@ -131,21 +162,17 @@ bool NetworkObject::WriteDeltaPacket(GamePacket **p, int stateID) {
   return true;
 }
 
-bool NetworkObject::WriteFullPacket(GamePacket **p) {
+bool NetworkObject::WriteFullPacket(GamePacket **p, const GameWorld &world) {
   // Is it faster to create on stack and copy over, or new directly and indirect
   // every write?
   FullPacket f = FullPacket();
 
   f.objectID = networkID;
-  f.fullState.position = object.GetTransform().GetPosition();
-  f.fullState.orientation = object.GetTransform().GetOrientation();
-
-  PhysicsObject *phys = object.GetPhysicsObject();
-  if (phys) {
-    f.fullState.velocity = phys->GetLinearVelocity();
-  } else {
-    f.fullState.velocity = {};
-  }
+  PhysicsState current = world.GetPhysicsState(object);
+  f.fullState.position = current.position;
+  f.fullState.orientation = current.orientation;
+  // Zero for anything without physics
+  f.fullState.velocity = current.linearVelocity;
 
   f.fullState.stateID = lastFullState.stateID++;
 
@@ -153,6 +180,23 @@ bool NetworkObject::WriteFullPacket(GamePacket **p) {
   return true;
 }
 
+void NetworkObject::MoveTo(GameWorld &world, const Vector3 &position,
+                           const Quaternion &orientation,
+                           std::optional<Vector3> velocity) {
+  if (!object.GetPhysicsObject()) {
+    // Physics never moves it, so only needs the world locked
+    auto lock = world.LockWorld();
+    object.GetTransform().SetPosition(position).SetOrientation(orientation);
+    return;
+  }
+
+  world.ChangePhysics(object, PhysicsCommands::SetPosition{position});
+  world.ChangePhysics(object, PhysicsCommands::SetOrientation{orientation});
+  if (velocity) {
+    world.ChangePhysics(object, PhysicsCommands::SetLinearVelocity{*velocity});
+  }
+}
+
 NetworkState &NetworkObject::GetLatestNetworkState() { return lastFullState; }
 
 bool NetworkObject::GetNetworkState(int stateID, NetworkState &state) {
@@ -5,8 +5,11 @@
 #include "logging/logger.h"
 #include "networking/packets.h"
 
+#include <map>
+
 namespace NCL::CSC8503 {
 class GameObject;
+class GameWorld;
 
 class NetworkObject {
 public:
@@ -14,12 +17,21 @@ public:
   virtual ~NetworkObject();
 
   // Called by clients
-  virtual bool ReadPacket(GamePacket &p);
-  // Called by servers
-  virtual bool WritePacket(GamePacket **p, bool deltaFrame, int stateID);
+  virtual bool ReadPacket(GamePacket &p, GameWorld &world);
+  // Called by servers, once for each client
+  virtual bool WritePacket(GamePacket **p, bool deltaFrame, int stateID,
+                           int clientID, const GameWorld &world);
+
+  /// @brief A client has received one of the full states sent to it, so it
+  /// has the object as it was then
+  void OnStateAcked(int clientID, int stateID);
+  /// @brief Forget everything sent to a client that's gone
+  void RemoveClient(int clientID);
 
   void UpdateStateHistory(int minID);
 
+  int GetNetworkID() const { return networkID; }
+
   static inline bool wantsPacket(GamePacket &packet) {
     return packet.type == BasicNetworkMessages::Delta_State ||
            packet.type == BasicNetworkMessages::Full_State;
@@ -33,11 +45,18 @@ protected:
 
   bool GetNetworkState(int frameID, NetworkState &state);
 
-  virtual bool ReadDeltaPacket(DeltaPacket &p);
-  virtual bool ReadFullPacket(FullPacket &p);
+  virtual bool ReadDeltaPacket(DeltaPacket &p, GameWorld &world);
+  virtual bool ReadFullPacket(FullPacket &p, GameWorld &world);
 
-  virtual bool WriteDeltaPacket(GamePacket **p, int stateID);
-  virtual bool WriteFullPacket(GamePacket **p);
+  virtual bool WriteDeltaPacket(GamePacket **p, int stateID,
+                                const GameWorld &world);
+  virtual bool WriteFullPacket(GamePacket **p, const GameWorld &world);
+
+  /// @brief Puts the object where the server says it is, through physics if
+  /// it has any
+  void MoveTo(GameWorld &world, const Vector3 &position,
+              const Quaternion &orientation,
+              std::optional<Vector3> velocity = std::nullopt);
 
   GameObject &object;
 
@@ -49,5 +68,20 @@ protected:
   int fullErrors;
 
   int networkID;
+
+  /*
+  Every client is sent its own full states, and might not get them, so
+  each one has its own idea of where the object is. A client that's acked
+  a full state from the object's current transform generation already has
+  it, and can be skipped on delta frames.
+  */
+  struct ClientBaseline {
+    std::optional<uint32_t> ackedGeneration;
+    // State ID and transform generation of each full state not yet acked
+    std::vector<std::pair<int, uint32_t>> pending;
+  };
+  static constexpr size_t MaxPendingStates = 32;
+
+  std::map<int, ClientBaseline> clientBaselines;
 };
 } // namespace NCL::CSC8503
\ No newline at end of file
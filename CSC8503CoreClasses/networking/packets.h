@@ -66,11 +66,13 @@ struct ClientPacket : public GamePacket {
 
 struct AckPacket : public GamePacket {
   int receivedID;
+  // The network object the state was for
+  int objectID;
   AckPacket() = delete;
-  AckPacket(int received)
+  AckPacket(int received, int object)
       : GamePacket(BasicNetworkMessages::Received_State,
                    sizeof(AckPacket) - sizeof(GamePacket)),
-        receivedID(received) {}
+        receivedID(received), objectID(object) {}
 };
 
 struct StringPacket : public GamePacket {
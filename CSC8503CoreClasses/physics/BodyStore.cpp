@@ -0,0 +1,250 @@
+#include "BodyStore.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BODYSTORE_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+std::vector<float> BodyStore::*const BodyStore::Arrays[] = {
+    &BodyStore::posX,   &BodyStore::posY,        &BodyStore::posZ,
+    &BodyStore::rotX,   &BodyStore::rotY,        &BodyStore::rotZ,
+    &BodyStore::rotW,   &BodyStore::linX,        &BodyStore::linY,
+    &BodyStore::linZ,   &BodyStore::angX,        &BodyStore::angY,
+    &BodyStore::angZ,   &BodyStore::forceX,      &BodyStore::forceY,
+    &BodyStore::forceZ, &BodyStore::alphaX,      &BodyStore::alphaY,
+    &BodyStore::alphaZ, &BodyStore::inverseMass, &BodyStore::linearDamping,
+    &BodyStore::angularDamping};
+
+void BodyStore::Resize(size_t newCount) {
+  count = newCount;
+  objects.resize(count);
+  generations.resize(count);
+
+  size_t padded = (count + Lanes - 1) / Lanes * Lanes;
+  for (auto array : Arrays) {
+    std::vector<float> &values = this->*array;
+    values.resize(padded);
+    // Padding might have held a real body last time, so zero it
+    std::fill(values.begin() + count, values.end(), 0.0f);
+  }
+}
+
+void BodyStore::Clear() { Resize(0); }
+
+/*
+Waking and sleeping only changes which bodies are in the store now and then,
+so most frames the list is the same as last time, and nothing needs moving.
+When it isn't, the store is built again with everything that stayed awake
+carried over from its old slot.
+*/
+void BodyStore::Gather(const std::vector<GameObject *> &awake) {
+  if (awake == objects) {
+    for (size_t i = 0; i < count; ++i) {
+      if (objects[i]->GetTransform().GetGeneration() != generations[i]) {
+        Load(i, *objects[i]);
+      }
+    }
+    return;
+  }
+
+  BodyStore next;
+  next.Resize(awake.size());
+  next.objects = awake;
+  for (size_t i = 0; i < next.count; ++i) {
+    GameObject &object = *awake[i];
+    PhysicsObject &phys = *object.GetPhysicsObject();
+    if (!phys.IsInStore(*this)) {
+      next.Load(i, object);
+      next.SetLinearVelocity(i, phys.GetLinearVelocity());
+      next.SetAngularVelocity(i, phys.GetAngularVelocity());
+      continue;
+    }
+    size_t from = phys.GetBodyIndex();
+    for (auto array : Arrays) {
+      (next.*array)[i] = (this->*array)[from];
+    }
+    next.generations[i] = generations[from];
+    if (object.GetTransform().GetGeneration() != next.generations[i]) {
+      next.Load(i, object);
+    }
+  }
+
+  *this = std::move(next);
+  for (size_t i = 0; i < count; ++i) {
+    objects[i]->GetPhysicsObject()->EnterStore(*this, i);
+  }
+}
+
+// Picks up where the body's Transform has it
+void BodyStore::Load(size_t i, GameObject &object) {
+  const Transform &transform = object.GetTransform();
+  SetPosition(i, transform.GetPosition());
+  SetOrientation(i, transform.GetOrientation());
+  generations[i] = transform.GetGeneration();
+}
+
+void BodyStore::SyncTransforms() {
+  for (size_t i = 0; i < count; ++i) {
+    // Leave resting bodies' transforms alone, so their generation doesn't
+    // change and nothing downstream has to redo any work for them
+    bool moving = Vector::LengthSquared(GetLinearVelocity(i)) > 0.0f ||
+                  Vector::LengthSquared(GetAngularVelocity(i)) > 0.0f;
+    if (!moving) {
+      continue;
+    }
+    Transform &transform = objects[i]->GetTransform();
+    transform.SetPositionAndOrientation(GetPosition(i), GetOrientation(i));
+    generations[i] = transform.GetGeneration();
+  }
+}
+
+#ifdef BODYSTORE_SSE
+void BodyStore::IntegrateAccel(const Vector3 &gravity, float dt) {
+  const __m128 vdt = _mm_set1_ps(dt);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 gx = _mm_set1_ps(gravity.x);
+  const __m128 gy = _mm_set1_ps(gravity.y);
+  const __m128 gz = _mm_set1_ps(gravity.z);
+
+  for (size_t i = 0; i < posX.size(); i += Lanes) {
+    __m128 im = _mm_loadu_ps(&inverseMass[i]);
+    // Gravity for everything with mass, nothing for static bodies
+    __m128 hasMass = _mm_cmpgt_ps(im, zero);
+
+    auto linear = [&](std::vector<float> &vel, std::vector<float> &force,
+                      __m128 g) {
+      __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&force[i]), im),
+                            _mm_and_ps(hasMass, g));
+      __m128 v = _mm_add_ps(_mm_loadu_ps(&vel[i]), _mm_mul_ps(a, vdt));
+      _mm_storeu_ps(&vel[i], v);
+    };
+    linear(linX, forceX, gx);
+    linear(linY, forceY, gy);
+    linear(linZ, forceZ, gz);
+
+    auto angular = [&](std::vector<float> &vel, std::vector<float> &alpha) {
+      __m128 w = _mm_add_ps(_mm_loadu_ps(&vel[i]),
+                            _mm_mul_ps(_mm_loadu_ps(&alpha[i]), vdt));
+      _mm_storeu_ps(&vel[i], w);
+    };
+    angular(angX, alphaX);
+    angular(angY, alphaY);
+    angular(angZ, alphaZ);
+  }
+}
+
+void BodyStore::IntegrateVelocity(float dt) {
+  const __m128 vdt = _mm_set1_ps(dt);
+  const __m128 halfDt = _mm_set1_ps(dt * 0.5f);
+  const __m128 zero = _mm_setzero_ps();
+
+  for (size_t i = 0; i < posX.size(); i += Lanes) {
+    __m128 linDamp = _mm_loadu_ps(&linearDamping[i]);
+
+    auto linear = [&](std::vector<float> &pos, std::vector<float> &vel) {
+      __m128 v = _mm_loadu_ps(&vel[i]);
+      __m128 p = _mm_add_ps(_mm_loadu_ps(&pos[i]), _mm_mul_ps(v, vdt));
+      _mm_storeu_ps(&pos[i], p);
+      _mm_storeu_ps(&vel[i], _mm_mul_ps(v, linDamp));
+    };
+    linear(posX, linX);
+    linear(posY, linY);
+    linear(posZ, linZ);
+
+    // q += (w * dt / 2, 0) * q, written out component-wise
+    __m128 ax = _mm_mul_ps(_mm_loadu_ps(&angX[i]), halfDt);
+    __m128 ay = _mm_mul_ps(_mm_loadu_ps(&angY[i]), halfDt);
+    __m128 az = _mm_mul_ps(_mm_loadu_ps(&angZ[i]), halfDt);
+
+    __m128 qx = _mm_loadu_ps(&rotX[i]);
+    __m128 qy = _mm_loadu_ps(&rotY[i]);
+    __m128 qz = _mm_loadu_ps(&rotZ[i]);
+    __m128 qw = _mm_loadu_ps(&rotW[i]);
+
+    __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ax, qw), _mm_mul_ps(ay, qz)),
+                           _mm_mul_ps(az, qy));
+    __m128 dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ay, qw), _mm_mul_ps(az, qx)),
+                           _mm_mul_ps(ax, qz));
+    __m128 dz = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(az, qw), _mm_mul_ps(ax, qy)),
+                           _mm_mul_ps(ay, qx));
+    __m128 dw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, qx), _mm_mul_ps(ay, qy)),
+                           _mm_mul_ps(az, qz));
+
+    qx = _mm_add_ps(qx, dx);
+    qy = _mm_add_ps(qy, dy);
+    qz = _mm_add_ps(qz, dz);
+    qw = _mm_sub_ps(qw, dw);
+
+    __m128 lengthSq =
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+                   _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+    // Same as Quaternion::Normalise, leave zero length ones alone
+    __m128 valid = _mm_cmpgt_ps(lengthSq, zero);
+    __m128 length = _mm_sqrt_ps(lengthSq);
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f),
+                            _mm_or_ps(_mm_and_ps(valid, length),
+                                      _mm_andnot_ps(valid, _mm_set1_ps(1.0f))));
+
+    _mm_storeu_ps(&rotX[i], _mm_mul_ps(qx, inv));
+    _mm_storeu_ps(&rotY[i], _mm_mul_ps(qy, inv));
+    _mm_storeu_ps(&rotZ[i], _mm_mul_ps(qz, inv));
+    _mm_storeu_ps(&rotW[i], _mm_mul_ps(qw, inv));
+
+    __m128 angDamp = _mm_loadu_ps(&angularDamping[i]);
+    _mm_storeu_ps(&angX[i], _mm_mul_ps(_mm_loadu_ps(&angX[i]), angDamp));
+    _mm_storeu_ps(&angY[i], _mm_mul_ps(_mm_loadu_ps(&angY[i]), angDamp));
+    _mm_storeu_ps(&angZ[i], _mm_mul_ps(_mm_loadu_ps(&angZ[i]), angDamp));
+  }
+}
+#else
+void BodyStore::IntegrateAccel(const Vector3 &gravity, float dt) {
+  IntegrateAccelScalar(gravity, dt);
+}
+
+void BodyStore::IntegrateVelocity(float dt) { IntegrateVelocityScalar(dt); }
+#endif
+
+void BodyStore::IntegrateAccelScalar(const Vector3 &gravity, float dt) {
+  for (size_t i = 0; i < posX.size(); ++i) {
+    float im = inverseMass[i];
+    Vector3 g = im > 0.0f ? gravity : Vector3();
+
+    linX[i] += (forceX[i] * im + g.x) * dt;
+    linY[i] += (forceY[i] * im + g.y) * dt;
+    linZ[i] += (forceZ[i] * im + g.z) * dt;
+
+    angX[i] += alphaX[i] * dt;
+    angY[i] += alphaY[i] * dt;
+    angZ[i] += alphaZ[i] * dt;
+  }
+}
+
+void BodyStore::IntegrateVelocityScalar(float dt) {
+  for (size_t i = 0; i < posX.size(); ++i) {
+    posX[i] += linX[i] * dt;
+    posY[i] += linY[i] * dt;
+    posZ[i] += linZ[i] * dt;
+
+    linX[i] *= linearDamping[i];
+    linY[i] *= linearDamping[i];
+    linZ[i] *= linearDamping[i];
+
+    Quaternion rot = GetOrientation(i);
+    rot += Quaternion(GetAngularVelocity(i) * dt * 0.5f, 0.0f) * rot;
+    rot.Normalise();
+    SetOrientation(i, rot);
+
+    angX[i] *= angularDamping[i];
+    angY[i] *= angularDamping[i];
+    angZ[i] *= angularDamping[i];
+  }
+}
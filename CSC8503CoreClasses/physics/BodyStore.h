@@ -0,0 +1,138 @@
+#pragma once
+#include "Quaternion.h"
+#include "Vector.h"
+
+#include <vector>
+
+namespace NCL {
+using namespace NCL::Maths;
+namespace CSC8503 {
+class GameObject;
+
+/*
+Structure of arrays home of the motion state of every awake dynamic body.
+
+While a body is in the store, its PhysicsObject reads and writes its velocities
+here by index, and its position and orientation live here for the whole step.
+The physics system only writes them out to the Transform once a step is done,
+so the kernels can run over whole arrays at a time however many substeps there
+are. Each array is padded to a multiple of Lanes, so the SIMD kernels never
+need a scalar tail - padding bodies have zero mass, velocity and damping, so
+they don't go anywhere.
+*/
+class BodyStore {
+public:
+  static constexpr size_t Lanes = 4;
+
+  BodyStore() = default;
+  ~BodyStore() = default;
+
+  /// @brief Resize for count bodies, keeping any existing values
+  void Resize(size_t count);
+  void Clear();
+
+  size_t Size() const { return count; }
+
+  const std::vector<GameObject *> &GetObjects() const { return objects; }
+
+  /// @brief Makes the store hold exactly the given bodies, in that order.
+  /// Bodies already in it keep their state, new ones start from their
+  /// PhysicsObject and Transform. Anything being dropped has to have left
+  /// the store first, as it might not exist any more
+  void Gather(const std::vector<GameObject *> &awake);
+
+  /// @brief Writes positions and orientations out to the Transforms of the
+  /// bodies that are moving
+  void SyncTransforms();
+
+  void SetPosition(size_t i, const Vector3 &p) {
+    posX[i] = p.x;
+    posY[i] = p.y;
+    posZ[i] = p.z;
+  }
+  Vector3 GetPosition(size_t i) const {
+    return Vector3(posX[i], posY[i], posZ[i]);
+  }
+
+  void SetOrientation(size_t i, const Quaternion &q) {
+    rotX[i] = q.x;
+    rotY[i] = q.y;
+    rotZ[i] = q.z;
+    rotW[i] = q.w;
+  }
+  Quaternion GetOrientation(size_t i) const {
+    return Quaternion(rotX[i], rotY[i], rotZ[i], rotW[i]);
+  }
+
+  void SetLinearVelocity(size_t i, const Vector3 &v) {
+    linX[i] = v.x;
+    linY[i] = v.y;
+    linZ[i] = v.z;
+  }
+  Vector3 GetLinearVelocity(size_t i) const {
+    return Vector3(linX[i], linY[i], linZ[i]);
+  }
+
+  void SetAngularVelocity(size_t i, const Vector3 &w) {
+    angX[i] = w.x;
+    angY[i] = w.y;
+    angZ[i] = w.z;
+  }
+  Vector3 GetAngularVelocity(size_t i) const {
+    return Vector3(angX[i], angY[i], angZ[i]);
+  }
+
+  void SetForce(size_t i, const Vector3 &f) {
+    forceX[i] = f.x;
+    forceY[i] = f.y;
+    forceZ[i] = f.z;
+  }
+
+  // Torque already taken through the inverse inertia tensor
+  void SetAngularAcceleration(size_t i, const Vector3 &a) {
+    alphaX[i] = a.x;
+    alphaY[i] = a.y;
+    alphaZ[i] = a.z;
+  }
+
+  void SetInverseMass(size_t i, float m) { inverseMass[i] = m; }
+
+  // Per step damping multipliers, rather than the material's values
+  void SetDamping(size_t i, float linear, float angular) {
+    linearDamping[i] = linear;
+    angularDamping[i] = angular;
+  }
+
+  /// @brief v += (f / m + g) * dt, w += alpha * dt. Gravity only applies to
+  /// bodies with mass
+  void IntegrateAccel(const Vector3 &gravity, float dt);
+
+  /// @brief Move bodies along their velocities, then damp the velocities
+  void IntegrateVelocity(float dt);
+
+protected:
+  void IntegrateAccelScalar(const Vector3 &gravity, float dt);
+  void IntegrateVelocityScalar(float dt);
+
+  void Load(size_t i, GameObject &object);
+
+  static std::vector<float> BodyStore::*const Arrays[];
+
+  std::vector<GameObject *> objects;
+  size_t count = 0;
+
+  // Transform generation when each body was last loaded or written out, so
+  // anything else moving it in between can be picked up
+  std::vector<uint32_t> generations;
+
+  std::vector<float> posX, posY, posZ;
+  std::vector<float> rotX, rotY, rotZ, rotW;
+  std::vector<float> linX, linY, linZ;
+  std::vector<float> angX, angY, angZ;
+  std::vector<float> forceX, forceY, forceZ;
+  std::vector<float> alphaX, alphaY, alphaZ;
+  std::vector<float> inverseMass;
+  std::vector<float> linearDamping, angularDamping;
+};
+} // namespace CSC8503
+} // namespace NCL
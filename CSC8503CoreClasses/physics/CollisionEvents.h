@@ -0,0 +1,98 @@
+#pragma once
+#include "GameObject.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace NCL::CSC8503 {
+struct CollisionEvent {
+  enum class Type : uint8_t {
+    Begin,
+    Stay,
+    End,
+  };
+
+  GameObject *a;
+  GameObject *b;
+  Type type;
+};
+
+/*
+Collision events are only written down while the physics step is running, and
+handed out to the objects in one go once it's finished, so gameplay code
+never runs in the middle of the step, and can't change anything the step is
+still using. When physics is threaded, the events are handed over to another
+buffer once a step is done, and dispatched from there on the game's thread.
+*/
+class CollisionEventBuffer {
+public:
+  using TagFilter = Bitflag<GameObject::Tag>;
+
+  void Push(GameObject *a, GameObject *b, CollisionEvent::Type type) {
+    if (Wanted(a) || Wanted(b)) {
+      events.push_back({a, b, type});
+    }
+  }
+
+  /// @brief Only keep events where at least one of the objects has one of
+  /// these tags, or every event if there's no filter
+  void SetTagFilter(std::optional<TagFilter> filter) { tagFilter = filter; }
+  const std::optional<TagFilter> &GetTagFilter() const { return tagFilter; }
+
+  /// @brief Tell both objects about every event, in the order they happened,
+  /// then empty the buffer
+  void Dispatch() {
+    for (const CollisionEvent &e : events) {
+      switch (e.type) {
+      case CollisionEvent::Type::Begin:
+        e.a->OnCollisionBegin(e.b);
+        e.b->OnCollisionBegin(e.a);
+        break;
+      case CollisionEvent::Type::Stay:
+        e.a->OnCollisionStay(e.b);
+        e.b->OnCollisionStay(e.a);
+        break;
+      case CollisionEvent::Type::End:
+        e.a->OnCollisionEnd(e.b);
+        e.b->OnCollisionEnd(e.a);
+        break;
+      }
+    }
+    events.clear();
+  }
+
+  void Clear() { events.clear(); }
+
+  /// @brief Move every event onto the end of another buffer, leaving this
+  /// one empty
+  void MoveTo(CollisionEventBuffer &other) {
+    other.events.insert(other.events.end(), events.begin(), events.end());
+    events.clear();
+  }
+
+  /// @brief Drop every event involving any of the objects, which have to be
+  /// sorted, so nothing's told about an object that's about to be deleted
+  void Forget(std::span<GameObject *const> objects) {
+    auto gone = [&](GameObject *o) {
+      return std::binary_search(objects.begin(), objects.end(), o);
+    };
+    std::erase_if(events, [&](const CollisionEvent &e) {
+      return gone(e.a) || gone(e.b);
+    });
+  }
+
+  const std::vector<CollisionEvent> &GetEvents() const { return events; }
+
+protected:
+  bool Wanted(const GameObject *o) const {
+    return !tagFilter.has_value() ||
+           (o->GetTags().as_underlying() & tagFilter->as_underlying()) != 0;
+  }
+
+  std::vector<CollisionEvent> events;
+  std::optional<TagFilter> tagFilter;
+};
+} // namespace NCL::CSC8503
@@ -0,0 +1,42 @@
+#include "GameObject.h"
+#include "PhysicsCommands.h"
+#include "PhysicsObject.h"
+
+#include "Overloaded.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+void PhysicsCommand::Apply(GameObject &o, const Action &action) {
+  PhysicsObject &phys = *o.GetPhysicsObject();
+  Transform &transform = o.GetTransform();
+
+  using namespace PhysicsCommands;
+  std::visit(
+      overloaded{
+          [&](const AddForce &a) { phys.AddForce(a.force); },
+          [&](const AddForceAtPosition &a) {
+            phys.AddForceAtPosition(a.force, a.position);
+          },
+          [&](const AddTorque &a) { phys.AddTorque(a.torque); },
+          [&](const ApplyLinearImpulse &a) {
+            phys.ApplyLinearImpulse(a.impulse);
+          },
+          [&](const ApplyAngularImpulse &a) {
+            phys.ApplyAngularImpulse(a.impulse);
+          },
+          [&](const SetLinearVelocity &a) {
+            phys.SetLinearVelocity(a.velocity);
+          },
+          [&](const SetAngularVelocity &a) {
+            phys.SetAngularVelocity(a.velocity);
+          },
+          [&](const SetPosition &a) { transform.SetPosition(a.position); },
+          [&](const SetOrientation &a) {
+            transform.SetOrientation(a.orientation);
+          },
+          [&](const Reset &) { o.Reset(); },
+          [&](const Run &a) { a.function(o); },
+      },
+      action);
+}
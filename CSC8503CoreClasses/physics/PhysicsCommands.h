@@ -0,0 +1,82 @@
+#pragma once
+#include "Quaternion.h"
+#include "Vector.h"
+
+#include <functional>
+#include <variant>
+
+namespace NCL::CSC8503 {
+class GameObject;
+
+/*
+Changes gameplay code wants made to an object's physics, queued up so they
+can be handed over without waiting for the physics thread to finish a step.
+They're applied at the start of the next step, in the order they were queued.
+Without a physics thread there's nothing to wait for, and they're applied
+straight away.
+*/
+namespace PhysicsCommands {
+struct AddForce {
+  Vector3 force;
+};
+struct AddForceAtPosition {
+  Vector3 force;
+  Vector3 position;
+};
+struct AddTorque {
+  Vector3 torque;
+};
+struct ApplyLinearImpulse {
+  Vector3 impulse;
+};
+struct ApplyAngularImpulse {
+  Vector3 impulse;
+};
+struct SetLinearVelocity {
+  Vector3 velocity;
+};
+struct SetAngularVelocity {
+  Vector3 velocity;
+};
+struct SetPosition {
+  Vector3 position;
+};
+struct SetOrientation {
+  Quaternion orientation;
+};
+// Puts the object back how it started with its Reset, which for anything that
+// overrides it runs wherever physics does too
+struct Reset {};
+// Anything the others don't cover, like changing the object's constraints.
+// It runs wherever physics does, so it mustn't touch anything but the
+// object's physics
+struct Run {
+  std::function<void(GameObject &)> function;
+};
+} // namespace PhysicsCommands
+
+struct PhysicsCommand {
+  using Action =
+      std::variant<PhysicsCommands::AddForce,
+                   PhysicsCommands::AddForceAtPosition,
+                   PhysicsCommands::AddTorque,
+                   PhysicsCommands::ApplyLinearImpulse,
+                   PhysicsCommands::ApplyAngularImpulse,
+                   PhysicsCommands::SetLinearVelocity,
+                   PhysicsCommands::SetAngularVelocity,
+                   PhysicsCommands::SetPosition,
+                   PhysicsCommands::SetOrientation,
+                   PhysicsCommands::Reset,
+                   PhysicsCommands::Run>;
+
+  GameObject *object;
+  // Checked against the object's current ID when applied, so commands for
+  // objects removed in the meantime get dropped
+  int worldID;
+  Action action;
+
+  /// @brief Make the change to the object, which is assumed to still be
+  /// around and have physics
+  static void Apply(GameObject &o, const Action &action);
+};
+} // namespace NCL::CSC8503
@@ -11,60 +11,150 @@ PhysicsObject::PhysicsObject(Transform &parentTransform,
 
   inverseMass = 1.0f;
   elasticity = 0.8f;
-  friction = 0.8f;
+  // Contacts had no friction at all before manifolds, so it's opt in
+  friction = 0.0f;
 }
 
 void PhysicsObject::ClampVelocities() {
+  Vector3 linear = GetLinearVelocity();
+  Vector3 angular = GetAngularVelocity();
+
   if ((axisLocks & LinearX) != 0)
-    linearVelocity.x = 0.f;
+    linear.x = 0.f;
   if ((axisLocks & LinearY) != 0)
-    linearVelocity.y = 0.f;
+    linear.y = 0.f;
   if ((axisLocks & LinearZ) != 0)
-    linearVelocity.z = 0.f;
+    linear.z = 0.f;
 
   if ((axisLocks & AngularX) != 0)
-    angularVelocity.x = 0.f;
+    angular.x = 0.f;
   if ((axisLocks & AngularY) != 0)
-    angularVelocity.y = 0.f;
+    angular.y = 0.f;
   if ((axisLocks & AngularZ) != 0)
-    angularVelocity.z = 0.f;
+    angular.z = 0.f;
 
   if (maxLinearVelocity.has_value()) {
-    auto linVelMag = Vector::Length(linearVelocity);
+    auto linVelMag = Vector::Length(linear);
 
     if (linVelMag > maxLinearVelocity.value()) {
-      linearVelocity = (linearVelocity / linVelMag) * maxLinearVelocity.value();
+      linear = (linear / linVelMag) * maxLinearVelocity.value();
     }
   }
 
   if (maxAngularVelocity.has_value()) {
-    auto angVelMag = Vector::Length(angularVelocity);
+    auto angVelMag = Vector::Length(angular);
     if (angVelMag > maxAngularVelocity.value()) {
-      angularVelocity =
-          (angularVelocity / angVelMag) * maxAngularVelocity.value();
+      angular = (angular / angVelMag) * maxAngularVelocity.value();
     }
   }
+
+  SetLinearVelocity(linear);
+  SetAngularVelocity(angular);
+}
+
+void PhysicsObject::Sleep() {
+  asleep = true;
+  SetLinearVelocity({});
+  SetAngularVelocity({});
+  sleepGeneration = transform.GetGeneration();
+}
+
+Vector3 PhysicsObject::GetPosition() const {
+  return store ? store->GetPosition(bodyIndex) : transform.GetPosition();
+}
+
+Quaternion PhysicsObject::GetOrientation() const {
+  return store ? store->GetOrientation(bodyIndex) : transform.GetOrientation();
+}
+
+/*
+The Transform already has the latest position, as the store writes it out at
+the end of every step, so only the velocities need taking back
+*/
+void PhysicsObject::LeaveStore() {
+  if (!store) {
+    return;
+  }
+  linearVelocity = store->GetLinearVelocity(bodyIndex);
+  angularVelocity = store->GetAngularVelocity(bodyIndex);
+  store = nullptr;
+}
+
+// Anything that would actually change how a movable object is moving wakes it
+void PhysicsObject::WakeFrom(const Vector3 &push) {
+  if (asleep && GetInverseMass() > 0.0f && Vector::LengthSquared(push) > 0.0f) {
+    Wake();
+  }
 }
 
 void PhysicsObject::ApplyAngularImpulse(const Vector3 &force) {
-  angularVelocity += inverseInteriaTensor * force;
+  WakeFrom(force);
+  SetAngularVelocity(GetAngularVelocity() + GetInertiaTensor() * force);
 }
 
 void PhysicsObject::ApplyLinearImpulse(const Vector3 &force) {
-  linearVelocity += force * inverseMass;
+  WakeFrom(force);
+  SetLinearVelocity(GetLinearVelocity() + force * GetInverseMass());
+}
+
+float PhysicsObject::GetInverseMassAt(const Vector3 &offset,
+                                     const Vector3 &direction) const {
+  Vector3 arm = Vector::Cross(offset, direction);
+  return GetInverseMass() + Vector::Dot(arm, GetInertiaTensor() * arm);
 }
 
-void PhysicsObject::AddForce(const Vector3 &addedForce) { force += addedForce; }
+/*
+Locked axes are taken out of the move as well as the velocity, or the
+velocity would be clamped away next step but the move kept.
+*/
+void PhysicsObject::ApplyPositionImpulse(const Vector3 &impulse,
+                                         const Vector3 &offset, float dt) {
+  Vector3 linear = impulse * GetInverseMass();
+  Vector3 angular = GetInertiaTensor() * Vector::Cross(offset, impulse);
+  for (int i = 0; i < 3; ++i) {
+    if (axisLocks & (LinearX << i)) {
+      linear[i] = 0.0f;
+    }
+    if (axisLocks & (AngularX << i)) {
+      angular[i] = 0.0f;
+    }
+  }
+  if (Vector::LengthSquared(linear) <= 0.0f &&
+      Vector::LengthSquared(angular) <= 0.0f) {
+    return;
+  }
+  WakeFrom(impulse);
+
+  Quaternion orientation = GetOrientation();
+  orientation += Quaternion(angular * 0.5f, 0.0f) * orientation;
+  orientation.Normalise();
+  if (store) {
+    store->SetPosition(bodyIndex, GetPosition() + linear);
+    store->SetOrientation(bodyIndex, orientation);
+  } else {
+    transform.SetPositionAndOrientation(GetPosition() + linear, orientation);
+  }
+
+  SetLinearVelocity(GetLinearVelocity() + linear / dt);
+  SetAngularVelocity(GetAngularVelocity() + angular / dt);
+}
+
+void PhysicsObject::AddForce(const Vector3 &addedForce) {
+  WakeFrom(addedForce);
+  force += addedForce;
+}
 
 void PhysicsObject::AddForceAtPosition(const Vector3 &addedForce,
                                        const Vector3 &position) {
   Vector3 localPos = position - transform.GetPosition();
 
+  WakeFrom(addedForce);
   force += addedForce;
   torque += Vector::Cross(localPos, addedForce);
 }
 
 void PhysicsObject::AddTorque(const Vector3 &addedTorque) {
+  WakeFrom(addedTorque);
   torque += addedTorque;
 }
 
@@ -93,7 +183,7 @@ void PhysicsObject::InitSphereInertia() {
 }
 
 void PhysicsObject::UpdateInertiaTensor() {
-  Quaternion q = transform.GetOrientation();
+  Quaternion q = GetOrientation();
 
   Matrix3 invOrientation = Quaternion::RotationMatrix<Matrix3>(q.Conjugate());
   Matrix3 orientation = Quaternion::RotationMatrix<Matrix3>(q);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BodyStore.h"
 #include "macros.h"
 
 using namespace NCL::Maths;
@@ -21,6 +22,15 @@ public:
     AngularZ = BIT(5)
   };
 
+  /*
+  Static bodies never move, and only ever get checked against dynamic ones.
+  Kinematic bodies are moved by gameplay code, and push dynamic bodies out
+  of the way without being pushed back. Only dynamic bodies are integrated.
+  Set the type before the object goes in the world, and don't move static
+  bodies once they're in it, make them kinematic instead.
+  */
+  enum class BodyType : uint8_t { Static, Kinematic, Dynamic };
+
   struct PhysicsMaterial {
     float linearDamping = 0.5f;
     float angularDamping = 0.5f;
@@ -43,16 +53,38 @@ public:
   void ClampVelocities();
 
   void Reset() {
-    linearVelocity = {};
-    angularVelocity = {};
+    SetLinearVelocity({});
+    SetAngularVelocity({});
     force = {};
     torque = {};
+    Wake();
+  }
+
+  /// @brief Sleeping objects are skipped by integration and the narrowphase,
+  /// until something hits them, pushes them, or moves them
+  bool IsAsleep() const { return asleep; }
+  void Sleep();
+  void Wake() {
+    asleep = false;
+    sleepTimer = 0.0f;
   }
 
-  Vector3 GetLinearVelocity() const { return linearVelocity; }
+  /// @brief How long the object has been slow enough to sleep
+  float GetSleepTimer() const { return sleepTimer; }
+  void SetSleepTimer(float t) { sleepTimer = t; }
+
+  /// @brief Transform generation when the object went to sleep, anything
+  /// else moving it since should wake it back up
+  uint32_t GetSleepGeneration() const { return sleepGeneration; }
+
+  Vector3 GetLinearVelocity() const {
+    return store ? store->GetLinearVelocity(bodyIndex) : linearVelocity;
+  }
   std::optional<float> &GetMaxLinearVelocity() { return maxLinearVelocity; }
 
-  Vector3 GetAngularVelocity() const { return angularVelocity; }
+  Vector3 GetAngularVelocity() const {
+    return store ? store->GetAngularVelocity(bodyIndex) : angularVelocity;
+  }
   std::optional<float> &GetMaxAngularVelocity() { return maxAngularVelocity; }
 
   Vector3 GetTorque() const { return torque; }
@@ -61,11 +93,36 @@ public:
 
   void SetInverseMass(float invMass) { inverseMass = invMass; }
 
-  float GetInverseMass() const { return inverseMass; }
+  /// @brief Always 0 for static and kinematic bodies, whatever they were
+  /// given, so nothing can push them
+  float GetInverseMass() const { return IsDynamic() ? inverseMass : 0.0f; }
+
+  BodyType GetBodyType() const { return bodyType; }
+  void SetBodyType(BodyType type) { bodyType = type; }
+  bool IsDynamic() const { return bodyType == BodyType::Dynamic; }
+
+  /// @brief How bouncy the object is, contacts use the product of both sides
+  float GetElasticity() const { return elasticity; }
+  void SetElasticity(float e) { elasticity = e; }
+
+  /// @brief Contacts use the geometric mean of both sides' friction, so
+  /// there's none unless both have some. None by default
+  float GetFriction() const { return friction; }
+  void SetFriction(float f) { friction = f; }
 
   void ApplyAngularImpulse(const Vector3 &force);
   void ApplyLinearImpulse(const Vector3 &force);
 
+  /// @brief How easily a push along direction at offset from the centre
+  /// moves that point, from both the mass and the inertia
+  float GetInverseMassAt(const Vector3 &offset, const Vector3 &direction) const;
+
+  /// @brief Moves the object straight away, as an impulse at offset from the
+  /// centre spread over dt would have, and gives it the velocity to match.
+  /// For the XPBD constraint solver
+  void ApplyPositionImpulse(const Vector3 &impulse, const Vector3 &offset,
+                            float dt);
+
   void AddForce(const Vector3 &force);
 
   void AddForceAtPosition(const Vector3 &force, const Vector3 &position);
@@ -74,9 +131,36 @@ public:
 
   void ClearForces();
 
-  void SetLinearVelocity(const Vector3 &v) { linearVelocity = v; }
+  void SetLinearVelocity(const Vector3 &v) {
+    if (store) {
+      store->SetLinearVelocity(bodyIndex, v);
+    } else {
+      linearVelocity = v;
+    }
+  }
+
+  void SetAngularVelocity(const Vector3 &v) {
+    if (store) {
+      store->SetAngularVelocity(bodyIndex, v);
+    } else {
+      angularVelocity = v;
+    }
+  }
 
-  void SetAngularVelocity(const Vector3 &v) { angularVelocity = v; }
+  /// @brief Where the physics system has the object, which part way through
+  /// a step can be ahead of its Transform
+  Vector3 GetPosition() const;
+  Quaternion GetOrientation() const;
+
+  /// @brief While the object is in a body store, its motion lives there, and
+  /// is only written out to its Transform at the end of each step
+  void EnterStore(BodyStore &s, size_t index) {
+    store = &s;
+    bodyIndex = index;
+  }
+  void LeaveStore();
+  bool IsInStore(const BodyStore &s) const { return store == &s; }
+  size_t GetBodyIndex() const { return bodyIndex; }
 
   PhysicsMaterial &GetMaterial() { return material; }
 
@@ -85,12 +169,21 @@ public:
 
   void UpdateInertiaTensor();
 
-  Matrix3 GetInertiaTensor() const { return inverseInteriaTensor; }
+  Matrix3 GetInertiaTensor() const {
+    return IsDynamic() ? inverseInteriaTensor : Matrix::Scale3x3(Vector3());
+  }
 
   uint8_t GetAxisLocks() const { return axisLocks; }
   void SetAxisLocks(uint8_t locks) { axisLocks = locks; }
 
+  /// @brief Sweep the object along its motion each step, so it can't pass
+  /// through anything thin when it's moving fast
+  bool UsesContinuousCollision() const { return continuousCollision; }
+  void SetContinuousCollision(bool state) { continuousCollision = state; }
+
 protected:
+  void WakeFrom(const Vector3 &push);
+
   const CollisionVolume *volume;
   Transform &transform;
 
@@ -100,9 +193,20 @@ protected:
 
   uint8_t axisLocks;
 
+  BodyType bodyType = BodyType::Dynamic;
+
+  bool continuousCollision = false;
+
+  bool asleep = false;
+  float sleepTimer = 0.0f;
+  uint32_t sleepGeneration = 0;
+
+  BodyStore *store = nullptr;
+  size_t bodyIndex = 0;
+
   PhysicsMaterial material;
 
-  // linear stuff
+  // linear stuff, the velocities only while out of the body store
   Vector3 linearVelocity;
   Vector3 force;
   std::optional<float> maxLinearVelocity;
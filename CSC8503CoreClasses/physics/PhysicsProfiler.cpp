@@ -0,0 +1,139 @@
+#include "PhysicsProfiler.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const char *PhysicsProfiler::PhaseName(Phase phase) {
+  switch (phase) {
+  case Phase::UpdateObjectAABBs:
+    return "UpdateObjectAABBs";
+  case Phase::IntegrateAccel:
+    return "IntegrateAccel";
+  case Phase::BroadPhase:
+    return "BroadPhase";
+  case Phase::NarrowPhase:
+    return "NarrowPhase";
+  case Phase::PrepareContacts:
+    return "PrepareContacts";
+  case Phase::SolveContacts:
+    return "SolveContacts";
+  case Phase::UpdateConstraints:
+    return "UpdateConstraints";
+  case Phase::IntegrateVelocity:
+    return "IntegrateVelocity";
+  case Phase::UpdateSleeping:
+    return "UpdateSleeping";
+  case Phase::UpdateCollisionList:
+    return "UpdateCollisionList";
+  case Phase::DispatchEvents:
+    return "DispatchEvents";
+  default:
+    return "Unknown";
+  }
+}
+
+const char *PhysicsProfiler::StepLimitName(StepLimit limit) {
+  switch (limit) {
+  case StepLimit::None:
+    return "None";
+  case StepLimit::MaxSubsteps:
+    return "MaxSubsteps";
+  case StepLimit::Budget:
+    return "Budget";
+  default:
+    return "Unknown";
+  }
+}
+
+void PhysicsProfiler::BeginFrame() {
+  current = Frame();
+  frameStart = Clock::now();
+}
+
+void PhysicsProfiler::EndFrame() {
+  std::chrono::duration<float, std::milli> ms = Clock::now() - frameStart;
+  current.totalMs = ms.count();
+
+  history[next] = current;
+  totalHistory[next] = current.totalMs;
+  next = (next + 1) % HistorySize;
+  recorded = std::min(recorded + 1, HistorySize);
+
+  if (csv.is_open()) {
+    WriteCsvRow(current);
+  }
+  ++frameNumber;
+}
+
+PhysicsProfiler::Frame PhysicsProfiler::GetAverage() const {
+  Frame average;
+  if (recorded == 0) {
+    return average;
+  }
+
+  for (size_t i = 0; i < recorded; ++i) {
+    const Frame &f = history[(next + HistorySize - 1 - i) % HistorySize];
+    for (size_t p = 0; p < PhaseCount; ++p) {
+      average.phaseMs[p] += f.phaseMs[p];
+    }
+    average.totalMs += f.totalMs;
+    average.substeps += f.substeps;
+    average.awakeBodies += f.awakeBodies;
+    average.broadPhasePairs += f.broadPhasePairs;
+    average.contactPairs += f.contactPairs;
+    average.contactPoints += f.contactPoints;
+    average.backlogMs += f.backlogMs;
+    average.droppedMs += f.droppedMs;
+  }
+
+  float scale = 1.0f / recorded;
+  for (float &ms : average.phaseMs) {
+    ms *= scale;
+  }
+  average.totalMs *= scale;
+  average.backlogMs *= scale;
+  average.droppedMs *= scale;
+  // Counters are rounded, they're only for reading off
+  int count = (int)recorded;
+  average.substeps /= count;
+  average.awakeBodies /= count;
+  average.broadPhasePairs /= count;
+  average.contactPairs /= count;
+  average.contactPoints /= count;
+  return average;
+}
+
+bool PhysicsProfiler::OpenCsv(const std::string &path) {
+  csv.close();
+  csv.open(path, std::ios::out | std::ios::trunc);
+  if (!csv.is_open()) {
+    return false;
+  }
+
+  csv << "frame,totalMs";
+  for (size_t p = 0; p < PhaseCount; ++p) {
+    csv << ',' << PhaseName((Phase)p) << "Ms";
+  }
+  csv << ",substeps,awakeBodies,broadPhasePairs,contactPairs,contactPoints"
+         ",stepLimit,backlogMs,droppedMs\n";
+  return true;
+}
+
+void PhysicsProfiler::WriteCsvRow(const Frame &f) {
+  csv << frameNumber << ',' << f.totalMs;
+  for (float ms : f.phaseMs) {
+    csv << ',' << ms;
+  }
+  csv << ',' << f.substeps << ',' << f.awakeBodies << ','
+      << f.broadPhasePairs << ',' << f.contactPairs << ',' << f.contactPoints
+      << ',' << StepLimitName(f.stepLimit) << ',' << f.backlogMs << ','
+      << f.droppedMs << '\n';
+
+  // The server tends to get killed rather than shut down, so don't leave too
+  // much sat in the buffer
+  if (frameNumber % 120 == 0) {
+    csv.flush();
+  }
+}
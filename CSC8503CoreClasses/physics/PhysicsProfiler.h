@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace NCL {
+namespace CSC8503 {
+/*
+Times each phase of the physics update, and counts how much work each frame
+did, so there's something to go on when tuning.
+
+Phases that run once per substep are added up over the whole frame. The last
+few seconds of frames are kept for graphs and averages, and every frame can
+also be written out to a CSV file.
+*/
+class PhysicsProfiler {
+public:
+  enum class Phase : uint8_t {
+    UpdateObjectAABBs,
+    IntegrateAccel,
+    BroadPhase,
+    NarrowPhase,
+    PrepareContacts,
+    SolveContacts,
+    UpdateConstraints,
+    IntegrateVelocity,
+    UpdateSleeping,
+    UpdateCollisionList,
+    DispatchEvents,
+    Count,
+  };
+  static constexpr size_t PhaseCount = (size_t)Phase::Count;
+
+  /// @brief Why a frame took fewer steps than the time passed in called for
+  enum class StepLimit : uint8_t {
+    None,
+    MaxSubsteps,
+    Budget,
+  };
+
+  struct Frame {
+    std::array<float, PhaseCount> phaseMs = {};
+    float totalMs = 0.0f;
+
+    int substeps = 0;
+    int awakeBodies = 0;
+    // Summed over every substep
+    int broadPhasePairs = 0;
+    int contactPairs = 0;
+    int contactPoints = 0;
+
+    // What the step controller decided
+    StepLimit stepLimit = StepLimit::None;
+    // Time carried over to the next frame, and time given up on
+    float backlogMs = 0.0f;
+    float droppedMs = 0.0f;
+  };
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  /// @brief Adds the time from construction to destruction onto a phase
+  class Scope {
+  public:
+    Scope(PhysicsProfiler &p, Phase phase)
+        : profiler(p), phase(phase), start(Clock::now()) {}
+    ~Scope() { profiler.AddTime(phase, start, Clock::now()); }
+
+  protected:
+    PhysicsProfiler &profiler;
+    Phase phase;
+    Clock::time_point start;
+  };
+
+  static constexpr size_t HistorySize = 240;
+
+  PhysicsProfiler() = default;
+  ~PhysicsProfiler() = default;
+
+  static const char *PhaseName(Phase phase);
+  static const char *StepLimitName(StepLimit limit);
+
+  void BeginFrame();
+  void EndFrame();
+
+  void AddTime(Phase phase, Clock::time_point start, Clock::time_point end) {
+    std::chrono::duration<float, std::milli> ms = end - start;
+    current.phaseMs[(size_t)phase] += ms.count();
+  }
+
+  /// @brief Counters for the frame in progress
+  Frame &Current() { return current; }
+
+  const Frame &GetLastFrame() const { return history[LastIndex()]; }
+  Frame GetAverage() const;
+
+  /// @brief Total frame times, oldest first from GetHistoryOffset, for
+  /// plotting
+  const std::array<float, HistorySize> &GetTotalHistory() const {
+    return totalHistory;
+  }
+  size_t GetHistoryOffset() const { return next; }
+
+  /// @brief Start writing a line per frame to a CSV file, replacing anything
+  /// already there
+  bool OpenCsv(const std::string &path);
+  void CloseCsv() { csv.close(); }
+  bool IsWritingCsv() const { return csv.is_open(); }
+
+protected:
+  size_t LastIndex() const {
+    return (next + HistorySize - 1) % HistorySize;
+  }
+
+  void WriteCsvRow(const Frame &f);
+
+  Frame current;
+  Clock::time_point frameStart;
+
+  std::array<Frame, HistorySize> history = {};
+  std::array<float, HistorySize> totalHistory = {};
+  size_t next = 0;
+  size_t recorded = 0;
+  uint64_t frameNumber = 0;
+
+  std::ofstream csv;
+};
+} // namespace CSC8503
+} // namespace NCL
@@ -0,0 +1,101 @@
+#pragma once
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "Vector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace NCL::CSC8503 {
+class GameObject;
+
+/// @brief Where an object is and how it's moving, as gameplay code sees it
+struct PhysicsState {
+  Vector3 position;
+  Quaternion orientation;
+  Vector3 linearVelocity;
+  Vector3 angularVelocity;
+  // The transform's generation, which changes whenever it moves
+  uint32_t generation = 0;
+};
+
+/*
+Where every physics body was at the end of a step, and the step before it,
+copied out so other threads can read it while the next step is moving the
+real transforms. Bodies are indexed by world ID.
+
+Physics steps at a fixed rate that doesn't line up with frames, so drawing
+the latest step judders. Blending between the last two steps by how far
+through the next step we are instead keeps motion smooth, at the cost of
+showing everything one step behind.
+
+Gameplay code reads bodies from here too while physics is threaded, rather
+than the transforms the step is busy moving.
+*/
+struct PhysicsSnapshot {
+  using Clock = std::chrono::steady_clock;
+
+  struct Body {
+    // Null for world IDs that have no body in this snapshot
+    const GameObject *object = nullptr;
+    Vector3 position;
+    Quaternion orientation;
+    Vector3 scale;
+
+    Vector3 previousPosition;
+    Quaternion previousOrientation;
+
+    Vector3 linearVelocity;
+    Vector3 angularVelocity;
+    uint32_t generation = 0;
+
+    Vector3 GetPosition(float alpha) const {
+      return Vector::Lerp(previousPosition, position, alpha);
+    }
+    Quaternion GetOrientation(float alpha) const {
+      // Steps are short enough that normalised lerp is as good as slerp
+      Quaternion q =
+          Quaternion::Lerp(previousOrientation, orientation, alpha);
+      q.Normalise();
+      return q;
+    }
+  };
+
+  std::vector<Body> bodies;
+  uint64_t step = 0;
+
+  // When the latest step counts as having happened, and how long a step
+  // is, to tell how far through the next one we are
+  Clock::time_point stepTime;
+  float stepDT = 0.0f;
+  bool interpolate = false;
+
+  /// @brief The body for an object, or null if it wasn't in this snapshot
+  const Body *Find(const GameObject &o, int worldID) const {
+    if (worldID < 0 || worldID >= (int)bodies.size()) {
+      return nullptr;
+    }
+    const Body &b = bodies[worldID];
+    return b.object == &o ? &b : nullptr;
+  }
+
+  /// @brief How far from the previous step to the latest to draw, held at
+  /// the latest if the next step is running late
+  float GetAlpha(Clock::time_point now = Clock::now()) const {
+    if (!interpolate || stepDT <= 0.0f) {
+      return 1.0f;
+    }
+    std::chrono::duration<float> since = now - stepTime;
+    return std::clamp(since.count() / stepDT, 0.0f, 1.0f);
+  }
+
+  /// @brief Built the same way as Transform::GetMatrix
+  static Matrix4 ModelMatrix(const Body &b, float alpha) {
+    return Matrix::Translation(b.GetPosition(alpha)) *
+           Quaternion::RotationMatrix<Matrix4>(b.GetOrientation(alpha)) *
+           Matrix::Scale(b.scale);
+  }
+};
+} // namespace NCL::CSC8503
@@ -8,22 +8,38 @@
 
 #include "Debug.h"
 #include "Window.h"
-#include <collisions/QuadTree.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <functional>
 
 using namespace NCL;
 using namespace CSC8503;
 
-PhysicsSystem::PhysicsSystem(GameWorld &g) : gameWorld(g) {
+PhysicsSystem::PhysicsSystem(GameWorld &g)
+    : gameWorld(g), workerPool(std::make_unique<ThreadPool>()) {
   applyGravity = true;
   dTOffset = 0.0f;
   globalDamping = 0.995f;
   SetGravity(Vector3(0.0f, -9.8f, 0.0f));
+  UpdateSnapshotSource();
 }
 
-PhysicsSystem::~PhysicsSystem() {}
+PhysicsSystem::~PhysicsSystem() {
+  StopThread();
+  gameWorld.SetPhysicsSnapshots(nullptr);
+}
 
-void PhysicsSystem::SetGravity(const Vector3 &g) { gravity = g; }
+void PhysicsSystem::SetGravity(const Vector3 &g) {
+  BetweenSteps([this, g] { gravity = g; });
+}
+
+void PhysicsSystem::SetWorkerCount(unsigned workers) {
+  if (workers + 1 == workerPool->GetThreadCount()) {
+    return;
+  }
+  workerPool = std::make_unique<ThreadPool>(workers);
+}
 
 /*
 
@@ -34,147 +50,640 @@ is expanded to allow objects to be removed from the world,
 you'll need to iterate through this collisions list to remove
 any collisions they are in.
 
+While threaded, the step could be using all of it, so the physics thread does
+it before its next step instead.
 */
-void PhysicsSystem::Clear() { allCollisions.clear(); }
+void PhysicsSystem::Clear() {
+  queuedCommands.lock()->clear();
+  if (IsThreaded()) {
+    publishedEvents.lock()->Clear();
+    clearQueued = true;
+    return;
+  }
+  ClearNow();
+}
 
-/*
+void PhysicsSystem::ClearNow() {
+  allCollisions.Clear();
+  broadphaseCollisions.Clear();
+  staticCollisions.Clear();
+  pairHints.Clear();
+  activeContacts.clear();
+  collisionEvents.Clear();
+  collisionFrame = 0;
+
+  ResetBroadPhaseProxies();
+  staticTree.Clear();
+  staticProxies.clear();
+  staticWorldState = -1;
+
+  // Anything still in the world keeps its velocities, but whatever's been
+  // taken out of it might already be gone, so only the world is looked at
+  for (GameObject *o : gameWorld) {
+    if (PhysicsObject *phys = o->GetPhysicsObject()) {
+      phys->LeaveStore();
+    }
+  }
+  bodies.Clear();
+  physicsBodies.clear();
+  bodyIndices.clear();
+  kinematicBodies.clear();
+  bodyWorldState = -1;
+}
 
-This is the core of the physics engine update
+void PhysicsSystem::SetBroadPhaseContainer(BroadPhaseContainer c) {
+  BetweenSteps([this, c] {
+    if (c == broadPhaseContainer) {
+      return;
+    }
+    broadPhaseContainer = c;
+    ResetBroadPhaseProxies();
+  });
+}
 
+/*
+Layers are bits, so either can be several layers at once, and every pairing
+of them is set. The matrix is kept symmetric, so checking a pair only needs
+one side's row.
 */
+void PhysicsSystem::SetLayerCollision(GameObject::Layer a, GameObject::Layer b,
+                                      bool state) {
+  BetweenSteps([this, a, b, state] {
+    auto set = [&](LayerMask rows, LayerMask columns) {
+      for (; rows; rows &= rows - 1) {
+        LayerMask &ignores = layerIgnores[std::countr_zero((unsigned)rows)];
+        ignores = state ? ignores & ~columns : ignores | columns;
+      }
+    };
+    set((LayerMask)a, (LayerMask)b);
+    set((LayerMask)b, (LayerMask)a);
 
-bool useSimpleContainer = false;
+    anyLayerIgnores = false;
+    for (LayerMask ignores : layerIgnores) {
+      anyLayerIgnores |= ignores != 0;
+    }
+    // Pairs the tree is holding on to may not be allowed any more
+    broadPhasePairsDirty = true;
+  });
+}
 
-int constraintIterationCount = 10;
+bool PhysicsSystem::GetLayerCollision(GameObject::Layer a,
+                                      GameObject::Layer b) const {
+  LayerMask ignored = 0;
+  for (LayerMask rows = (LayerMask)a; rows; rows &= rows - 1) {
+    ignored |= layerIgnores[std::countr_zero((unsigned)rows)];
+  }
+  return (ignored & (LayerMask)b) == 0;
+}
 
-// This is the fixed timestep we'd LIKE to have
-const int idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
+bool PhysicsSystem::LayersCollide(const GameObject &a,
+                                  const GameObject &b) const {
+  if (!anyLayerIgnores) {
+    return true;
+  }
+  return GetLayerCollision(a.GetLayers().as_enum(), b.GetLayers().as_enum());
+}
+
+void PhysicsSystem::ResetBroadPhaseProxies() {
+  broadPhaseTree.Clear();
+  broadPhaseSweep.Clear();
+  broadPhaseProxies.clear();
+  broadPhaseWorldState = -1;
+  broadPhasePairsDirty = true;
+}
 
 /*
-This is the fixed update we actually have...
-If physics takes too long it starts to kill the framerate, it'll drop the
-iteration count down until the FPS stabilises, even if that ends up
-being at a low rate.
+
+This is the core of the physics engine update
+
 */
-int realHZ = idealHZ;
-float realDT = idealDT;
+
+int constraintIterationCount = 10;
 
 void PhysicsSystem::Update(float dt) {
-  if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
-    useBroadPhase = !useBroadPhase;
-    std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-  }
-  if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
-    useSimpleContainer = !useSimpleContainer;
-    std::cout << "Setting broad container to " << useSimpleContainer
-              << std::endl;
-  }
-  if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
-    constraintIterationCount--;
-    std::cout << "Setting constraint iterations to " << constraintIterationCount
-              << std::endl;
+  {
+    // A threaded step could be changing these, they can only be read
+    // between steps
+    auto lock = gameWorld.LockWorld();
+    if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
+      bool state = !useBroadPhase;
+      BetweenSteps([this, state] { useBroadPhase = state; });
+      std::cout << "Setting broadphase to " << state << std::endl;
+    }
+    if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
+      switch (broadPhaseContainer) {
+      case BroadPhaseContainer::AABBTree:
+        SetBroadPhaseContainer(BroadPhaseContainer::SweepAndPrune);
+        std::cout << "Setting broad container to SweepAndPrune" << std::endl;
+        break;
+      case BroadPhaseContainer::SweepAndPrune:
+        SetBroadPhaseContainer(BroadPhaseContainer::LooseOctree);
+        std::cout << "Setting broad container to LooseOctree" << std::endl;
+        break;
+      case BroadPhaseContainer::LooseOctree:
+        SetBroadPhaseContainer(BroadPhaseContainer::AABBTree);
+        std::cout << "Setting broad container to AABBTree" << std::endl;
+        break;
+      }
+    }
+    int iterations = constraintIterationCount;
+    if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
+      --iterations;
+    }
+    if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
+      ++iterations;
+    }
+    if (iterations != constraintIterationCount) {
+      BetweenSteps([iterations] { constraintIterationCount = iterations; });
+      std::cout << "Setting constraint iterations to " << iterations
+                << std::endl;
+    }
+    if (Window::GetKeyboard()->KeyPressed(KeyCodes::X)) {
+      if (constraintSolver == ConstraintSolver::Impulse) {
+        SetConstraintSolver(ConstraintSolver::XPBD);
+        std::cout << "Setting constraint solver to XPBD" << std::endl;
+      } else {
+        SetConstraintSolver(ConstraintSolver::Impulse);
+        std::cout << "Setting constraint solver to Impulse" << std::endl;
+      }
+    }
   }
-  if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
-    constraintIterationCount++;
-    std::cout << "Setting constraint iterations to " << constraintIterationCount
-              << std::endl;
+
+  if (IsThreaded()) {
+    // The thread does the stepping, all that's left is handing out what it
+    // found, on the thread gameplay code expects to be called on
+    DispatchCollisionEvents();
+    return;
   }
 
   dTOffset += dt; // We accumulate time delta here - there might be remainders
                   // from previous frame!
 
-  GameTimer t;
-  t.GetTimeDeltaSeconds();
+  float stepDT = 1.0f / stepSettings.stepHz;
+
+  profiler.BeginFrame();
+  BeginSteps();
+
+  int steps = 0;
+  StepLimit limit = StepLimit::None;
+  auto stepsStart = PhysicsProfiler::Clock::now();
+  while (dTOffset > stepDT) {
+    if (steps >= stepSettings.maxSubsteps) {
+      limit = StepLimit::MaxSubsteps;
+      break;
+    }
+    // Don't start a step that looks like it'd take us over the budget, going
+    // by how long the ones so far have taken
+    if (!stepSettings.deterministic && stepSettings.budgetMs > 0.0f &&
+        steps > 0) {
+      std::chrono::duration<float, std::milli> spent =
+          PhysicsProfiler::Clock::now() - stepsStart;
+      if (spent.count() * (steps + 1) / steps > stepSettings.budgetMs) {
+        limit = StepLimit::Budget;
+        break;
+      }
+    }
+
+    if (useInterpolation) {
+      RecordPreviousStates();
+    }
+    Step(stepDT);
+    {
+      PhysicsProfiler::Scope scope(profiler,
+                                   PhysicsProfiler::Phase::IntegrateVelocity);
+      bodies.SyncTransforms();
+    }
+    dTOffset -= stepDT;
+    ++steps;
+  }
+  EndSteps(steps, stepDT);
+
+  /*
+  Whatever's left over gets caught up on later, but only so much of it. If
+  the steps can't keep up, carrying all of it over would make the next frame
+  longer still, and the one after that, until the game grinds to a halt.
+  Past a frame's worth of steps, the time is thrown away instead, and the
+  simulation runs slower than real time rather than falling behind it.
+  */
+  PhysicsProfiler::Frame &counters = profiler.Current();
+  counters.stepLimit = limit;
+  float maxBacklog = stepSettings.maxSubsteps * stepDT;
+  if (dTOffset > maxBacklog) {
+    counters.droppedMs = (dTOffset - maxBacklog) * 1000.0f;
+    dTOffset = maxBacklog;
+  }
+  counters.backlogMs = dTOffset * 1000.0f;
+
+  {
+    PhysicsProfiler::Scope scope(profiler,
+                                 PhysicsProfiler::Phase::DispatchEvents);
+    DispatchCollisionEvents();
+  }
+
+  profiler.EndFrame();
+
+  if (useInterpolation) {
+    // What's left in dTOffset is how far into the next step we already are.
+    // A backlog of more than a step just holds at the latest one
+    using Clock = PhysicsSnapshot::Clock;
+    auto stepTime = Clock::now() - std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<float>(dTOffset));
+    PublishSnapshot(stepTime, stepDT);
+  }
+}
+
+void PhysicsSystem::SetStepSettings(const StepSettings &settings) {
+  stepSettings = settings;
+  stepSettings.stepHz = std::max(stepSettings.stepHz, 1);
+  stepSettings.maxSubsteps = std::max(stepSettings.maxSubsteps, 1);
+}
+
+using Phase = PhysicsProfiler::Phase;
+using Scope = PhysicsProfiler::Scope;
+
+/*
+Everything that only needs doing once however many steps are taken
+*/
+void PhysicsSystem::BeginSteps() {
+  ApplyChanges();
+  ForgetRemoved();
+  if (clearQueued.exchange(false)) {
+    ClearNow();
+  }
+  SyncBodies();
+  ApplyCommands();
 
   if (useBroadPhase) {
+    Scope scope(profiler, Phase::UpdateObjectAABBs);
     UpdateObjectAABBs();
   }
 
-  int iteratorCount = 0;
-  while (dTOffset > realDT) {
-    IntegrateAccel(realDT); // Update accelerations from external forces
+  // Anything that looks at the world itself is done here, so the steps
+  // only ever see what it was like before them
+  {
+    Scope scope(profiler, Phase::BroadPhase);
+    SyncBroadPhaseProxies();
+    SyncStaticTree();
+  }
+  std::vector<Constraint *>::const_iterator first, last;
+  gameWorld.GetConstraintIterators(first, last);
+  stepConstraints.assign(first, last);
+
+  GatherAwakeBodies();
+  profiler.Current().awakeBodies = (int)bodies.Size();
+}
+
+void PhysicsSystem::Step(float dt) {
+  PhysicsProfiler::Frame &counters = profiler.Current();
+  {
+    Scope scope(profiler, Phase::IntegrateAccel);
+    IntegrateAccel(dt); // Update accelerations from external forces
+  }
+  {
+    Scope scope(profiler, Phase::BroadPhase);
     BroadPhase();
+    StaticBroadPhase();
+  }
+  {
+    Scope scope(profiler, Phase::NarrowPhase);
     NarrowPhase();
+  }
+  {
+    Scope scope(profiler, Phase::PrepareContacts);
+    PrepareContacts(dt);
+  }
+  counters.broadPhasePairs +=
+      (int)(broadphaseCollisions.Size() + staticCollisions.Size());
+  counters.contactPairs += (int)narrowPhaseHits.size();
+
+  // This is our simple iterative solver -
+  // we just run things multiple times, slowly moving things forward
+  // and then rechecking that the contacts and constraints have been met
+  float constraintDt = dt / (float)constraintIterationCount;
+  for (int i = 0; i < constraintIterationCount; ++i) {
+    {
+      Scope scope(profiler, Phase::SolveContacts);
+      SolveContacts();
+    }
+    Scope scope(profiler, Phase::UpdateConstraints);
+    UpdateConstraints(constraintDt);
+  }
 
-    // This is our simple iterative solver -
-    // we just run things multiple times, slowly moving things forward
-    // and then rechecking that the constraints have been met
-    float constraintDt = realDT / (float)constraintIterationCount;
-    for (int i = 0; i < constraintIterationCount; ++i) {
-      UpdateConstraints(constraintDt);
+  if (constraintSolver == ConstraintSolver::XPBD) {
+    // Each substep moves everything a little, then pulls the constraints
+    // back into line, keeping whatever velocity that took
+    float substepDt = dt / (float)constraintSubsteps;
+    for (int i = 0; i < constraintSubsteps; ++i) {
+      {
+        Scope scope(profiler, Phase::IntegrateVelocity);
+        IntegrateVelocity(substepDt);
+      }
+      Scope scope(profiler, Phase::UpdateConstraints);
+      SolveConstraintPositions(substepDt);
     }
-    IntegrateVelocity(realDT); // update positions from new velocity changes
+  } else {
+    Scope scope(profiler, Phase::IntegrateVelocity);
+    IntegrateVelocity(dt); // update positions from new velocity changes
+  }
+  {
+    Scope scope(profiler, Phase::IntegrateVelocity);
+    SweepFastBodies();
+  }
+
+  // Nothing outside the physics system sees where things have moved to
+  // until the body store syncs the transforms, which is up to the caller
+  ++contactStep;
+}
+
+void PhysicsSystem::EndSteps(int steps, float dt) {
+  profiler.Current().substeps = steps;
+
+  ClearForces(); // Once we've finished with the forces, reset them to zero
 
-    dTOffset -= realDT;
-    iteratorCount++;
+  if (useSleeping) {
+    Scope scope(profiler, Phase::UpdateSleeping);
+    UpdateSleeping(steps * dt);
+  }
+  {
+    Scope scope(profiler, Phase::UpdateCollisionList);
+    UpdateCollisionList(); // Remove any old collisions
   }
+}
 
+/*
+When threaded, physics steps at its own fixed rate, and a slow frame on the
+game or render side doesn't hold it up, or the other way round.
+
+The world is only locked while the thread picks up what's changed before a
+step and while it hands back what the step did, never for the step itself.
+Gameplay and rendering don't wait on it at all: they read bodies from the
+snapshots published after each step, and changes to bodies go through the
+command queue, to be applied before the next one. Adding, removing and
+querying objects take the lock themselves, so only wait for those two short
+windows, and removed objects aren't deleted until the thread has let go of
+them.
+
+Forces only last the one step they're applied in, where unthreaded they last
+every substep of the frame. The thread steps at the rate in the step settings
+when it's started.
+*/
+void PhysicsSystem::StartThread() {
+  if (IsThreaded()) {
+    return;
+  }
+  int hz = stepSettings.stepHz;
   {
-    BroadPhase();
-    ProjectionNarrowPhase();
+    auto lock = gameWorld.LockWorld();
+    SyncBodies();
+    PublishSnapshot(PhysicsSnapshot::Clock::now(), 1.0f / hz);
+    gameWorld.SetPhysicsCommands(&queuedCommands);
   }
+  threadRunning = true;
+  physicsThread = std::thread([this, hz]() { ThreadLoop(1.0f / hz); });
+  UpdateSnapshotSource();
+}
 
-  ClearForces(); // Once we've finished with the forces, reset them to zero
+void PhysicsSystem::StopThread() {
+  if (!IsThreaded()) {
+    return;
+  }
+  threadRunning = false;
+  physicsThread.join();
+  gameWorld.SetPhysicsCommands(nullptr);
+  publishedEvents.lock()->MoveTo(collisionEvents);
+  UpdateSnapshotSource();
+}
+
+void PhysicsSystem::ThreadLoop(float dt) {
+  using Clock = std::chrono::steady_clock;
+  auto stepTime = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<float>(dt));
+  auto nextStep = Clock::now();
+  float droppedMs = 0.0f;
+
+  while (threadRunning) {
+    {
+      auto lock = gameWorld.LockWorld();
+      profiler.BeginFrame();
+      BeginSteps();
+      RecordPreviousStates();
+    }
+    Step(dt);
+    {
+      auto lock = gameWorld.LockWorld();
+      {
+        Scope scope(profiler, Phase::IntegrateVelocity);
+        bodies.SyncTransforms();
+      }
+      EndSteps(1, dt);
+      profiler.Current().droppedMs = droppedMs;
+      profiler.EndFrame();
+      PublishSnapshot(Clock::now(), dt);
+      collisionEvents.MoveTo(*publishedEvents.lock());
+    }
+
+    // If a step ran over, carry on from now rather than trying to catch up,
+    // otherwise one slow step would turn into a burst of them
+    nextStep += stepTime;
+    auto now = Clock::now();
+    droppedMs = 0.0f;
+    if (nextStep < now) {
+      droppedMs = std::chrono::duration<float, std::milli>(now - nextStep)
+                      .count();
+      nextStep = now;
+    } else {
+      std::this_thread::sleep_until(nextStep);
+    }
+  }
+}
 
-  UpdateCollisionList(); // Remove any old collisions
+void PhysicsSystem::DispatchCollisionEvents() {
+  if (IsThreaded()) {
+    publishedEvents.lock()->MoveTo(dispatchingEvents);
+    dispatchingEvents.Dispatch();
+  } else {
+    collisionEvents.Dispatch();
+  }
+}
 
-  t.Tick();
-  float updateTime = t.GetTimeDeltaSeconds();
+void PhysicsSystem::BetweenSteps(std::function<void()> change) {
+  if (IsThreaded()) {
+    queuedChanges.lock()->push_back(std::move(change));
+  } else {
+    change();
+  }
+}
 
-  // Uh oh, physics is taking too long...
-  if (updateTime > realDT) {
-    realHZ /= 2;
-    realDT *= 2;
-    std::cout << "Dropping iteration count due to long physics time...(now "
-              << realHZ << ")\n";
-  } else if (dt * 2 <
-             realDT) { // we have plenty of room to increase iteration count!
-    int temp = realHZ;
-    realHZ *= 2;
-    realDT /= 2;
+void PhysicsSystem::ApplyChanges() {
+  applyingChanges.clear();
+  std::swap(applyingChanges, queuedChanges.lock().value());
+  for (const std::function<void()> &change : applyingChanges) {
+    change();
+  }
+}
 
-    if (realHZ > idealHZ) {
-      realHZ = idealHZ;
-      realDT = idealDT;
+/*
+Objects taken out of the world while threaded are only let go of here, before
+a step, so nothing can still be using them. Their motion comes back out of the
+body store, and any pairs or events they're in are dropped, as they may be
+about to be deleted. The world's state counter starts again when it's
+cleared, so could come back round to where it was last synced, and every sync
+is made to run again.
+*/
+void PhysicsSystem::ForgetRemoved() {
+  const std::vector<GameObject *> &removed = gameWorld.GetRemovedObjects();
+  if (!removed.empty()) {
+    removedObjects.assign(removed.begin(), removed.end());
+    std::sort(removedObjects.begin(), removedObjects.end());
+    auto gone = [&](GameObject *o) {
+      return std::binary_search(removedObjects.begin(), removedObjects.end(),
+                                o);
+    };
+
+    for (GameObject *o : removedObjects) {
+      if (PhysicsObject *phys = o->GetPhysicsObject()) {
+        phys->LeaveStore();
+      }
     }
-    if (temp != realHZ) {
-      std::cout << "Raising iteration count due to short physics time...(now "
-                << realHZ << ")\n";
+    allCollisions.EraseIf([&](auto, CollisionPair &pair) {
+      return gone(pair.info.a) || gone(pair.info.b);
+    });
+    publishedEvents.lock()->Forget(removedObjects);
+
+    bodyWorldState = -1;
+    broadPhaseWorldState = -1;
+    staticWorldState = -1;
+  }
+  gameWorld.ReleaseRemoved();
+}
+
+void PhysicsSystem::QueueCommand(GameObject &o, PhysicsCommand::Action action) {
+  queuedCommands.lock()->push_back({&o, o.GetWorldID(), action});
+}
+
+/*
+Commands are checked against the list of bodies before they're applied, as the
+object could have been removed (and deleted) since it was queued
+*/
+void PhysicsSystem::ApplyCommands() {
+  applyingCommands.clear();
+  std::swap(applyingCommands, queuedCommands.lock().value());
+
+  for (const PhysicsCommand &c : applyingCommands) {
+    if (c.worldID < 0 || c.worldID >= (int)bodyIndices.size() ||
+        bodyIndices[c.worldID] < 0 ||
+        physicsBodies[bodyIndices[c.worldID]] != c.object) {
+      continue;
     }
+    PhysicsCommand::Apply(*c.object, c.action);
   }
 }
 
+void PhysicsSystem::UseInterpolation(bool state) {
+  useInterpolation = state;
+  UpdateSnapshotSource();
+}
+
+void PhysicsSystem::UpdateSnapshotSource() {
+  gameWorld.SetPhysicsSnapshots(UsingSnapshots() ? &snapshots : nullptr);
+}
+
+/*
+Only awake bodies can move in a step, anything that wasn't recorded just
+before the latest step is drawn where it is
+*/
+void PhysicsSystem::RecordPreviousStates() {
+  previousStates.resize(bodyIndices.size());
+  auto record = [&](GameObject *o) {
+    const Transform &t = o->GetTransform();
+    previousStates[o->GetWorldID()] = {o, contactStep, t.GetPosition(),
+                                       t.GetOrientation()};
+  };
+  for (GameObject *o : bodies.GetObjects()) {
+    record(o);
+  }
+  // Kinematic bodies are moved between steps rather than in them, but it's
+  // still smoother than jumping
+  for (GameObject *o : kinematicBodies) {
+    record(o);
+  }
+}
+
+void PhysicsSystem::PublishSnapshot(
+    PhysicsSnapshot::Clock::time_point stepTime, float stepDT) {
+  PhysicsSnapshot &snapshot = snapshots.GetWriteBuffer();
+  snapshot.bodies.assign(bodyIndices.size(), PhysicsSnapshot::Body());
+  for (GameObject *o : physicsBodies) {
+    const Transform &t = o->GetTransform();
+    PhysicsSnapshot::Body &b = snapshot.bodies[o->GetWorldID()];
+    b = {o, t.GetPosition(), t.GetOrientation(), t.GetScale()};
+    b.linearVelocity = o->GetPhysicsObject()->GetLinearVelocity();
+    b.angularVelocity = o->GetPhysicsObject()->GetAngularVelocity();
+    b.generation = t.GetGeneration();
+
+    const PreviousState *previous = nullptr;
+    if (o->GetWorldID() < (int)previousStates.size()) {
+      const PreviousState &p = previousStates[o->GetWorldID()];
+      if (p.object == o && p.contactStep == contactStep - 1) {
+        previous = &p;
+      }
+    }
+    b.previousPosition = previous ? previous->position : b.position;
+    b.previousOrientation = previous ? previous->orientation : b.orientation;
+  }
+  snapshot.step = contactStep;
+  snapshot.stepTime = stepTime;
+  snapshot.stepDT = stepDT;
+  snapshot.interpolate = useInterpolation;
+  snapshots.Publish();
+}
+
 /*
 Later on we're going to need to keep track of collisions
-across multiple frames, so we store them in a set.
+across multiple frames, so we store them in a cache, keyed by the pair of
+objects.
 
-The first time they are added, we tell the objects they are colliding.
-The frame they are to be removed, we tell them they're no longer colliding.
+The first time they are added, we tell the objects they are colliding, and
+every frame they're still touching after that, that they're still colliding.
+Once they haven't touched for a few frames, we tell them they're no longer
+colliding, and drop them from the cache. The objects aren't told straight
+away, the events are buffered up and dispatched once the update is done.
 
 From this simple mechanism, we we build up gameplay interactions inside the
-OnCollisionBegin / OnCollisionEnd functions (removing health when hit by a
-rocket launcher, gaining a point when the player hits the gold coin, and so on).
+OnCollisionBegin / OnCollisionStay / OnCollisionEnd functions (removing health
+when hit by a rocket launcher, gaining a point when the player hits the gold
+coin, and so on).
 */
 void PhysicsSystem::UpdateCollisionList() {
-  for (auto i = allCollisions.begin(); i != allCollisions.end();) {
-    if ((*i).framesLeft == numCollisionFrames) {
-      i->a->OnCollisionBegin(i->b);
-      i->b->OnCollisionBegin(i->a);
+  allCollisions.EraseIf([&](auto, CollisionPair &pair) {
+    auto &info = pair.info;
+    // Sleeping pairs aren't checked, so whatever they were doing as they went
+    // to sleep carries on. Only those touching that frame are still touching,
+    // any that had already come apart are left to run out as normal
+    if (!IsResting(info.a) || !IsResting(info.b)) {
+      pair.frozen = false;
+    } else if (pair.lastContactFrame == collisionFrame) {
+      pair.frozen = true;
+    }
+    if (pair.frozen) {
+      pair.lastContactFrame = collisionFrame;
     }
 
-    CollisionDetection::CollisionInfo &in =
-        const_cast<CollisionDetection::CollisionInfo &>(*i);
-    in.framesLeft--;
+    if (!pair.begun) {
+      collisionEvents.Push(info.a, info.b, CollisionEvent::Type::Begin);
+      pair.begun = true;
+    } else if (pair.lastContactFrame == collisionFrame) {
+      collisionEvents.Push(info.a, info.b, CollisionEvent::Type::Stay);
+    }
 
-    if ((*i).framesLeft < 0) {
-      i->a->OnCollisionEnd(i->b);
-      i->b->OnCollisionEnd(i->a);
-      i = allCollisions.erase(i);
-    } else {
-      ++i;
+    if (collisionFrame - pair.lastContactFrame >= numCollisionFrames) {
+      collisionEvents.Push(info.a, info.b, CollisionEvent::Type::End);
+      return true;
     }
-  }
+    return false;
+  });
+
+  ++collisionFrame;
 }
 
 void PhysicsSystem::UpdateObjectAABBs() {
@@ -186,146 +695,564 @@ void PhysicsSystem::UpdateObjectAABBs() {
 In tutorial 5, we start determining the correct response to a collision,
 so that objects separate back out.
 
+Every touching pair's manifold is solved together, a little at a time, with
+each pass nudging the impulses towards something that satisfies every contact
+at once. The impulses are accumulated per point and clamped as a whole rather
+than per pass, so a later pass can take back some of an earlier one without
+ever pulling the objects together.
+
 */
-void PhysicsSystem::ImpulseResolveCollision(
-    GameObject &a, GameObject &b, CollisionDetection::ContactPoint &p) const {
-  if (a.GetBoundingVolume()->isTrigger() ||
-      b.GetBoundingVolume()->isTrigger()) {
-    return;
-  }
+static Vector3 ContactVelocity(const PhysicsObject &a, const PhysicsObject &b,
+                               const ContactManifold::Point &p) {
+  Vector3 vA = a.GetLinearVelocity() +
+               Vector::Cross(a.GetAngularVelocity(), p.rA);
+  Vector3 vB = b.GetLinearVelocity() +
+               Vector::Cross(b.GetAngularVelocity(), p.rB);
+  return vB - vA;
+}
 
+void PhysicsSystem::ApplyContactImpulse(GameObject &a, GameObject &b,
+                                        const ContactManifold::Point &p,
+                                        const Vector3 &impulse) {
   auto physA = a.GetPhysicsObject();
   auto physB = b.GetPhysicsObject();
 
-  auto &tA = a.GetTransform();
-  auto &tB = b.GetTransform();
+  physA->ApplyLinearImpulse(-impulse);
+  physB->ApplyLinearImpulse(impulse);
 
-  float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+  physA->ApplyAngularImpulse(Vector::Cross(p.rA, -impulse));
+  physB->ApplyAngularImpulse(Vector::Cross(p.rB, impulse));
+}
 
-  if (totalMass <= 0) {
-    return;
-  }
+/*
+Works out everything about each contact that won't change over the solver
+passes, and applies last step's impulses again to start from (warm starting).
+*/
+void PhysicsSystem::PrepareContacts(float dt) {
+  activeContacts.clear();
 
-  auto relA = p.localA;
-  auto relB = p.localB;
+  for (auto &entry : allCollisions) {
+    CollisionPair &pair = entry.value;
+    ContactManifold &manifold = pair.manifold;
+    if (pair.lastContactStep != contactStep || manifold.pointCount == 0) {
+      continue;
+    }
 
-  auto wA = Vector::Cross(physA->GetAngularVelocity(), relA);
-  auto wB = Vector::Cross(physB->GetAngularVelocity(), relB);
+    GameObject &a = *pair.info.a;
+    GameObject &b = *pair.info.b;
+    auto physA = a.GetPhysicsObject();
+    auto physB = b.GetPhysicsObject();
+    if (!physA || !physB) {
+      continue;
+    }
 
-  auto vA = physA->GetLinearVelocity() + wA;
-  auto vB = physB->GetLinearVelocity() + wB;
+    float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+    if (totalMass <= 0) {
+      continue;
+    }
 
-  auto contactV = vB - vA;
+    pair.restitution = physA->GetElasticity() * physB->GetElasticity();
+    pair.friction = std::sqrt(physA->GetFriction() * physB->GetFriction());
+
+    Matrix3 inertiaA = physA->GetInertiaTensor();
+    Matrix3 inertiaB = physB->GetInertiaTensor();
+
+    for (int i = 0; i < manifold.pointCount; ++i) {
+      ContactManifold::Point &p = manifold.points[i];
+
+      auto effectiveMass = [&](const Vector3 &dir) {
+        Vector3 jA = Vector::Cross(inertiaA * Vector::Cross(p.rA, dir), p.rA);
+        Vector3 jB = Vector::Cross(inertiaB * Vector::Cross(p.rB, dir), p.rB);
+        float k = totalMass + Vector::Dot(jA + jB, dir);
+        return k > 0.0f ? 1.0f / k : 0.0f;
+      };
+
+      p.normalMass = effectiveMass(manifold.normal);
+      p.tangentMass[0] = effectiveMass(manifold.tangents[0]);
+      p.tangentMass[1] = effectiveMass(manifold.tangents[1]);
+
+      // Push out whatever's sunk in past the slop over a few steps, or bounce
+      // back out if it hit hard enough, whichever is more
+      float closing =
+          Vector::Dot(ContactVelocity(*physA, *physB, p), manifold.normal);
+      float push =
+          contactBaumgarte / dt * std::max(p.penetration - contactSlop, 0.0f);
+      float bounce =
+          closing < -restitutionThreshold ? -pair.restitution * closing : 0.0f;
+      p.bias = std::max(push, bounce);
+
+      Vector3 impulse = manifold.normal * p.normalImpulse +
+                        manifold.tangents[0] * p.tangentImpulse[0] +
+                        manifold.tangents[1] * p.tangentImpulse[1];
+      ApplyContactImpulse(a, b, p, impulse);
+    }
 
-  float impulseF = Vector::Dot(contactV, p.normal);
+    activeContacts.push_back(&pair);
+    profiler.Current().contactPoints += manifold.pointCount;
+  }
+}
 
-  auto jA = Vector::Cross(
-      physA->GetInertiaTensor() * Vector::Cross(relA, p.normal), relA);
-  auto jB = Vector::Cross(
-      physB->GetInertiaTensor() * Vector::Cross(relB, p.normal), relB);
+/*
+One solver pass over every active contact. Friction goes first, so the normal
+impulse, which matters most, gets the last word.
+*/
+void PhysicsSystem::SolveContacts() {
+  for (CollisionPair *pair : activeContacts) {
+    GameObject &a = *pair->info.a;
+    GameObject &b = *pair->info.b;
+    auto physA = a.GetPhysicsObject();
+    auto physB = b.GetPhysicsObject();
+    ContactManifold &manifold = pair->manifold;
+
+    for (int i = 0; i < manifold.pointCount; ++i) {
+      ContactManifold::Point &p = manifold.points[i];
+
+      float maxFriction = pair->friction * p.normalImpulse;
+      for (int t = 0; t < 2; ++t) {
+        const Vector3 &tangent = manifold.tangents[t];
+        float v = Vector::Dot(ContactVelocity(*physA, *physB, p), tangent);
+        float old = p.tangentImpulse[t];
+        p.tangentImpulse[t] = std::clamp(old - v * p.tangentMass[t],
+                                         -maxFriction, maxFriction);
+        ApplyContactImpulse(a, b, p, tangent * (p.tangentImpulse[t] - old));
+      }
 
-  float angularEffect = Vector::Dot(jA + jB, p.normal);
+      float v = Vector::Dot(ContactVelocity(*physA, *physB, p),
+                            manifold.normal);
+      float old = p.normalImpulse;
+      p.normalImpulse = std::max(old + (p.bias - v) * p.normalMass, 0.0f);
+      ApplyContactImpulse(a, b, p,
+                          manifold.normal * (p.normalImpulse - old));
+    }
+  }
+}
 
-  float cRestitution = 0.66f;
+/*
 
-  float j = (-(1.0f + cRestitution) * impulseF) / (totalMass + angularEffect);
+Later, we replace the BasicCollisionDetection method with a broadphase
+and a narrowphase collision detection method. In the broad phase, we
+split the world up using an acceleration structure, so that we can only
+compare the collisions that we absolutely need to.
 
-  auto fullImpulse = p.normal * j;
+*/
+void PhysicsSystem::BroadPhase() {
+  switch (broadPhaseContainer) {
+  case BroadPhaseContainer::AABBTree:
+    TreeBroadPhase();
+    break;
+  case BroadPhaseContainer::SweepAndPrune:
+    SweepBroadPhase();
+    break;
+  case BroadPhaseContainer::LooseOctree:
+    OctreeBroadPhase();
+    break;
+  }
+}
 
-  physA->ApplyLinearImpulse(-fullImpulse);
-  physB->ApplyLinearImpulse(fullImpulse);
+/*
+The tree is kept between frames, so this only has to add and remove objects
+when the world changes. Objects are given fat bounds that cover where they're
+heading, and only get reinserted once they leave them. If nothing was
+reinserted, the overlapping pairs can't have changed either, so last step's
+pairs are reused as-is.
+*/
+void PhysicsSystem::TreeBroadPhase() {
+  for (auto i : physicsBodies) {
+    auto proxy = broadPhaseProxies.find(i->GetWorldID());
+    if (proxy == broadPhaseProxies.end()) {
+      continue;
+    }
 
-  physA->ApplyAngularImpulse(Vector::Cross(relA, -fullImpulse));
-  physB->ApplyAngularImpulse(Vector::Cross(relB, fullImpulse));
-}
+    Vector3 halfSize;
+    if (!i->GetBroadphaseAABB(halfSize)) {
+      continue;
+    }
+
+    Vector3 displacement;
+    if (auto phys = i->GetPhysicsObject()) {
+      displacement = phys->GetLinearVelocity() / (float)stepSettings.stepHz;
+    }
 
-void PhysicsSystem::ProjectionNarrowPhase() {
-  for (auto cInfo : broadphaseCollisions) {
-    if (CollisionDetection::ObjectIntersection(cInfo.a, cInfo.b, cInfo)) {
-      cInfo.framesLeft = numCollisionFrames;
-      ProjectionResolveCollision(*cInfo.a, *cInfo.b, cInfo.point);
+    Bounds bounds =
+        Bounds::FromCentre(i->GetTransform().GetPosition(), halfSize);
+    if (broadPhaseTree.Move(proxy->second.proxy, bounds, displacement)) {
+      broadPhasePairsDirty = true;
     }
   }
+
+  if (!broadPhasePairsDirty) {
+    return;
+  }
+  broadPhasePairsDirty = false;
+
+  broadphaseCollisions.Clear();
+  broadPhaseTree.OperateOnPairs(
+      [&](GameObject *a, GameObject *b) {
+        AddBroadPhasePair(broadphaseCollisions, a, b);
+      });
 }
 
-void PhysicsSystem::ProjectionResolveCollision(
-    GameObject &a, GameObject &b,
-    const CollisionDetection::ContactPoint &p) const {
+/*
+Every object's endpoints are refreshed every step, but as the order barely
+changes between steps, re-sorting them is close to linear.
+*/
+void PhysicsSystem::SweepBroadPhase() {
+  for (auto i : physicsBodies) {
+    auto proxy = broadPhaseProxies.find(i->GetWorldID());
+    if (proxy == broadPhaseProxies.end()) {
+      continue;
+    }
 
-  if (a.GetBoundingVolume()->isTrigger() ||
-      b.GetBoundingVolume()->isTrigger()) {
-    return;
+    Vector3 halfSize;
+    if (!i->GetBroadphaseAABB(halfSize)) {
+      continue;
+    }
+
+    broadPhaseSweep.Move(
+        proxy->second.proxy,
+        Bounds::FromCentre(i->GetTransform().GetPosition(), halfSize));
   }
+  broadPhaseSweep.Update();
 
-  auto physA = a.GetPhysicsObject();
-  auto physB = b.GetPhysicsObject();
-  auto &tA = a.GetTransform();
-  auto &tB = b.GetTransform();
-  float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
-  if (totalMass <= 0) {
+  broadphaseCollisions.Clear();
+  broadPhaseSweep.OperateOnPairs(
+      [&](GameObject *a, GameObject *b) {
+        AddBroadPhasePair(broadphaseCollisions, a, b);
+      });
+}
+
+/*
+Only does any work when objects have been added to or removed from the world
+since the last sync, and only for whichever persistent container is in use.
+*/
+void PhysicsSystem::SyncBroadPhaseProxies() {
+  if (broadPhaseContainer == BroadPhaseContainer::LooseOctree ||
+      broadPhaseWorldState == gameWorld.GetWorldStateID()) {
     return;
   }
+  broadPhaseWorldState = gameWorld.GetWorldStateID();
+  ++broadPhaseSyncStamp;
 
-  constexpr float multiplier = 0.25f;
+  bool useTree = broadPhaseContainer == BroadPhaseContainer::AABBTree;
 
-  // Projection
-  tA.SetPosition(tA.GetPosition() - (p.normal * p.penetration * multiplier *
-                                     (physA->GetInverseMass() / totalMass)));
-  tB.SetPosition(tB.GetPosition() + (p.normal * p.penetration * multiplier *
-                                     (physB->GetInverseMass() / totalMass)));
+  auto removeProxy = [&](int proxy) {
+    if (useTree) {
+      broadPhaseTree.Remove(proxy);
+    } else {
+      broadPhaseSweep.Remove(proxy);
+    }
+  };
+
+  for (auto i : physicsBodies) {
+    Vector3 halfSize;
+    if (!i->GetBroadphaseAABB(halfSize)) {
+      continue;
+    }
+
+    auto existing = broadPhaseProxies.find(i->GetWorldID());
+    if (existing != broadPhaseProxies.end()) {
+      // IDs restart if the world is cleared without clearing us too
+      int proxy = existing->second.proxy;
+      GameObject *current = useTree ? broadPhaseTree.GetObject(proxy)
+                                    : broadPhaseSweep.GetObject(proxy);
+      if (current == i) {
+        existing->second.syncStamp = broadPhaseSyncStamp;
+        continue;
+      }
+      removeProxy(proxy);
+    }
+
+    Bounds bounds =
+        Bounds::FromCentre(i->GetTransform().GetPosition(), halfSize);
+    int proxy = useTree ? broadPhaseTree.Insert(i, bounds)
+                        : broadPhaseSweep.Insert(i, bounds);
+    broadPhaseProxies[i->GetWorldID()] = {proxy, broadPhaseSyncStamp};
+  }
+
+  for (auto it = broadPhaseProxies.begin(); it != broadPhaseProxies.end();) {
+    if (it->second.syncStamp != broadPhaseSyncStamp) {
+      removeProxy(it->second.proxy);
+      it = broadPhaseProxies.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  broadPhasePairsDirty = true;
 }
 
 /*
+The octree is cheap enough to build that it's just built again each step, and
+fits itself around wherever the objects are, so nothing is ever outside it.
+*/
+void PhysicsSystem::OctreeBroadPhase() {
+  broadphaseCollisions.Clear();
+  broadPhaseOctree.Clear();
 
-Later, we replace the BasicCollisionDetection method with a broadphase
-and a narrowphase collision detection method. In the broad phase, we
-split the world up using an acceleration structure, so that we can only
-compare the collisions that we absolutely need to.
+  for (auto i : physicsBodies) {
+    Vector3 halfSize;
+    if (!i->GetBroadphaseAABB(halfSize)) {
+      continue;
+    }
+    broadPhaseOctree.Insert(
+        i, Bounds::FromCentre(i->GetTransform().GetPosition(), halfSize));
+  }
+  broadPhaseOctree.Build();
+
+  broadPhaseOctree.OperateOnPairs(
+      [&](GameObject *a, GameObject *b) {
+        AddBroadPhasePair(broadphaseCollisions, a, b);
+      });
+
+  // The octree rebuilds its pairs from scratch every time
+  broadPhasePairsDirty = true;
+}
 
+/*
+Static objects sit in a tree of their own, built once as they're added to the
+world and never touched again until the world changes. They can't hit each
+other, so rather than finding every overlapping pair, each awake dynamic body
+just asks the tree what it's touching. Sleeping bodies are left out, they
+can't have started touching anything since they went to sleep.
 */
-void PhysicsSystem::BroadPhase() {
-  broadphaseCollisions.clear();
-  QuadTree<GameObject *> tree(Vector2(1024, 1024), 7, 6);
+void PhysicsSystem::StaticBroadPhase() {
+  staticCollisions.Clear();
+  for (GameObject *o : bodies.GetObjects()) {
+    Vector3 halfSize;
+    if (!o->GetBroadphaseAABB(halfSize)) {
+      continue;
+    }
+    Bounds bounds =
+        Bounds::FromCentre(o->GetTransform().GetPosition(), halfSize);
+    staticTree.Query(bounds, [&](int proxy) {
+      AddBroadPhasePair(staticCollisions, o, staticTree.GetObject(proxy));
+      return true;
+    });
+  }
+}
+
+void PhysicsSystem::SyncStaticTree() {
+  if (staticWorldState == gameWorld.GetWorldStateID()) {
+    return;
+  }
+  staticWorldState = gameWorld.GetWorldStateID();
+  ++staticSyncStamp;
 
   for (auto i : gameWorld) {
-    Vector3 size;
-    if (!i->GetBroadphaseAABB(size))
-      return;
+    Vector3 halfSize;
+    if (!IsStatic(i) || !i->GetBroadphaseAABB(halfSize)) {
+      continue;
+    }
 
-    auto pos = i->GetTransform().GetPosition();
-    tree.Insert(i, pos, size);
+    uint32_t generation = i->GetTransform().GetGeneration();
+    auto existing = staticProxies.find(i->GetWorldID());
+    if (existing != staticProxies.end()) {
+      StaticProxy &p = existing->second;
+      if (staticTree.GetObject(p.proxy) == i && p.generation == generation) {
+        p.syncStamp = staticSyncStamp;
+        continue;
+      }
+      staticTree.Remove(p.proxy);
+    }
+
+    int proxy = staticTree.Insert(
+        i, Bounds::FromCentre(i->GetTransform().GetPosition(), halfSize));
+    staticProxies[i->GetWorldID()] = {proxy, staticSyncStamp, generation};
   }
 
-  tree.OperateOnContents([&](auto &objects) {
-    CollisionDetection::CollisionInfo cInfo;
-    for (auto it = objects.begin(); it != objects.end(); ++it) {
-      for (auto jt = std::next(it); jt != objects.end(); ++jt) {
-        cInfo.a = std::min(it->object, jt->object);
-        cInfo.b = std::max(it->object, jt->object);
-        broadphaseCollisions.insert(cInfo);
-      }
+  for (auto it = staticProxies.begin(); it != staticProxies.end();) {
+    if (it->second.syncStamp != staticSyncStamp) {
+      staticTree.Remove(it->second.proxy);
+      it = staticProxies.erase(it);
+    } else {
+      ++it;
     }
-  });
+  }
+}
+
+/*
+Pairs are always stored lowest world ID first, so the same pair of objects
+always collides the same way round. If a container ever offers the same
+pair twice, the cache keeps only one of them.
+
+Pairs on layers that don't collide never make it this far. Nor do two static
+objects, which are never in the same container. The tree keeps its pairs
+between steps, so an object changing layers is only seen once its pairs are
+found again.
+*/
+void PhysicsSystem::AddBroadPhasePair(
+    PairCache<CollisionDetection::CollisionInfo> &pairs, GameObject *a,
+    GameObject *b) {
+  if (!LayersCollide(*a, *b)) {
+    return;
+  }
+  if (a->GetWorldID() > b->GetWorldID()) {
+    std::swap(a, b);
+  }
+
+  auto [cInfo, added] = pairs.Insert(
+      PairCache<CollisionDetection::CollisionInfo>::MakeKey(a->GetWorldID(),
+                                                            b->GetWorldID()));
+  if (added) {
+    cInfo.a = a;
+    cInfo.b = b;
+  }
 }
 
 /*
 
 The broadphase will now only give us likely collisions, so we can now go through
 them, and work out if they are truly colliding, and if so, add them into the
-main collision list
+main collision list, updating each pair's contact manifold as we go
+
+Before testing, the pairs are sorted into buckets by which volumes they are,
+so the common pairings can be tested a handful at a time, a pair per SIMD
+lane, by CollisionDetection::BatchIntersection. Pairs with a trigger get a
+bucket of their own, and are only checked for overlap.
+
+The intersection tests only read from the objects, so they're split across the
+worker pool, with each thread keeping its hits in its own buffer. The hits are
+then put back into broadphase order before touching the collision list, so
+everything after this happens in exactly the same order whichever thread
+found what, and the result is the same as doing it all on one thread.
 */
 void PhysicsSystem::NarrowPhase() {
-  for (auto cInfo : broadphaseCollisions) {
-    if (CollisionDetection::ObjectIntersection(cInfo.a, cInfo.b, cInfo)) {
-      cInfo.framesLeft = numCollisionFrames;
-      bool aTrigger = cInfo.a->GetBoundingVolume()->isTrigger();
-      bool bTrigger = cInfo.b->GetBoundingVolume()->isTrigger();
-      if (!aTrigger && !bTrigger) {
-        ImpulseResolveCollision(*cInfo.a, *cInfo.b, cInfo.point);
-      }
-      allCollisions.insert(cInfo);
+  using PairKind = CollisionDetection::PairKind;
+  constexpr int BatchLanes = CollisionDetection::BatchLanes;
+
+  // The static pairs follow on from the dynamic ones
+  size_t dynamicCount = broadphaseCollisions.Size();
+  size_t candidateCount = dynamicCount + staticCollisions.Size();
+  auto dynamicPairs = broadphaseCollisions.begin();
+  auto staticPairs = staticCollisions.begin();
+  auto candidates = [&](size_t i) -> const auto & {
+    return i < dynamicCount ? dynamicPairs[i] : staticPairs[i - dynamicCount];
+  };
+
+  for (auto &bucket : narrowPhaseBuckets) {
+    bucket.clear();
+  }
+  for (size_t i = 0; i < candidateCount; ++i) {
+    const auto &cInfo = candidates(i).value;
+    // Kinematic bodies can overlap each other all they like
+    if ((IsResting(cInfo.a) && IsResting(cInfo.b)) ||
+        (!IsDynamic(cInfo.a) && !IsDynamic(cInfo.b))) {
+      continue;
+    }
+    narrowPhaseBuckets[(int)CollisionDetection::GetPairKind(*cInfo.a,
+                                                            *cInfo.b)]
+        .push_back(i);
+  }
+  narrowPhaseOrder.clear();
+  for (int kind = 0; kind < CollisionDetection::PairKindCount; ++kind) {
+    for (size_t i : narrowPhaseBuckets[kind]) {
+      narrowPhaseOrder.push_back({i, (PairKind)kind});
+    }
+  }
+
+  narrowPhaseBuffers.resize(workerPool->GetThreadCount());
+  for (auto &buffer : narrowPhaseBuffers) {
+    buffer.hits.clear();
+    buffer.hints.clear();
+  }
+
+  workerPool->ParallelFor(
+      narrowPhaseOrder.size(), narrowPhaseChunk,
+      [&](size_t begin, size_t end, unsigned thread) {
+        auto &buffer = narrowPhaseBuffers[thread];
+        for (size_t i = begin; i < end;) {
+          PairKind kind = narrowPhaseOrder[i].kind;
+
+          // These want last step's hint, so go one at a time
+          if (kind == PairKind::Other) {
+            size_t index = narrowPhaseOrder[i].candidate;
+            const auto &candidate = candidates(index);
+            auto cInfo = candidate.value;
+            if (auto cached = pairHints.Find(candidate.key)) {
+              cInfo.separatingAxis = cached->separatingAxis;
+              cInfo.searchDirection = cached->searchDirection;
+            }
+            if (CollisionDetection::ObjectIntersection(cInfo.a, cInfo.b,
+                                                       cInfo)) {
+              buffer.hits.push_back({index, cInfo});
+            }
+            if (cInfo.separatingAxis >= 0 ||
+                Vector::Dot(cInfo.searchDirection, cInfo.searchDirection) >
+                    0.0f) {
+              buffer.hints.push_back(
+                  {index, cInfo.separatingAxis, cInfo.searchDirection});
+            }
+            ++i;
+            continue;
+          }
+
+          CollisionDetection::CollisionInfo batch[BatchLanes];
+          size_t batchCandidates[BatchLanes];
+          int count = 0;
+          for (; count < BatchLanes && i < end &&
+                 narrowPhaseOrder[i].kind == kind;
+               ++count, ++i) {
+            batchCandidates[count] = narrowPhaseOrder[i].candidate;
+            batch[count] = candidates(batchCandidates[count]).value;
+          }
+          int hits = CollisionDetection::BatchIntersection(kind, batch, count);
+          for (int lane = 0; lane < count; ++lane) {
+            if (hits & (1 << lane)) {
+              buffer.hits.push_back({batchCandidates[lane], batch[lane]});
+            }
+          }
+        }
+      });
+
+  // Pairs that weren't tested, or left no hint, have nothing worth keeping
+  for (auto &buffer : narrowPhaseBuffers) {
+    for (auto &hint : buffer.hints) {
+      pairHints.Insert(candidates(hint.candidate).key).first = {
+          hint.separatingAxis, hint.searchDirection, contactStep};
     }
   }
+  pairHints.EraseIf([&](auto, const PairHint &cached) {
+    return cached.step != contactStep;
+  });
+
+  narrowPhaseHits.clear();
+  for (auto &buffer : narrowPhaseBuffers) {
+    narrowPhaseHits.insert(narrowPhaseHits.end(), buffer.hits.begin(),
+                           buffer.hits.end());
+  }
+  std::sort(narrowPhaseHits.begin(), narrowPhaseHits.end(),
+            [](const NarrowPhaseHit &a, const NarrowPhaseHit &b) {
+              return a.candidate < b.candidate;
+            });
+
+  for (auto &hit : narrowPhaseHits) {
+    AddContact(candidates(hit.candidate).key, hit.info);
+  }
+}
+
+void PhysicsSystem::AddContact(uint64_t key,
+                               const CollisionDetection::CollisionInfo &cInfo) {
+  auto &pair = allCollisions.Insert(key).first;
+  // Points from before a gap in contact are no use, and nor are ones from
+  // the pair the other way round
+  if (pair.lastContactStep != contactStep - 1 || pair.info.a != cInfo.a) {
+    pair.manifold.Clear();
+  }
+  pair.info = cInfo;
+  pair.lastContactFrame = collisionFrame;
+  pair.lastContactStep = contactStep;
+
+  bool aTrigger = cInfo.a->GetBoundingVolume()->isTrigger();
+  bool bTrigger = cInfo.b->GetBoundingVolume()->isTrigger();
+  if (aTrigger || bTrigger) {
+    return;
+  }
+
+  const Transform &tA = cInfo.a->GetTransform();
+  const Transform &tB = cInfo.b->GetTransform();
+  const CollisionDetection::ContactPoint &p = cInfo.point;
+  pair.manifold.Refresh(tA, tB);
+  pair.manifold.AddPoint(tA, tB, p.localA, p.localB, p.normal, p.penetration);
 }
 
 /*
@@ -338,85 +1265,331 @@ based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
 */
 void PhysicsSystem::IntegrateAccel(float dt) {
-  for (auto i : gameWorld) {
-    auto objP = i->GetPhysicsObject();
-    if (!objP) {
+  for (size_t i = 0; i < bodies.Size(); ++i) {
+    auto &obj = *bodies.GetObjects()[i]->GetPhysicsObject();
+
+    obj.UpdateInertiaTensor();
+
+    bodies.SetForce(i, obj.GetForce());
+    bodies.SetInverseMass(i, obj.GetInverseMass());
+    bodies.SetAngularAcceleration(i, obj.GetInertiaTensor() * obj.GetTorque());
+  }
+
+  bodies.IntegrateAccel(applyGravity ? gravity : Vector3(), dt);
+}
+
+/*
+This function integrates linear and angular velocity into
+position and orientation. It may be called multiple times
+throughout a physics update, to slowly move the objects through
+the world, looking for collisions.
+
+The body store owns the positions and velocities being integrated, so all
+that's left to hand it is what the objects' settings want done to them.
+*/
+void PhysicsSystem::IntegrateVelocity(float dt) {
+  for (size_t i = 0; i < bodies.Size(); ++i) {
+    auto &obj = *bodies.GetObjects()[i]->GetPhysicsObject();
+
+    obj.ClampVelocities();
+
+    PhysicsObject::PhysicsMaterial &material = obj.GetMaterial();
+    bodies.SetDamping(i, 1.0f - ((1.0f - material.linearDamping) * dt),
+                      1.0f - ((1.0f - material.angularDamping) * dt));
+  }
+
+  bodies.IntegrateVelocity(dt);
+}
+
+/*
+A body moving more than its own size in a step can end up past something thin
+without ever having overlapped it, so the discrete tests never see it. Bodies
+flagged for continuous collision are swept from where they were to where
+they've just been integrated to, and stopped just inside the first thing in
+the way. The contact is then found and solved as normal next step. Only what
+the static tree and the broadphase have overlapping the swept bounds is
+tested, so it costs about the same however big the world is.
+
+Only the biggest sphere that fits inside the body is swept, so it's never
+stopped short of something it wouldn't have hit, and rotation is ignored.
+*/
+namespace {
+float InnerRadius(const CollisionVolume &volume) {
+  switch (volume.type) {
+  case VolumeType::Sphere:
+    return ((const SphereVolume &)volume).GetRadius();
+  case VolumeType::Capsule:
+    return ((const CapsuleVolume &)volume).GetRadius();
+  case VolumeType::AABB:
+    return Vector::GetMinElement(
+        ((const AABBVolume &)volume).GetHalfDimensions());
+  case VolumeType::OBB:
+    return Vector::GetMinElement(
+        ((const OBBVolume &)volume).GetHalfDimensions());
+  default:
+    return 0.0f;
+  }
+}
+} // namespace
+
+void PhysicsSystem::SweepFastBodies() {
+  for (size_t i = 0; i < bodies.Size(); ++i) {
+    GameObject *object = bodies.GetObjects()[i];
+    const CollisionVolume *volume = object->GetBoundingVolume();
+    if (!object->GetPhysicsObject()->UsesContinuousCollision() || !volume ||
+        volume->isTrigger()) {
       continue;
     }
 
-    auto &obj = *objP;
+    float radius = InnerRadius(*volume);
+    Vector3 start = object->GetTransform().GetPosition();
+    Vector3 motion = bodies.GetPosition(i) - start;
+    float distance = Vector::Length(motion);
+    if (radius <= 0.0f || distance <= radius * ccdMotionThreshold) {
+      continue;
+    }
 
-    float invMass = obj.GetInverseMass();
+    float extent = volume->GetMaxExtent();
+    Bounds swept = Bounds::Union(
+        Bounds::FromCentre(start, Vector3(extent, extent, extent)),
+        Bounds::FromCentre(start + motion, Vector3(extent, extent, extent)));
 
-    auto v = obj.GetLinearVelocity();
-    auto f = obj.GetForce();
-    auto a = f * invMass;
+    float earliest = 1.0f;
+    auto sweep = [&](GameObject *other) {
+      if (other == object || other->GetBoundingVolume()->isTrigger() ||
+          !LayersCollide(*object, *other)) {
+        return true;
+      }
+      float hit;
+      if (CollisionDetection::SweptSphereIntersection(start, motion, radius,
+                                                      *other, hit)) {
+        earliest = std::min(earliest, hit);
+      }
+      return true;
+    };
+
+    // Everything else is still where the broadphase saw it this step
+    staticTree.Query(swept, [&](int proxy) {
+      return sweep(staticTree.GetObject(proxy));
+    });
+    switch (broadPhaseContainer) {
+    case BroadPhaseContainer::AABBTree:
+      broadPhaseTree.Query(swept, [&](int proxy) {
+        return sweep(broadPhaseTree.GetObject(proxy));
+      });
+      break;
+    case BroadPhaseContainer::SweepAndPrune:
+      broadPhaseSweep.Query(swept, sweep);
+      break;
+    case BroadPhaseContainer::LooseOctree:
+      broadPhaseOctree.Query(swept, [&](const auto &entry) {
+        return sweep(entry.object);
+      });
+      break;
+    }
 
-    if (applyGravity && invMass > 0) {
-      a += gravity;
+    if (earliest < 1.0f) {
+      float allowed = std::min(distance, earliest * distance + ccdPenetration);
+      bodies.SetPosition(i, start + motion * (allowed / distance));
     }
+  }
+}
 
-    v += a * dt;
-    obj.SetLinearVelocity(v);
+/*
+The list of every object with physics only needs rebuilding when the world
+changes. Static objects are left out, so nothing that goes through every body
+each step ever has to look at them
+*/
+void PhysicsSystem::SyncBodies() {
+  if (bodyWorldState == gameWorld.GetWorldStateID()) {
+    return;
+  }
+  bodyWorldState = gameWorld.GetWorldStateID();
 
-    auto torque = obj.GetTorque();
-    auto w = obj.GetAngularVelocity();
+  physicsBodies.clear();
+  bodyIndices.clear();
+  kinematicBodies.clear();
+  for (auto i : gameWorld) {
+    if (IsStatic(i)) {
+      continue;
+    }
+    if (i->GetWorldID() >= (int)bodyIndices.size()) {
+      bodyIndices.resize(i->GetWorldID() + 1, -1);
+    }
+    bodyIndices[i->GetWorldID()] = (int)physicsBodies.size();
+    physicsBodies.push_back(i);
+    if (!i->GetPhysicsObject()->IsDynamic()) {
+      kinematicBodies.push_back(i);
+    }
+  }
+}
 
-    obj.UpdateInertiaTensor();
+/*
+Only dynamic objects that are awake go in the body store, so sleeping ones
+cost nothing to integrate. Anything that's been moved by something other than
+physics while asleep, like the network or gameplay code, is woken first, and
+anything that's gone to sleep takes its state back out of the store.
+*/
+void PhysicsSystem::GatherAwakeBodies() {
+  awakeBodies.clear();
+
+  for (auto i : physicsBodies) {
+    auto phys = i->GetPhysicsObject();
+    if (phys->IsDynamic() && phys->IsAsleep() &&
+        phys->GetSleepGeneration() != i->GetTransform().GetGeneration()) {
+      phys->Wake();
+    }
+    if (phys->IsDynamic() && !phys->IsAsleep()) {
+      awakeBodies.push_back(i);
+    } else {
+      phys->LeaveStore();
+    }
+  }
+  bodies.Gather(awakeBodies);
+}
 
-    auto alpha = obj.GetInertiaTensor() * torque;
+/*
+Kinematic bodies could be moved at any time, so are never resting
+*/
+bool PhysicsSystem::IsResting(const GameObject *o) {
+  auto phys = o->GetPhysicsObject();
+  if (!phys || phys->GetBodyType() == PhysicsObject::BodyType::Static) {
+    return true;
+  }
+  return phys->IsDynamic() && phys->IsAsleep();
+}
 
-    w += alpha * dt;
+/*
+Anything without physics can't move either
+*/
+bool PhysicsSystem::IsStatic(const GameObject *o) {
+  auto phys = o->GetPhysicsObject();
+  return !phys || phys->GetBodyType() == PhysicsObject::BodyType::Static;
+}
 
-    obj.SetAngularVelocity(w);
-  }
+bool PhysicsSystem::IsDynamic(const GameObject *o) {
+  auto phys = o->GetPhysicsObject();
+  return phys && phys->IsDynamic();
 }
 
 /*
-This function integrates linear and angular velocity into
-position and orientation. It may be called multiple times
-throughout a physics update, to slowly move the objects through
-the world, looking for collisions.
+Objects are grouped into islands of things that are touching or constrained
+together, and an island only goes to sleep once everything in it has been
+slow for long enough. If anything in a sleeping island gets woken up, the rest
+of it is woken along with it next frame, so stacks don't get left floating.
+
+Objects that can't move don't join islands, otherwise every object resting
+on the floor would be in the same one.
 */
-void PhysicsSystem::IntegrateVelocity(float dt) {
+void PhysicsSystem::UpdateSleeping(float dt) {
+  if (dt <= 0.0f) {
+    return;
+  }
 
-  for (auto i : gameWorld) {
-    auto objP = i->GetPhysicsObject();
+  const float linearSq = sleepLinearVelocity * sleepLinearVelocity;
+  const float angularSq = sleepAngularVelocity * sleepAngularVelocity;
 
-    if (!objP) {
+  for (auto i : physicsBodies) {
+    auto phys = i->GetPhysicsObject();
+    if (!phys->IsDynamic() || phys->IsAsleep()) {
       continue;
     }
+    bool slow =
+        Vector::LengthSquared(phys->GetLinearVelocity()) < linearSq &&
+        Vector::LengthSquared(phys->GetAngularVelocity()) < angularSq;
+    phys->SetSleepTimer(slow ? phys->GetSleepTimer() + dt : 0.0f);
+  }
 
-    auto &obj = *objP;
-
-    PhysicsObject::PhysicsMaterial &material = obj.GetMaterial();
-    const float frameLinearDamping =
-        1.0f - ((1.0f - material.linearDamping) * dt);
+  islandParents.resize(physicsBodies.size());
+  for (int i = 0; i < (int)islandParents.size(); ++i) {
+    islandParents[i] = i;
+  }
 
-    obj.ClampVelocities();
+  auto find = [&](int i) {
+    while (islandParents[i] != i) {
+      islandParents[i] = islandParents[islandParents[i]];
+      i = islandParents[i];
+    }
+    return i;
+  };
+
+  // Contacts and constraints can still point at objects that have been
+  // taken out of the world, which have no body to link
+  auto bodyIndex = [&](const GameObject *o) {
+    int id = o->GetWorldID();
+    if (id < 0 || id >= (int)bodyIndices.size() || bodyIndices[id] < 0 ||
+        physicsBodies[bodyIndices[id]] != o) {
+      return -1;
+    }
+    return bodyIndices[id];
+  };
 
-    auto &transform = i->GetTransform();
+  auto link = [&](const GameObject *a, const GameObject *b) {
+    if (!a || !b) {
+      return;
+    }
+    auto physA = a->GetPhysicsObject();
+    auto physB = b->GetPhysicsObject();
+    if (!physA || !physB || physA->GetInverseMass() <= 0.0f ||
+        physB->GetInverseMass() <= 0.0f) {
+      return;
+    }
+    int indexA = bodyIndex(a);
+    int indexB = bodyIndex(b);
+    if (indexA < 0 || indexB < 0) {
+      return;
+    }
+    islandParents[find(indexA)] = find(indexB);
+  };
 
-    auto pos = transform.GetPosition();
-    auto v = obj.GetLinearVelocity();
-    pos += v * dt;
-    transform.SetPosition(pos);
+  for (auto &entry : allCollisions) {
+    auto &info = entry.value.info;
+    if (info.a->GetBoundingVolume()->isTrigger() ||
+        info.b->GetBoundingVolume()->isTrigger()) {
+      continue;
+    }
+    link(info.a, info.b);
+  }
 
-    v *= frameLinearDamping;
-    obj.SetLinearVelocity(v);
+  auto first = stepConstraints.cbegin();
+  auto last = stepConstraints.cend();
+  for (auto i = first; i != last; ++i) {
+    if ((*i)->IsActive()) {
+      link((*i)->GetObjectA(), (*i)->GetObjectB());
+    }
+  }
 
-    auto rot = transform.GetOrientation();
-    auto w = obj.GetAngularVelocity();
+  // An island can sleep if everything's been slow for long enough, and must
+  // wake if anything in it is properly awake
+  enum IslandState : uint8_t { CanSleep = BIT(0), MustWake = BIT(1) };
+  islandStates.assign(physicsBodies.size(), CanSleep);
 
-    rot += Quaternion(w * dt * 0.5f, 0.0f) * rot;
-    rot.Normalise();
+  for (int i = 0; i < (int)physicsBodies.size(); ++i) {
+    auto phys = physicsBodies[i]->GetPhysicsObject();
+    if (!phys->IsDynamic() || phys->IsAsleep()) {
+      continue;
+    }
+    int root = find(i);
+    if (phys->GetSleepTimer() < timeToSleep) {
+      islandStates[root] &= ~CanSleep;
+      islandStates[root] |= MustWake;
+    }
+  }
 
-    transform.SetOrientation(rot);
+  for (int i = 0; i < (int)physicsBodies.size(); ++i) {
+    auto phys = physicsBodies[i]->GetPhysicsObject();
+    if (!phys->IsDynamic()) {
+      continue;
+    }
+    uint8_t state = islandStates[find(i)];
 
-    const float frameAngularDamping =
-        1.0f - ((1.0f - material.angularDamping) * dt);
-    w *= frameAngularDamping;
-    obj.SetAngularVelocity(w);
+    if (state & MustWake) {
+      if (phys->IsAsleep()) {
+        phys->Wake();
+      }
+    } else if ((state & CanSleep) && !phys->IsAsleep()) {
+      phys->Sleep();
+    }
   }
 }
 
@@ -426,8 +1599,9 @@ clear out any accumulated forces, ready to receive new
 ones in the next 'game' frame.
 */
 void PhysicsSystem::ClearForces() {
-  gameWorld.OperateOnContents(
-      [](GameObject *o) { o->GetPhysicsObject()->ClearForces(); });
+  for (auto i : physicsBodies) {
+    i->GetPhysicsObject()->ClearForces();
+  }
 }
 
 /*
@@ -438,11 +1612,43 @@ us to model springs and ropes etc.
 
 */
 void PhysicsSystem::UpdateConstraints(float dt) {
-  std::vector<Constraint *>::const_iterator first;
-  std::vector<Constraint *>::const_iterator last;
-  gameWorld.GetConstraintIterators(first, last);
+  auto first = stepConstraints.cbegin();
+  auto last = stepConstraints.cend();
 
   for (auto i = first; i != last; ++i) {
+    GameObject *a = (*i)->GetObjectA();
+    GameObject *b = (*i)->GetObjectB();
+    // Nothing to correct between two objects that aren't moving
+    if (a && b && IsResting(a) && IsResting(b)) {
+      continue;
+    }
+    if (constraintSolver == ConstraintSolver::XPBD &&
+        (*i)->HasPositionSolve()) {
+      continue;
+    }
     (*i)->UpdateConstraint(dt);
   }
+}
+
+/*
+The contacts have already been solved on velocities by now, and aren't
+looked at again until next step, so a constraint pulling something into the
+floor leaves it there until then. Both sides move straight away, so later
+constraints in the list see where earlier ones put things, the same as the
+impulse solver sees their velocities.
+*/
+void PhysicsSystem::SolveConstraintPositions(float dt) {
+  auto first = stepConstraints.cbegin();
+  auto last = stepConstraints.cend();
+
+  for (auto i = first; i != last; ++i) {
+    GameObject *a = (*i)->GetObjectA();
+    GameObject *b = (*i)->GetObjectB();
+    if (a && b && IsResting(a) && IsResting(b)) {
+      continue;
+    }
+    if ((*i)->HasPositionSolve()) {
+      (*i)->SolvePosition(dt);
+    }
+  }
 }
\ No newline at end of file
@@ -1,11 +1,62 @@
 #pragma once
 #include "GameWorld.h"
+#include "collisions/AABBTree.h"
 #include "collisions/CollisionDetection.h"
+#include "collisions/ContactManifold.h"
+#include "collisions/LooseOctree.h"
+#include "collisions/PairCache.h"
+#include "collisions/SweepAndPrune.h"
+#include "physics/BodyStore.h"
+#include "physics/CollisionEvents.h"
+#include "physics/PhysicsCommands.h"
+#include "physics/PhysicsProfiler.h"
+#include "physics/PhysicsSnapshot.h"
+
+#include "Mutex.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
 namespace NCL {
 namespace CSC8503 {
 class PhysicsSystem {
 public:
+  enum class BroadPhaseContainer : uint8_t {
+    AABBTree,
+    SweepAndPrune,
+    LooseOctree,
+  };
+
+  /// @brief How constraints are solved. Impulse solves them on velocities
+  /// alongside the contacts, every iteration. XPBD solves those that can be
+  /// on positions instead, a pass per substep of each step
+  enum class ConstraintSolver : uint8_t {
+    Impulse,
+    XPBD,
+  };
+
+  using StepLimit = PhysicsProfiler::StepLimit;
+
+  struct StepSettings {
+    // The fixed rate the world is stepped at
+    int stepHz = 120;
+    // The most steps one Update will take to catch up, and how many steps'
+    // worth of time can be carried over to the next
+    int maxSubsteps = 4;
+    // Stop catching up once an Update's steps would take longer than this,
+    // zero for no limit
+    float budgetMs = 12.0f;
+    // Ignore the budget, so the steps taken only ever depend on the times
+    // passed to Update, and never on how long the steps took
+    bool deterministic = false;
+  };
+
   PhysicsSystem(GameWorld &g);
   ~PhysicsSystem();
 
@@ -13,34 +64,134 @@ public:
 
   void Update(float dt);
 
-  void UseGravity(bool state) { applyGravity = state; }
+  void UseGravity(bool state) {
+    BetweenSteps([this, state] { applyGravity = state; });
+  }
+
+  void SetGlobalDamping(float d) {
+    BetweenSteps([this, d] { globalDamping = d; });
+  }
 
-  void SetGlobalDamping(float d) { globalDamping = d; }
+  void UseSleeping(bool state) {
+    BetweenSteps([this, state] { useSleeping = state; });
+  }
+
+  /// @brief Publish snapshots for the renderer to blend between, even when
+  /// not threaded. Not worth it without anything drawing
+  void UseInterpolation(bool state);
 
   void SetGravity(const Vector3 &g);
   Vector3 &GetGravity() { return gravity; }
 
+  /// @brief Events from the last step, handed out at the end of Update
+  CollisionEventBuffer &GetCollisionEvents() { return collisionEvents; }
+  void DispatchCollisionEvents();
+
+  /// @brief Timings and counters for the last few updates
+  const PhysicsProfiler &GetProfiler() const { return profiler; }
+  PhysicsProfiler &GetProfiler() { return profiler; }
+
+  /// @brief Threads to use alongside the one calling Update, for the parts
+  /// of the step that can be split up
+  void SetWorkerCount(unsigned workers);
+  unsigned GetWorkerCount() const { return workerPool->GetThreadCount() - 1; }
+
+  /// @brief Whether objects on two layers are tested against each other at
+  /// all. Every layer collides with every other until told otherwise, and
+  /// objects on no layers collide with everything
+  void SetLayerCollision(GameObject::Layer a, GameObject::Layer b, bool state);
+  bool GetLayerCollision(GameObject::Layer a, GameObject::Layer b) const;
+
+  void SetConstraintSolver(ConstraintSolver s) {
+    BetweenSteps([this, s] { constraintSolver = s; });
+  }
+  ConstraintSolver GetConstraintSolver() const { return constraintSolver; }
+
+  /// @brief How many pieces the XPBD solver splits each step into
+  void SetConstraintSubsteps(int substeps) {
+    BetweenSteps(
+        [this, substeps] { constraintSubsteps = std::max(substeps, 1); });
+  }
+  int GetConstraintSubsteps() const { return constraintSubsteps; }
+
+  void SetBroadPhaseContainer(BroadPhaseContainer c);
+  BroadPhaseContainer GetBroadPhaseContainer() const {
+    return broadPhaseContainer;
+  }
+
+  /// @brief How often to step, and how hard to try to catch up when behind
+  void SetStepSettings(const StepSettings &settings);
+  const StepSettings &GetStepSettings() const { return stepSettings; }
+
+  /// @brief Step on a thread of its own at the fixed step rate, instead of in
+  /// Update. Update then only hands out the collision events. Settings
+  /// changed in the meantime take effect between steps, so should only be
+  /// read with the world locked
+  void StartThread();
+  void StopThread();
+  bool IsThreaded() const { return physicsThread.joinable(); }
+
+  /// @brief Change an object's physics at the start of the next step
+  void QueueCommand(GameObject &o, PhysicsCommand::Action action);
+
+  /// @brief Where every body was at the end of the latest step and the one
+  /// before, kept up to date while threaded or interpolating
+  TripleBuffer<PhysicsSnapshot> &GetSnapshots() { return snapshots; }
+
 protected:
+  void BetweenSteps(std::function<void()> change);
+  void ClearNow();
+  void ForgetRemoved();
+  void ApplyChanges();
+
+  void BeginSteps();
+  void Step(float dt);
+  void EndSteps(int steps, float dt);
+  void ThreadLoop(float dt);
+  void ApplyCommands();
+  bool UsingSnapshots() const { return IsThreaded() || useInterpolation; }
+  void UpdateSnapshotSource();
+  void RecordPreviousStates();
+  void PublishSnapshot(PhysicsSnapshot::Clock::time_point stepTime,
+                       float stepDT);
+
   void BroadPhase();
+  void TreeBroadPhase();
+  void SweepBroadPhase();
+  void OctreeBroadPhase();
+  void SyncBroadPhaseProxies();
+  void ResetBroadPhaseProxies();
+  void StaticBroadPhase();
+  void SyncStaticTree();
+  void AddBroadPhasePair(PairCache<CollisionDetection::CollisionInfo> &pairs,
+                         GameObject *a, GameObject *b);
+  bool LayersCollide(const GameObject &a, const GameObject &b) const;
   void NarrowPhase();
+  void AddContact(uint64_t key, const CollisionDetection::CollisionInfo &info);
 
   void ClearForces();
 
   void IntegrateAccel(float dt);
   void IntegrateVelocity(float dt);
+  void SweepFastBodies();
+  void SyncBodies();
+  void GatherAwakeBodies();
+  void UpdateSleeping(float dt);
+  static bool IsResting(const GameObject *o);
+  static bool IsStatic(const GameObject *o);
+  static bool IsDynamic(const GameObject *o);
 
   void UpdateConstraints(float dt);
+  void SolveConstraintPositions(float dt);
 
   void UpdateCollisionList();
   void UpdateObjectAABBs();
 
-  void ImpulseResolveCollision(GameObject &a, GameObject &b,
-                               CollisionDetection::ContactPoint &p) const;
-
-  void ProjectionNarrowPhase();
-  void
-  ProjectionResolveCollision(GameObject &a, GameObject &b,
-                             const CollisionDetection::ContactPoint &p) const;
+  void PrepareContacts(float dt);
+  void SolveContacts();
+  static void ApplyContactImpulse(GameObject &a, GameObject &b,
+                                  const ContactManifold::Point &p,
+                                  const Vector3 &impulse);
 
   GameWorld &gameWorld;
 
@@ -49,12 +200,188 @@ protected:
   float dTOffset;
   float globalDamping;
 
-  std::set<CollisionDetection::CollisionInfo> neededResolutions;
-  std::set<CollisionDetection::CollisionInfo> allCollisions;
-  std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
+  StepSettings stepSettings;
+
+  struct CollisionPair {
+    CollisionDetection::CollisionInfo info;
+    int lastContactFrame = 0;
+    bool begun = false;
+    // Both sides went to sleep while touching, so the contact is held as it
+    // was until one of them wakes
+    bool frozen = false;
+
+    ContactManifold manifold;
+    int lastContactStep = -1;
+    float restitution = 0.0f;
+    float friction = 0.0f;
+  };
+
+  // Both keyed by the world IDs of the pair
+  PairCache<CollisionPair> allCollisions;
+  PairCache<CollisionDetection::CollisionInfo> broadphaseCollisions;
+  // Awake dynamic bodies against static ones, found again every step
+  PairCache<CollisionDetection::CollisionInfo> staticCollisions;
+  int collisionFrame = 0;
+  CollisionEventBuffer collisionEvents;
+  // Counts substeps rather than frames, to tell which manifolds are current
+  int contactStep = 0;
+
+  struct NarrowPhaseHit {
+    size_t candidate;
+    CollisionDetection::CollisionInfo info;
+  };
+  struct NarrowPhaseHint {
+    size_t candidate;
+    int separatingAxis;
+    Vector3 searchDirection;
+  };
+  // Kept apart so threads filling their own don't fight over cache lines
+  struct alignas(64) NarrowPhaseBuffer {
+    std::vector<NarrowPhaseHit> hits;
+    std::vector<NarrowPhaseHint> hints;
+  };
+
+  struct PairHint {
+    int separatingAxis = -1;
+    Vector3 searchDirection;
+    int step = 0;
+  };
+  // Where last step's test of a pair left off, for the next one to start
+  // from: the axis that kept two boxes apart, or where GJK's search ended.
+  // Only read while the narrowphase runs
+  PairCache<PairHint> pairHints;
+
+  PhysicsProfiler profiler;
+
+  std::unique_ptr<ThreadPool> workerPool;
+  std::vector<NarrowPhaseBuffer> narrowPhaseBuffers;
+  struct NarrowPhaseTask {
+    size_t candidate;
+    CollisionDetection::PairKind kind;
+  };
+  // Candidates split by which volumes they are, then laid out bucket by
+  // bucket, so each thread's share comes in runs of the same kind
+  std::array<std::vector<size_t>, CollisionDetection::PairKindCount>
+      narrowPhaseBuckets;
+  std::vector<NarrowPhaseTask> narrowPhaseOrder;
+  std::vector<NarrowPhaseHit> narrowPhaseHits;
+  // Pairs handed to a thread at a time, enough to be worth the handoff
+  size_t narrowPhaseChunk = 64;
+
+  std::thread physicsThread;
+  std::atomic<bool> threadRunning = false;
+  std::atomic<bool> clearQueued = false;
+
+  Mutex<std::vector<PhysicsCommand>> queuedCommands;
+  // Swapped with the queue, so it's only locked for as long as the swap
+  std::vector<PhysicsCommand> applyingCommands;
+  // Settings changed while threaded, waiting for the step to finish
+  Mutex<std::vector<std::function<void()>>> queuedChanges;
+  std::vector<std::function<void()>> applyingChanges;
+
+  // The thread's events wait here for Update to take them, and are then
+  // dispatched from the other buffer, outside the lock
+  Mutex<CollisionEventBuffer> publishedEvents;
+  CollisionEventBuffer dispatchingEvents;
+  std::vector<GameObject *> removedObjects;
+
+  TripleBuffer<PhysicsSnapshot> snapshots;
+  bool useInterpolation = true;
+
+  struct PreviousState {
+    const GameObject *object = nullptr;
+    int contactStep = -1;
+    Vector3 position;
+    Quaternion orientation;
+  };
+  // Where each body was before the step it last moved in, by world ID
+  std::vector<PreviousState> previousStates;
+
+  // The pairs being solved this substep
+  std::vector<CollisionPair *> activeContacts;
+
+  ConstraintSolver constraintSolver = ConstraintSolver::Impulse;
+  int constraintSubsteps = 8;
+
+  // Fraction of the penetration pushed out each step, and how much is
+  // allowed before pushing, so resting contacts don't jitter
+  float contactBaumgarte = 0.2f;
+  float contactSlop = 0.01f;
+  // Closing speeds below this don't bounce
+  float restitutionThreshold = 1.0f;
+
+  // Bodies using continuous collision are only swept once they move further
+  // than this fraction of their inner radius in a step, and are then allowed
+  // this far into whatever they hit, so the narrowphase picks the contact up
+  float ccdMotionThreshold = 0.5f;
+  float ccdPenetration = 0.02f;
+
+  // Every object with physics that isn't static, and where each is in that
+  // list by world ID
+  std::vector<GameObject *> physicsBodies;
+  std::vector<int> bodyIndices;
+  // Just the kinematic ones
+  std::vector<GameObject *> kinematicBodies;
+  // The dynamic ones that are awake, for the body store to gather
+  std::vector<GameObject *> awakeBodies;
+  int bodyWorldState = -1;
+
+  // Just the objects that are awake this frame
+  BodyStore bodies;
+
+  // The world's constraints, copied before the steps so the world can
+  // change while they run
+  std::vector<Constraint *> stepConstraints;
+
+  bool useSleeping = true;
+  float sleepLinearVelocity = 0.1f;
+  float sleepAngularVelocity = 0.1f;
+  float timeToSleep = 0.5f;
+
+  std::vector<int> islandParents;
+  std::vector<uint8_t> islandStates;
 
   bool useBroadPhase = true;
   int numCollisionFrames = 5;
+
+  BroadPhaseContainer broadPhaseContainer = BroadPhaseContainer::AABBTree;
+
+  using LayerMask = Bitflag<GameObject::Layer>::Underlying;
+  static constexpr int LayerCount = sizeof(LayerMask) * 8;
+  // For each layer, by bit, the layers it doesn't collide with
+  std::array<LayerMask, LayerCount> layerIgnores = {};
+  bool anyLayerIgnores = false;
+
+  struct BroadPhaseProxy {
+    int proxy;
+    int syncStamp;
+  };
+
+  // Persistent broadphases, only the active container holds any proxies.
+  // Proxies are keyed by world ID. Static objects are never in these
+  AABBTree<GameObject *> broadPhaseTree;
+  SweepAndPrune<GameObject *> broadPhaseSweep;
+  // Rebuilt every step, but keeps its memory
+  LooseOctree<GameObject *> broadPhaseOctree;
+  std::unordered_map<int, BroadPhaseProxy> broadPhaseProxies;
+  int broadPhaseWorldState = -1;
+  int broadPhaseSyncStamp = 0;
+  bool broadPhasePairsDirty = true;
+
+  struct StaticProxy {
+    int proxy;
+    int syncStamp;
+    // Transform generation when it was inserted, so anything moved while
+    // the world was being rebuilt gets reinserted
+    uint32_t generation;
+  };
+
+  // Static objects, only touched when objects are added to or removed from
+  // the world, whichever container is in use
+  AABBTree<GameObject *> staticTree;
+  std::unordered_map<int, StaticProxy> staticProxies;
+  int staticWorldState = -1;
+  int staticSyncStamp = 0;
 };
 } // namespace CSC8503
 } // namespace NCL
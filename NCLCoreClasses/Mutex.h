@@ -10,6 +10,9 @@ template <typename T> class Mutex;
 template <typename T> class LockGuard {
 public:
   LockGuard(Mutex<T> &m) : mutex(m), lock(m.mutex) {}
+  // For a mutex the caller has already locked
+  LockGuard(Mutex<T> &m, std::adopt_lock_t)
+      : mutex(m), lock(m.mutex, std::adopt_lock) {}
 
   T &operator*() { return mutex.value; }
   const T &operator*() const { return mutex.value; }
@@ -34,16 +37,13 @@ public:
   Mutex() = default;
   Mutex(T initialValue) : value(initialValue) {}
 
-  LockGuard<T> lock() {
-    mutex.lock();
-    return LockGuard<T>(*this);
-  }
+  LockGuard<T> lock() { return LockGuard<T>(*this); }
 
   LockGuard<const T> lock() const { return LockGuard<const T>(*this); }
 
   std::optional<LockGuard<T>> try_lock() {
     if (mutex.try_lock()) {
-      return LockGuard<T>(*this);
+      return LockGuard<T>(*this, std::adopt_lock);
     }
     return std::nullopt;
   }
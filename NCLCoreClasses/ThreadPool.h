@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NCL {
+/*
+A fixed set of worker threads for splitting one big loop up at a time.
+
+ParallelFor hands out the range in chunks to whichever thread is free, with
+the calling thread joining in too, and only returns once all of it is done.
+Each call gets told which thread it's running on, from 0 up to
+GetThreadCount(), so results can go into per-thread buffers without locking.
+*/
+class ThreadPool {
+public:
+  using Task = std::function<void(size_t begin, size_t end, unsigned thread)>;
+
+  /// @param workerCount extra threads on top of whichever calls ParallelFor
+  explicit ThreadPool(unsigned workerCount = DefaultWorkerCount()) {
+    workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+      workers.emplace_back([this, i]() { WorkerLoop(i + 1); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex);
+      shuttingDown = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  static unsigned DefaultWorkerCount() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+  }
+
+  /// @brief Including the thread calling ParallelFor
+  unsigned GetThreadCount() const { return (unsigned)workers.size() + 1; }
+
+  /// @brief Run task over [0, count) in chunks of at least minChunk, blocking
+  /// until every chunk is finished. Not re-entrant
+  void ParallelFor(size_t count, size_t minChunk, const Task &task) {
+    if (count == 0) {
+      return;
+    }
+    size_t chunk =
+        std::max(minChunk, count / (GetThreadCount() * ChunksPerThread));
+    chunk = std::max<size_t>(chunk, 1);
+
+    if (workers.empty() || chunk >= count) {
+      task(0, count, 0);
+      return;
+    }
+
+    {
+      std::lock_guard lock(mutex);
+      current = &task;
+      jobCount = count;
+      jobChunk = chunk;
+      next = 0;
+      busyWorkers = (unsigned)workers.size();
+      ++jobGeneration;
+    }
+    wake.notify_all();
+
+    RunChunks(0);
+
+    std::unique_lock lock(mutex);
+    finished.wait(lock, [&]() { return busyWorkers == 0; });
+    current = nullptr;
+  }
+
+protected:
+  // More chunks than threads, so a thread that gets slow pairs doesn't hold
+  // everything else up
+  static constexpr size_t ChunksPerThread = 4;
+
+  void RunChunks(unsigned thread) {
+    while (true) {
+      size_t begin = next.fetch_add(jobChunk);
+      if (begin >= jobCount) {
+        return;
+      }
+      (*current)(begin, std::min(begin + jobChunk, jobCount), thread);
+    }
+  }
+
+  void WorkerLoop(unsigned thread) {
+    size_t seenGeneration = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mutex);
+        wake.wait(lock, [&]() {
+          return shuttingDown || jobGeneration != seenGeneration;
+        });
+        if (shuttingDown) {
+          return;
+        }
+        seenGeneration = jobGeneration;
+      }
+
+      RunChunks(thread);
+
+      {
+        std::lock_guard lock(mutex);
+        --busyWorkers;
+      }
+      finished.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+
+  const Task *current = nullptr;
+  size_t jobCount = 0;
+  size_t jobChunk = 1;
+  std::atomic<size_t> next = 0;
+  size_t jobGeneration = 0;
+  unsigned busyWorkers = 0;
+  bool shuttingDown = false;
+};
+} // namespace NCL
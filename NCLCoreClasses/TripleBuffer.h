@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace NCL {
+/*
+Hands the latest copy of something from one thread to another without either
+ever waiting on the other.
+
+The writer fills in GetWriteBuffer and Publishes it, the reader calls Read and
+gets whatever was published last. There's a third copy sat between them, so
+the writer always has somewhere to write that the reader isn't looking at.
+Only one thread may write and one may read.
+*/
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() = default;
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  /// @brief The copy only the writer can see, which isn't cleared between
+  /// publishes
+  T &GetWriteBuffer() { return buffers[writeIndex]; }
+
+  /// @brief Swap the write buffer in as the newest one
+  void Publish() {
+    unsigned old = ready.exchange(writeIndex | NewFlag,
+                                  std::memory_order_acq_rel);
+    writeIndex = old & IndexMask;
+  }
+
+  /// @brief The newest published copy, or the last one read if nothing's
+  /// been published since
+  const T &Read() {
+    if (ready.load(std::memory_order_relaxed) & NewFlag) {
+      unsigned old = ready.exchange(readIndex, std::memory_order_acq_rel);
+      readIndex = old & IndexMask;
+    }
+    return buffers[readIndex];
+  }
+
+  /// @brief Whether anything has been published that Read hasn't picked up
+  bool HasNew() const {
+    return ready.load(std::memory_order_relaxed) & NewFlag;
+  }
+
+protected:
+  static constexpr unsigned IndexMask = 0x3;
+  static constexpr unsigned NewFlag = 0x4;
+
+  std::array<T, 3> buffers = {};
+  unsigned writeIndex = 0;
+  std::atomic<unsigned> ready = 1;
+  unsigned readIndex = 2;
+};
+} // namespace NCL
@@ -0,0 +1,157 @@
+#include "TestUtils.h"
+#include "collisions/CollisionDetection.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+BatchIntersection runs the same sums as the single pair tests across a pair
+per SIMD lane, so every lane has to come out the same as ObjectIntersection
+would for that pair on its own, whichever lane it's in and however full the
+batch is.
+*/
+namespace {
+using Info = CollisionDetection::CollisionInfo;
+using PairKind = CollisionDetection::PairKind;
+constexpr int Lanes = CollisionDetection::BatchLanes;
+
+struct Random {
+  std::mt19937 rng{77};
+
+  float operator()(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  }
+
+  Quaternion Orientation() {
+    Quaternion q((*this)(-1, 1), (*this)(-1, 1), (*this)(-1, 1),
+                 (*this)(-1, 1));
+    q.Normalise();
+    return q;
+  }
+};
+
+std::unique_ptr<GameObject> MakeObject(Random &random, VolumeType type,
+                                       const Vector3 &near,
+                                       bool trigger = false) {
+  auto object = std::make_unique<GameObject>();
+  CollisionVolume *volume;
+  switch (type) {
+  case VolumeType::Sphere:
+    volume = new SphereVolume(random(0.2f, 1.5f));
+    break;
+  case VolumeType::AABB:
+    volume = new AABBVolume(Vector3(random(0.2f, 1.5f), random(0.2f, 1.5f),
+                                    random(0.2f, 1.5f)));
+    break;
+  default:
+    volume = new CapsuleVolume(random(0.2f, 1.5f), random(0.1f, 0.8f));
+    object->GetTransform().SetOrientation(random.Orientation());
+    break;
+  }
+  volume->SetTrigger(trigger);
+  object->SetBoundingVolume(volume);
+  object->GetTransform().SetPosition(
+      near + Vector3(random(-2, 2), random(-2, 2), random(-2, 2)));
+  return object;
+}
+
+bool SameContact(const Info &a, const Info &b) {
+  const CollisionDetection::ContactPoint &p = a.point;
+  const CollisionDetection::ContactPoint &q = b.point;
+  constexpr float tolerance = 1e-4f;
+  return a.a == b.a && a.b == b.b &&
+         std::abs(p.penetration - q.penetration) < tolerance &&
+         Vector::Length(p.normal - q.normal) < tolerance &&
+         Vector::Length(p.localA - q.localA) < tolerance &&
+         Vector::Length(p.localB - q.localB) < tolerance;
+}
+
+// Batches of pairs of the given volume types, checked lane by lane against
+// ObjectIntersection
+void TestKindMatchesSingle(Random &random, VolumeType typeA,
+                           VolumeType typeB, PairKind kind) {
+  int hits = 0;
+  int misses = 0;
+  for (int batch = 0; batch < 5000; ++batch) {
+    int count = 1 + batch % Lanes;
+    std::vector<std::unique_ptr<GameObject>> objects;
+    Info infos[Lanes];
+    for (int lane = 0; lane < count; ++lane) {
+      objects.push_back(MakeObject(random, typeA, Vector3()));
+      objects.push_back(MakeObject(
+          random, typeB, objects.back()->GetTransform().GetPosition()));
+      infos[lane].a = objects[lane * 2].get();
+      infos[lane].b = objects[lane * 2 + 1].get();
+      TEST_CHECK(CollisionDetection::GetPairKind(*infos[lane].a,
+                                                 *infos[lane].b) == kind);
+    }
+
+    int batchHits = CollisionDetection::BatchIntersection(kind, infos, count);
+    TEST_CHECK((batchHits & ~((1 << count) - 1)) == 0);
+
+    for (int lane = 0; lane < count; ++lane) {
+      Info single;
+      bool hit = CollisionDetection::ObjectIntersection(
+          objects[lane * 2].get(), objects[lane * 2 + 1].get(), single);
+      bool batchHit = (batchHits & (1 << lane)) != 0;
+      TEST_CHECK(batchHit == hit);
+      if (hit && batchHit) {
+        TEST_CHECK(SameContact(infos[lane], single));
+        ++hits;
+      } else {
+        ++misses;
+      }
+    }
+  }
+  TEST_CHECK(hits > 1000 && misses > 1000);
+}
+
+void TestTriggersOnlyOverlap(Random &random) {
+  const VolumeType types[] = {VolumeType::Sphere, VolumeType::AABB,
+                              VolumeType::Capsule};
+  for (int batch = 0; batch < 5000; ++batch) {
+    int count = 1 + batch % Lanes;
+    std::vector<std::unique_ptr<GameObject>> objects;
+    Info infos[Lanes];
+    for (int lane = 0; lane < count; ++lane) {
+      objects.push_back(
+          MakeObject(random, types[random.rng() % 3], Vector3(), true));
+      objects.push_back(MakeObject(
+          random, types[random.rng() % 3],
+          objects.back()->GetTransform().GetPosition()));
+      infos[lane].a = objects[lane * 2].get();
+      infos[lane].b = objects[lane * 2 + 1].get();
+    }
+
+    int batchHits =
+        CollisionDetection::BatchIntersection(PairKind::Trigger, infos, count);
+    for (int lane = 0; lane < count; ++lane) {
+      Info single;
+      bool hit = CollisionDetection::ObjectIntersection(
+          objects[lane * 2].get(), objects[lane * 2 + 1].get(), single);
+      TEST_CHECK(((batchHits & (1 << lane)) != 0) == hit);
+    }
+  }
+}
+} // namespace
+
+int main() {
+  Random random;
+  TestKindMatchesSingle(random, VolumeType::Sphere, VolumeType::Sphere,
+                        PairKind::SphereSphere);
+  TestKindMatchesSingle(random, VolumeType::AABB, VolumeType::AABB,
+                        PairKind::AABBAABB);
+  // Either way round, the box comes first
+  TestKindMatchesSingle(random, VolumeType::AABB, VolumeType::Sphere,
+                        PairKind::AABBSphere);
+  TestKindMatchesSingle(random, VolumeType::Sphere, VolumeType::AABB,
+                        PairKind::AABBSphere);
+  TestKindMatchesSingle(random, VolumeType::Capsule, VolumeType::Capsule,
+                        PairKind::CapsuleCapsule);
+  TestTriggersOnlyOverlap(random);
+  return Tests::Finish("BatchIntersectionTests");
+}
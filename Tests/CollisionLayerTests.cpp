@@ -0,0 +1,212 @@
+#include "TestUtils.h"
+#include "GameWorld.h"
+#include "collisions/CollisionDetection.h"
+#include "physics/PhysicsObject.h"
+#include "physics/PhysicsSystem.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+The layer matrix packs a row of ignored layers per layer into a mask, and
+objects can be on several layers at once. It's checked against keeping a
+plain flag for every pair of single layers. Triggers only get the cheap
+overlap test, which has to agree with the full one about what's touching,
+and a scene run through every broadphase container has to keep apart
+whatever the layers say, and nothing else.
+*/
+namespace {
+using Layer = GameObject::Layer;
+constexpr int Layers = 8;
+
+Layer Mask(unsigned bits) { return (Layer)bits; }
+
+void TestMatrixMatchesReference() {
+  GameWorld world;
+  PhysicsSystem physics(world);
+  std::mt19937 rng(11);
+
+  bool ignored[Layers][Layers] = {};
+  auto referenceCollides = [&](unsigned a, unsigned b) {
+    for (int i = 0; i < Layers; ++i) {
+      for (int j = 0; j < Layers; ++j) {
+        if ((a >> i & 1) && (b >> j & 1) && ignored[i][j]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  for (int change = 0; change < 300; ++change) {
+    // Mostly single layers, sometimes several at once
+    auto randomMask = [&] {
+      unsigned mask = 1u << (rng() % Layers);
+      if (rng() % 4 == 0) {
+        mask |= rng() % (1u << Layers);
+      }
+      return mask;
+    };
+    unsigned a = randomMask();
+    unsigned b = randomMask();
+    bool state = rng() % 3 == 0;
+    physics.SetLayerCollision(Mask(a), Mask(b), state);
+    for (int i = 0; i < Layers; ++i) {
+      for (int j = 0; j < Layers; ++j) {
+        if ((a >> i & 1) && (b >> j & 1)) {
+          ignored[i][j] = !state;
+          ignored[j][i] = !state;
+        }
+      }
+    }
+
+    for (unsigned x = 0; x < (1u << Layers); x += 1 + rng() % 7) {
+      for (unsigned y = 0; y < (1u << Layers); y += 1 + rng() % 7) {
+        TEST_CHECK(physics.GetLayerCollision(Mask(x), Mask(y)) ==
+                   referenceCollides(x, y));
+      }
+    }
+  }
+}
+
+void TestOverlapMatchesIntersection() {
+  std::mt19937 rng(9);
+  auto random = [&](float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  };
+
+  int hits = 0;
+  for (int i = 0; i < 100000; ++i) {
+    auto make = [&](GameObject &o) {
+      switch (rng() % 4) {
+      case 0:
+        o.SetBoundingVolume(new SphereVolume(random(0.2f, 1.5f)));
+        break;
+      case 1:
+        o.SetBoundingVolume(new AABBVolume(Vector3(
+            random(0.2f, 1.5f), random(0.2f, 1.5f), random(0.2f, 1.5f))));
+        break;
+      case 2:
+        o.SetBoundingVolume(new OBBVolume(Vector3(
+            random(0.2f, 1.5f), random(0.2f, 1.5f), random(0.2f, 1.5f))));
+        break;
+      default:
+        o.SetBoundingVolume(
+            new CapsuleVolume(random(0.2f, 1.5f), random(0.1f, 0.8f)));
+        break;
+      }
+      Quaternion q(random(-1, 1), random(-1, 1), random(-1, 1),
+                   random(-1, 1));
+      q.Normalise();
+      o.GetTransform()
+          .SetPosition(Vector3(random(-2, 2), random(-2, 2), random(-2, 2)))
+          .SetOrientation(q);
+    };
+    GameObject a;
+    GameObject b;
+    make(a);
+    make(b);
+
+    CollisionDetection::CollisionInfo info;
+    bool hit = CollisionDetection::ObjectIntersection(&a, &b, info);
+    TEST_CHECK(CollisionDetection::ObjectOverlap(a, b) == hit);
+    TEST_CHECK(CollisionDetection::ObjectOverlap(b, a) == hit);
+    hits += hit;
+  }
+  TEST_CHECK(hits > 10000);
+}
+
+// Remembers every object it started touching
+class Recorder : public GameObject {
+public:
+  void OnCollisionBegin(GameObject *other) override { touched.insert(other); }
+
+  std::set<GameObject *> touched;
+};
+
+void TestSceneKeepsLayersApart(PhysicsSystem::BroadPhaseContainer container) {
+  // Declared first, so they outlive the world and physics
+  std::vector<std::unique_ptr<Recorder>> objects;
+  GameWorld world;
+  PhysicsSystem physics(world);
+  physics.UseGravity(true);
+  physics.SetBroadPhaseContainer(container);
+
+  const Layer floorLayer = Mask(1u << 5);
+  const Layer ghostLayer = Mask(1u << 4);
+  physics.SetLayerCollision(floorLayer, ghostLayer, false);
+
+  auto add = [&](CollisionVolume *volume, const Vector3 &position,
+                 bool dynamic, Layer layer) {
+    auto object = std::make_unique<Recorder>();
+    object->SetBoundingVolume(volume);
+    object->GetTransform().SetPosition(position);
+    object->GetLayers() |= layer;
+    auto *phys = new PhysicsObject(object->GetTransform(),
+                                   object->GetBoundingVolume());
+    phys->SetInverseMass(dynamic ? 1.0f : 0.0f);
+    phys->SetAxisLocks(0);
+    if (!dynamic) {
+      phys->SetBodyType(PhysicsObject::BodyType::Static);
+    }
+    phys->InitCubeInertia();
+    object->SetPhysicsObject(phys);
+    world.AddGameObject(object.get());
+    objects.push_back(std::move(object));
+    return objects.back().get();
+  };
+
+  Recorder *floor = add(new AABBVolume(Vector3(20, 1, 20)), Vector3(0, -1, 0),
+                        false, floorLayer);
+  Recorder *box = add(new AABBVolume(Vector3(1, 1, 1)), Vector3(-3, 3, 0),
+                      true, Mask(0));
+  Recorder *ghost = add(new AABBVolume(Vector3(1, 1, 1)), Vector3(3, 3, 0),
+                        true, ghostLayer);
+  // A trigger the box lands in, and a static box sunk into the floor
+  auto *triggerVolume = new AABBVolume(Vector3(2, 2, 2));
+  triggerVolume->SetTrigger();
+  Recorder *trigger =
+      add(triggerVolume, Vector3(-3, 1, 0), false, Mask(0));
+  Recorder *sunk = add(new AABBVolume(Vector3(1, 1, 1)), Vector3(8, 0, 0),
+                       false, Mask(0));
+
+  for (int frame = 0; frame < 180; ++frame) {
+    physics.Update(1.0f / 60.0f);
+  }
+
+  // The box lands on the floor, through the trigger without being pushed
+  Vector3 boxPos = box->GetTransform().GetPosition();
+  TEST_CHECK_NEAR(boxPos.y, 1.0f, 0.1f);
+  TEST_CHECK_NEAR(boxPos.x, -3.0f, 0.05f);
+  TEST_CHECK(box->touched.count(floor) == 1);
+  TEST_CHECK(trigger->touched.count(box) == 1 ||
+             box->touched.count(trigger) == 1);
+
+  // The ghost's layer doesn't collide with the floor's
+  TEST_CHECK(ghost->GetTransform().GetPosition().y < -5.0f);
+  TEST_CHECK(ghost->touched.empty());
+  TEST_CHECK(floor->touched.count(ghost) == 0);
+
+  // Two static objects never even get tested
+  TEST_CHECK(sunk->touched.empty());
+  TEST_CHECK(floor->touched.count(sunk) == 0);
+  TEST_CHECK(trigger->touched.count(floor) == 0);
+
+  physics.Clear();
+  world.Clear();
+}
+} // namespace
+
+int main() {
+  TestMatrixMatchesReference();
+  TestOverlapMatchesIntersection();
+  TestSceneKeepsLayersApart(PhysicsSystem::BroadPhaseContainer::AABBTree);
+  TestSceneKeepsLayersApart(PhysicsSystem::BroadPhaseContainer::SweepAndPrune);
+  TestSceneKeepsLayersApart(PhysicsSystem::BroadPhaseContainer::LooseOctree);
+  return Tests::Finish("CollisionLayerTests");
+}
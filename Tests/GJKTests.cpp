@@ -0,0 +1,300 @@
+#include "TestUtils.h"
+#include "collisions/CollisionDetection.h"
+#include "collisions/GJK.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+GJK and EPA are checked two ways: on pairs of shapes where the answer can be
+worked out by hand, and on lots of random pairs against the dedicated tests
+that already exist for them, or a brute force distance where there isn't
+one. Whatever the pair, the contact points have to be the normal times the
+penetration apart, and starting the search from where it last finished
+mustn't change the answer.
+*/
+namespace {
+using Info = CollisionDetection::CollisionInfo;
+
+Transform At(const Vector3 &position,
+             const Quaternion &orientation = Quaternion()) {
+  Transform t;
+  t.SetPosition(position).SetOrientation(orientation);
+  return t;
+}
+
+GJK::Contact Intersect(const CollisionVolume &a, const Transform &ta,
+                       const CollisionVolume &b, const Transform &tb,
+                       bool &hit) {
+  Vector3 searchDirection;
+  GJK::Contact contact;
+  hit = GJK::Intersect(ConvexShape::FromVolume(a, ta),
+                       ConvexShape::FromVolume(b, tb), searchDirection,
+                       contact);
+  return contact;
+}
+
+void CheckContact(const GJK::Contact &contact, const Vector3 &normal,
+                  float penetration) {
+  TEST_CHECK_NEAR(contact.penetration, penetration, 1e-4f);
+  TEST_CHECK(Vector::Length(contact.normal - normal) < 1e-3f);
+  Vector3 apart = contact.pointA - contact.pointB;
+  TEST_CHECK(Vector::Length(apart - contact.normal * contact.penetration) <
+             1e-3f);
+}
+
+void TestKnownPairs() {
+  bool hit;
+
+  // Two spheres, only their centre points to go on
+  SphereVolume sphere(1.0f);
+  GJK::Contact c = Intersect(sphere, At(Vector3()), sphere,
+                             At(Vector3(1.5f, 0, 0)), hit);
+  TEST_CHECK(hit);
+  CheckContact(c, Vector3(1, 0, 0), 0.5f);
+  TEST_CHECK(Vector::Length(c.pointA - Vector3(1, 0, 0)) < 1e-4f);
+
+  // A ball sat on a box
+  OBBVolume box(Vector3(1, 1, 1));
+  SphereVolume ball(0.5f);
+  c = Intersect(box, At(Vector3()), ball, At(Vector3(0.3f, 1.3f, 0)), hit);
+  TEST_CHECK(hit);
+  CheckContact(c, Vector3(0, 1, 0), 0.2f);
+
+  // Two boxes overlapping face on, where the cores overlap and EPA has to
+  // find the way out
+  c = Intersect(box, At(Vector3()), box, At(Vector3(1.75f, 0.2f, -0.1f)),
+                hit);
+  TEST_CHECK(hit);
+  CheckContact(c, Vector3(1, 0, 0), 0.25f);
+
+  // A cube stood on one edge, poking 0.1 into a floor
+  OBBVolume floor(Vector3(5, 1, 5));
+  Quaternion edgeDown = Quaternion::AxisAngleToQuaterion(Vector3(0, 0, 1), 45);
+  c = Intersect(floor, At(Vector3()), box,
+                At(Vector3(0, 1 + std::sqrt(2.0f) - 0.1f, 0), edgeDown), hit);
+  TEST_CHECK(hit);
+  CheckContact(c, Vector3(0, 1, 0), 0.1f);
+
+  // Capsules crossed one above the other, one along x and one along z
+  CapsuleVolume capsule(1.0f, 0.5f);
+  Quaternion alongX = Quaternion::AxisAngleToQuaterion(Vector3(0, 0, 1), 90);
+  Quaternion alongZ = Quaternion::AxisAngleToQuaterion(Vector3(1, 0, 0), 90);
+  c = Intersect(capsule, At(Vector3(), alongX), capsule,
+                At(Vector3(0.2f, 0.8f, -0.3f), alongZ), hit);
+  TEST_CHECK(hit);
+  CheckContact(c, Vector3(0, 1, 0), 0.2f);
+
+  // A capsule lying on a box
+  c = Intersect(box, At(Vector3()), capsule,
+                At(Vector3(0.5f, 1.4f, 0), alongX), hit);
+  TEST_CHECK(hit);
+  CheckContact(c, Vector3(0, 1, 0), 0.1f);
+
+  // Apart, whichever shapes
+  Intersect(box, At(Vector3()), box, At(Vector3(2.01f, 0, 0)), hit);
+  TEST_CHECK(!hit);
+  Intersect(box, At(Vector3()), ball, At(Vector3(1.4f, 1.4f, 0)), hit);
+  TEST_CHECK(!hit);
+  Intersect(capsule, At(Vector3(), alongX), capsule,
+            At(Vector3(0, 1.01f, 0), alongZ), hit);
+  TEST_CHECK(!hit);
+}
+
+void TestCoreDistance() {
+  // Boxes three apart have a gap of one between their faces
+  OBBVolume box(Vector3(1, 1, 1));
+  ConvexShape a = ConvexShape::FromVolume(box, At(Vector3()));
+  ConvexShape b = ConvexShape::FromVolume(box, At(Vector3(3, 0.5f, 0)));
+  Vector3 searchDirection;
+  Vector3 pointA;
+  Vector3 pointB;
+  TEST_CHECK(GJK::CoreDistance(a, b, searchDirection, pointA, pointB));
+  TEST_CHECK_NEAR(Vector::Length(pointB - pointA), 1.0f, 1e-4f);
+  TEST_CHECK_NEAR(pointA.x, 1.0f, 1e-4f);
+  TEST_CHECK_NEAR(pointB.x, 2.0f, 1e-4f);
+
+  // Overlapping cores have no distance
+  b = ConvexShape::FromVolume(box, At(Vector3(1.5f, 0, 0)));
+  searchDirection = Vector3();
+  TEST_CHECK(!GJK::CoreDistance(a, b, searchDirection, pointA, pointB));
+}
+
+void TestHull() {
+  // A tetrahedron with its flat bottom at y = 0, and a ball just touching
+  // its tip, then sunk into it
+  const Vector3 points[] = {Vector3(-1, 0, -1), Vector3(1, 0, -1),
+                            Vector3(0, 0, 1), Vector3(0, 2, 0)};
+  ConvexShape hull = ConvexShape::FromHull(points, At(Vector3()));
+  SphereVolume ball(0.5f);
+
+  Vector3 searchDirection;
+  GJK::Contact c;
+  ConvexShape above = ConvexShape::FromVolume(ball, At(Vector3(0, 2.6f, 0)));
+  TEST_CHECK(!GJK::Intersect(hull, above, searchDirection, c));
+
+  searchDirection = Vector3();
+  ConvexShape under = ConvexShape::FromVolume(ball, At(Vector3(0, -0.3f, 0)));
+  TEST_CHECK(GJK::Intersect(hull, under, searchDirection, c));
+  CheckContact(c, Vector3(0, -1, 0), 0.2f);
+}
+
+// Signed distance from a point to a box, negative inside
+float BoxDistance(const Vector3 &point, const Transform &t,
+                  const Vector3 &halfSize) {
+  Vector3 local = t.GetOrientation().Conjugate() * (point - t.GetPosition());
+  Vector3 outside(std::abs(local.x) - halfSize.x,
+                  std::abs(local.y) - halfSize.y,
+                  std::abs(local.z) - halfSize.z);
+  float deepest = std::max(outside.x, std::max(outside.y, outside.z));
+  if (deepest < 0.0f) {
+    return deepest;
+  }
+  return Vector::Length(Vector::Clamp(local, -halfSize, halfSize) - local);
+}
+
+struct Random {
+  std::mt19937 rng{5};
+
+  float operator()(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  }
+  Vector3 Offset(float range) {
+    return Vector3((*this)(-range, range), (*this)(-range, range),
+                   (*this)(-range, range));
+  }
+  Quaternion Orientation() {
+    Quaternion q((*this)(-1, 1), (*this)(-1, 1), (*this)(-1, 1),
+                 (*this)(-1, 1));
+    q.Normalise();
+    return q;
+  }
+};
+
+// The contact agrees with itself, and a warm start gives the same answer
+void CheckConsistent(const CollisionVolume &a, const Transform &ta,
+                     const CollisionVolume &b, const Transform &tb,
+                     const Info &info) {
+  const CollisionDetection::ContactPoint &p = info.point;
+  Vector3 apart = (p.localA + ta.GetPosition()) - (p.localB + tb.GetPosition());
+  TEST_CHECK(Vector::Length(apart - p.normal * p.penetration) < 5e-3f);
+
+  Info warm;
+  warm.searchDirection = info.searchDirection;
+  TEST_CHECK(CollisionDetection::ConvexIntersection(a, ta, b, tb, warm));
+  TEST_CHECK_NEAR(warm.point.penetration, p.penetration, 1e-3f);
+}
+
+void TestMatchesSphereTest(Random &random) {
+  for (int i = 0; i < 20000; ++i) {
+    SphereVolume a(random(0.2f, 1.5f));
+    SphereVolume b(random(0.2f, 1.5f));
+    Transform ta = At(random.Offset(1));
+    Transform tb = At(ta.GetPosition() + random.Offset(2));
+
+    Info expected;
+    Info info;
+    bool hit = CollisionDetection::SphereIntersection(a, ta, b, tb, expected);
+    TEST_CHECK(CollisionDetection::ConvexIntersection(a, ta, b, tb, info) ==
+               hit);
+    if (hit) {
+      TEST_CHECK_NEAR(info.point.penetration, expected.point.penetration,
+                      1e-3f);
+      TEST_CHECK(Vector::Length(info.point.normal - expected.point.normal) <
+                 1e-2f);
+      CheckConsistent(a, ta, b, tb, info);
+    }
+  }
+}
+
+void TestMatchesBoxTest(Random &random) {
+  for (int i = 0; i < 20000; ++i) {
+    OBBVolume a(Vector3(random(0.2f, 1.5f), random(0.2f, 1.5f),
+                        random(0.2f, 1.5f)));
+    OBBVolume b(Vector3(random(0.2f, 1.5f), random(0.2f, 1.5f),
+                        random(0.2f, 1.5f)));
+    Quaternion aRot = random.Orientation();
+    // Some with faces parallel, the hardest case for EPA
+    Quaternion bRot = i % 5 == 0 ? aRot : random.Orientation();
+    Transform ta = At(random.Offset(1), aRot);
+    Transform tb = At(ta.GetPosition() + random.Offset(3), bRot);
+
+    Info expected;
+    Info info;
+    bool hit = CollisionDetection::OBBIntersection(a, ta, b, tb, expected);
+    bool gjkHit = CollisionDetection::ConvexIntersection(a, ta, b, tb, info);
+    // Only just touching could go either way
+    if (hit != gjkHit) {
+      TEST_CHECK(hit && expected.point.penetration < 1e-3f);
+      continue;
+    }
+    if (hit) {
+      TEST_CHECK_NEAR(info.point.penetration, expected.point.penetration,
+                      2e-3f);
+      CheckConsistent(a, ta, b, tb, info);
+    }
+  }
+}
+
+void TestBoxSphereMatchesDistance(Random &random) {
+  for (int i = 0; i < 20000; ++i) {
+    Vector3 halfSize(random(0.2f, 1.5f), random(0.2f, 1.5f),
+                     random(0.2f, 1.5f));
+    OBBVolume a(halfSize);
+    SphereVolume b(random(0.2f, 1.5f));
+    Transform ta = At(random.Offset(1), random.Orientation());
+    Transform tb = At(ta.GetPosition() + random.Offset(3));
+
+    float distance = BoxDistance(tb.GetPosition(), ta, halfSize);
+    float expected = b.GetRadius() - distance;
+    Info info;
+    bool hit = CollisionDetection::ConvexIntersection(a, ta, b, tb, info);
+    if (std::abs(expected) < 1e-4f) {
+      continue;
+    }
+    TEST_CHECK(hit == (expected > 0.0f));
+    if (hit) {
+      TEST_CHECK_NEAR(info.point.penetration, expected, 2e-3f);
+      CheckConsistent(a, ta, b, tb, info);
+    }
+  }
+}
+
+void TestMatchesCapsuleTest(Random &random) {
+  for (int i = 0; i < 20000; ++i) {
+    CapsuleVolume a(random(0.2f, 1.5f), random(0.1f, 0.8f));
+    CapsuleVolume b(random(0.2f, 1.5f), random(0.1f, 0.8f));
+    Transform ta = At(random.Offset(1), random.Orientation());
+    Transform tb = At(ta.GetPosition() + random.Offset(3),
+                      random.Orientation());
+
+    Info expected;
+    Info info;
+    bool hit = CollisionDetection::CapsuleIntersection(a, ta, b, tb, expected);
+    TEST_CHECK(CollisionDetection::ConvexIntersection(a, ta, b, tb, info) ==
+               hit);
+    if (hit) {
+      TEST_CHECK_NEAR(info.point.penetration, expected.point.penetration,
+                      2e-3f);
+      CheckConsistent(a, ta, b, tb, info);
+    }
+  }
+}
+} // namespace
+
+int main() {
+  TestKnownPairs();
+  TestCoreDistance();
+  TestHull();
+
+  Random random;
+  TestMatchesSphereTest(random);
+  TestMatchesBoxTest(random);
+  TestBoxSphereMatchesDistance(random);
+  TestMatchesCapsuleTest(random);
+  return Tests::Finish("GJKTests");
+}
@@ -0,0 +1,213 @@
+#include "TestUtils.h"
+#include "collisions/CollisionDetection.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <random>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+OBBIntersection does the separating axis test a group of axes per SIMD
+register, from the boxes' half sizes. It's checked against the scalar test it
+replaced, which built both boxes' corners and projected all of them onto each
+of the 15 axes in turn.
+*/
+namespace {
+using Info = CollisionDetection::CollisionInfo;
+
+struct Box {
+  OBBVolume volume;
+  Transform transform;
+
+  std::array<Vector3, 8> Corners() const {
+    std::array<Vector3, 8> corners;
+    Vector3 half = volume.GetHalfDimensions();
+    int index = 0;
+    for (int x = -1; x <= 1; x += 2) {
+      for (int y = -1; y <= 1; y += 2) {
+        for (int z = -1; z <= 1; z += 2) {
+          Vector3 local(half.x * x, half.y * y, half.z * z);
+          corners[index++] = transform.GetPosition() +
+                             transform.GetOrientation() * local;
+        }
+      }
+    }
+    return corners;
+  }
+
+  Vector3 Axis(int i) const {
+    Vector3 axis;
+    axis[i] = 1.0f;
+    return transform.GetOrientation() * axis;
+  }
+};
+
+// How far B would have to move along a unit axis, away from A, for their
+// corners to stop overlapping. Negative if they're already apart
+float ProjectedOverlap(const Box &a, const Box &b, Vector3 axis) {
+  Vector3 offset = b.transform.GetPosition() - a.transform.GetPosition();
+  if (Vector::Dot(axis, offset) < 0.0f) {
+    axis = -axis;
+  }
+  auto range = [&](const Box &box) {
+    float min = std::numeric_limits<float>::max();
+    float max = -std::numeric_limits<float>::max();
+    for (const Vector3 &corner : box.Corners()) {
+      float projection = Vector::Dot(corner, axis);
+      min = std::min(min, projection);
+      max = std::max(max, projection);
+    }
+    return std::make_pair(min, max);
+  };
+  float aMax = range(a).second;
+  float bMin = range(b).first;
+  return aMax - bMin;
+}
+
+std::array<Vector3, 15> TestAxes(const Box &a, const Box &b) {
+  std::array<Vector3, 15> axes;
+  for (int i = 0; i < 3; ++i) {
+    axes[i] = a.Axis(i);
+    axes[3 + i] = b.Axis(i);
+    for (int j = 0; j < 3; ++j) {
+      axes[6 + i * 3 + j] = Vector::Cross(a.Axis(i), b.Axis(j));
+    }
+  }
+  return axes;
+}
+
+// The scalar corner projection test, returning the least overlap over every
+// axis, which is negative if the boxes are apart
+float ScalarLeastOverlap(const Box &a, const Box &b) {
+  float least = std::numeric_limits<float>::max();
+  for (const Vector3 &axis : TestAxes(a, b)) {
+    if (Vector::Dot(axis, axis) < 0.0001f) {
+      continue;
+    }
+    least = std::min(least, ProjectedOverlap(a, b, Vector::Normalise(axis)));
+  }
+  return least;
+}
+
+struct Random {
+  std::mt19937 rng{2024};
+
+  float operator()(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  }
+
+  Quaternion Orientation() {
+    Quaternion q((*this)(-1, 1), (*this)(-1, 1), (*this)(-1, 1),
+                 (*this)(-1, 1));
+    q.Normalise();
+    return q;
+  }
+
+  Box RandomBox(const Vector3 &near, const Quaternion &orientation) {
+    Box box{OBBVolume(Vector3((*this)(0.2f, 1.5f), (*this)(0.2f, 1.5f),
+                              (*this)(0.2f, 1.5f))),
+            Transform()};
+    box.transform.SetPosition(near + Vector3((*this)(-1.5f, 1.5f),
+                                             (*this)(-1.5f, 1.5f),
+                                             (*this)(-1.5f, 1.5f)));
+    box.transform.SetOrientation(orientation);
+    return box;
+  }
+};
+
+void TestKnownOverlap() {
+  Box a{OBBVolume(Vector3(1, 1, 1)), Transform()};
+  Box b{OBBVolume(Vector3(1, 1, 1)), Transform()};
+  b.transform.SetPosition(Vector3(1.5f, 0.2f, 0));
+
+  Info info;
+  TEST_CHECK(CollisionDetection::OBBIntersection(a.volume, a.transform,
+                                                 b.volume, b.transform, info));
+  TEST_CHECK_NEAR(info.point.penetration, 0.5f, 1e-5f);
+  TEST_CHECK_NEAR(info.point.normal.x, 1.0f, 1e-5f);
+
+  b.transform.SetPosition(Vector3(2.5f, 0, 0));
+  TEST_CHECK(!CollisionDetection::OBBIntersection(a.volume, a.transform,
+                                                  b.volume, b.transform, info));
+  // A's x face is the one that keeps them apart
+  TEST_CHECK(info.separatingAxis == 0);
+}
+
+void TestMatchesScalar() {
+  Random random;
+  int hits = 0;
+  for (int i = 0; i < 20000; ++i) {
+    Quaternion aRot = random.Orientation();
+    // Some with edges parallel, where the cross product axes drop out
+    Quaternion bRot = i % 4 == 0 ? aRot : random.Orientation();
+    Box a = random.RandomBox(Vector3(), aRot);
+    Box b = random.RandomBox(a.transform.GetPosition(), bRot);
+
+    float least = ScalarLeastOverlap(a, b);
+    Info info;
+    bool hit = CollisionDetection::OBBIntersection(
+        a.volume, a.transform, b.volume, b.transform, info);
+
+    // Boxes only just touching could go either way
+    if (std::abs(least) < 1e-4f) {
+      continue;
+    }
+    TEST_CHECK(hit == (least > 0.0f));
+
+    if (!hit) {
+      // The axis it gives back really does separate them
+      TEST_CHECK(info.separatingAxis >= 0 && info.separatingAxis < 15);
+      Vector3 axis = TestAxes(a, b)[info.separatingAxis];
+      TEST_CHECK(ProjectedOverlap(a, b, Vector::Normalise(axis)) < 1e-4f);
+      continue;
+    }
+
+    ++hits;
+    TEST_CHECK_NEAR(info.point.penetration, least, 1e-3f);
+    TEST_CHECK_NEAR(Vector::Length(info.point.normal), 1.0f, 1e-4f);
+    // Normal points from A to B, and is an axis they overlap that much along
+    Vector3 offset = b.transform.GetPosition() - a.transform.GetPosition();
+    TEST_CHECK(Vector::Dot(info.point.normal, offset) >= 0.0f);
+    TEST_CHECK_NEAR(ProjectedOverlap(a, b, info.point.normal),
+                    info.point.penetration, 1e-3f);
+  }
+  // Enough of both to mean something
+  TEST_CHECK(hits > 2000 && hits < 18000);
+}
+
+void TestCachedAxisGivesSameAnswer() {
+  Random random;
+  for (int i = 0; i < 5000; ++i) {
+    Box a = random.RandomBox(Vector3(), random.Orientation());
+    Box b = random.RandomBox(a.transform.GetPosition(), random.Orientation());
+
+    Info fresh;
+    bool hit = CollisionDetection::OBBIntersection(
+        a.volume, a.transform, b.volume, b.transform, fresh);
+
+    // Whatever's cached, right or wrong or out of range, mustn't change it
+    for (int cached : {fresh.separatingAxis, (int)(random.rng() % 15), 99}) {
+      Info warm;
+      warm.separatingAxis = cached;
+      TEST_CHECK(CollisionDetection::OBBIntersection(
+                     a.volume, a.transform, b.volume, b.transform, warm) ==
+                 hit);
+      if (hit) {
+        TEST_CHECK(warm.separatingAxis == -1);
+        TEST_CHECK_NEAR(warm.point.penetration, fresh.point.penetration,
+                        1e-6f);
+      }
+    }
+  }
+}
+} // namespace
+
+int main() {
+  TestKnownOverlap();
+  TestMatchesScalar();
+  TestCachedAxisGivesSameAnswer();
+  return Tests::Finish("OBBIntersectionTests");
+}
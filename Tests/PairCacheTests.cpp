@@ -0,0 +1,105 @@
+#include "TestUtils.h"
+#include "collisions/PairCache.h"
+
+#include <map>
+#include <random>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+PairCache replaced a std::set of collision pairs, so it's run through the
+same inserts, erases and frame age eviction as a std::map, and has to agree
+with it after every one.
+*/
+namespace {
+using Cache = PairCache<int>;
+using Reference = std::map<Cache::Key, int>;
+
+bool Matches(const Cache &cache, const Reference &reference) {
+  if (cache.Size() != reference.size()) {
+    return false;
+  }
+  for (const auto &[key, value] : reference) {
+    const int *found = cache.Find(key);
+    if (!found || *found != value) {
+      return false;
+    }
+  }
+  // Nothing in the cache that isn't in the reference, and no duplicates
+  size_t walked = 0;
+  for (const Cache::Entry &e : cache) {
+    auto it = reference.find(e.key);
+    if (it == reference.end() || it->second != e.value) {
+      return false;
+    }
+    ++walked;
+  }
+  return walked == reference.size();
+}
+
+void TestKeysAreUnordered() {
+  TEST_CHECK(Cache::MakeKey(3, 7) == Cache::MakeKey(7, 3));
+  TEST_CHECK(Cache::MakeKey(3, 7) != Cache::MakeKey(3, 8));
+  // World IDs are handed out in order, so neighbours mustn't collide
+  TEST_CHECK(Cache::MakeKey(1, 2) != Cache::MakeKey(2, 3));
+}
+
+void TestMatchesMap() {
+  std::mt19937 rng(42);
+  Cache cache;
+  Reference reference;
+
+  // Few enough IDs that the same pairs keep coming back
+  auto randomKey = [&] {
+    return Cache::MakeKey((int)(rng() % 200), (int)(rng() % 200));
+  };
+
+  for (int frame = 0; frame < 500; ++frame) {
+    for (int i = 0; i < 100; ++i) {
+      Cache::Key key = randomKey();
+      auto [value, added] = cache.Insert(key);
+      TEST_CHECK(added == (reference.count(key) == 0));
+      value = frame;
+      reference[key] = frame;
+    }
+
+    for (int i = 0; i < 20; ++i) {
+      Cache::Key key = randomKey();
+      TEST_CHECK(cache.Erase(key) == (reference.erase(key) == 1));
+    }
+
+    // Evict pairs that haven't been seen for a few frames, the same way
+    // UpdateCollisionList does
+    int oldest = frame - 3;
+    cache.EraseIf(
+        [&](Cache::Key, int lastFrame) { return lastFrame < oldest; });
+    std::erase_if(reference,
+                  [&](const auto &entry) { return entry.second < oldest; });
+
+    TEST_CHECK(Matches(cache, reference));
+  }
+
+  cache.Clear();
+  TEST_CHECK(cache.IsEmpty());
+  TEST_CHECK(cache.Find(randomKey()) == nullptr);
+}
+
+void TestGrowsPastTableSize() {
+  Cache cache;
+  Reference reference;
+  for (int i = 0; i < 5000; ++i) {
+    Cache::Key key = Cache::MakeKey(i, i + 1);
+    cache.Insert(key).first = i;
+    reference[key] = i;
+  }
+  TEST_CHECK(Matches(cache, reference));
+}
+} // namespace
+
+int main() {
+  TestKeysAreUnordered();
+  TestMatchesMap();
+  TestGrowsPastTableSize();
+  return Tests::Finish("PairCacheTests");
+}
@@ -0,0 +1,191 @@
+#include "TestUtils.h"
+#include "collisions/SweepAndPrune.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+The sweep only ever looks at objects whose endpoints it's passed along the
+one axis, so every pair it reports is checked against testing every pair of
+bounds against each other.
+*/
+namespace {
+using Pairs = std::set<std::pair<int, int>>;
+
+std::pair<int, int> Ordered(int a, int b) {
+  return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+}
+
+struct Scene {
+  std::mt19937 rng{1234};
+  SweepAndPrune<int> sweep{10};
+  std::vector<Bounds> bounds;
+  std::vector<int> proxies;
+
+  float Random(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+  }
+
+  // A corridor that runs along x, like the level one floors
+  Bounds RandomBounds() {
+    Vector3 centre(Random(-200.0f, 200.0f), Random(-5.0f, 5.0f),
+                   Random(-5.0f, 5.0f));
+    Vector3 halfSize(Random(0.2f, 3.0f), Random(0.2f, 3.0f),
+                     Random(0.2f, 3.0f));
+    return Bounds::FromCentre(centre, halfSize);
+  }
+
+  void Add() {
+    int id = (int)bounds.size();
+    bounds.push_back(RandomBounds());
+    proxies.push_back(sweep.Insert(id, bounds.back()));
+  }
+
+  void Remove(int id) {
+    sweep.Remove(proxies[id]);
+    proxies[id] = SweepAndPrune<int>::NullProxy;
+  }
+
+  void Move(int id, const Vector3 &by) {
+    bounds[id].min += by;
+    bounds[id].max += by;
+    sweep.Move(proxies[id], bounds[id]);
+  }
+
+  bool IsActive(int id) const {
+    return proxies[id] != SweepAndPrune<int>::NullProxy;
+  }
+
+  Pairs Swept() {
+    Pairs pairs;
+    sweep.OperateOnPairs([&](int a, int b) {
+      TEST_CHECK(a != b);
+      TEST_CHECK(pairs.insert(Ordered(a, b)).second);
+    });
+    return pairs;
+  }
+
+  Pairs BruteForce() const {
+    Pairs pairs;
+    for (int a = 0; a < (int)bounds.size(); ++a) {
+      for (int b = a + 1; b < (int)bounds.size(); ++b) {
+        if (IsActive(a) && IsActive(b) && bounds[a].Overlaps(bounds[b])) {
+          pairs.insert({a, b});
+        }
+      }
+    }
+    return pairs;
+  }
+};
+
+void TestMatchesBruteForce() {
+  Scene scene;
+  for (int i = 0; i < 300; ++i) {
+    scene.Add();
+  }
+
+  for (int frame = 0; frame < 200; ++frame) {
+    for (int id = 0; id < (int)scene.bounds.size(); ++id) {
+      if (scene.IsActive(id)) {
+        scene.Move(id, Vector3(scene.Random(-0.5f, 0.5f),
+                               scene.Random(-0.5f, 0.5f),
+                               scene.Random(-0.5f, 0.5f)));
+      }
+    }
+    // Objects come and go, and every so often one teleports
+    if (frame % 7 == 0) {
+      int id = (int)(scene.rng() % scene.bounds.size());
+      if (scene.IsActive(id)) {
+        scene.Remove(id);
+      }
+    }
+    if (frame % 5 == 0) {
+      scene.Add();
+    }
+    if (frame % 11 == 0) {
+      int id = (int)(scene.rng() % scene.bounds.size());
+      if (scene.IsActive(id)) {
+        scene.Move(id, Vector3(scene.Random(-300.0f, 300.0f), 0, 0));
+      }
+    }
+
+    scene.sweep.Update();
+    TEST_CHECK(scene.Swept() == scene.BruteForce());
+  }
+}
+
+void TestQueryMatchesBruteForce() {
+  Scene scene;
+  for (int i = 0; i < 300; ++i) {
+    scene.Add();
+  }
+  scene.sweep.Update();
+
+  for (int i = 0; i < 100; ++i) {
+    Bounds query = scene.RandomBounds();
+    query.Expand(Vector3(5, 5, 5));
+
+    std::set<int> found;
+    scene.sweep.Query(query, [&](int id) {
+      found.insert(id);
+      return true;
+    });
+
+    std::set<int> expected;
+    for (int id = 0; id < (int)scene.bounds.size(); ++id) {
+      if (scene.bounds[id].Overlaps(query)) {
+        expected.insert(id);
+      }
+    }
+    TEST_CHECK(found == expected);
+  }
+}
+
+void TestPicksLongestAxis() {
+  // Spread out along z this time, with the sweep starting out on x
+  SweepAndPrune<int> sweep(1);
+  for (int i = 0; i < 50; ++i) {
+    sweep.Insert(i, Bounds::FromCentre(Vector3(0, 0, i * 4.0f),
+                                       Vector3(1, 1, 1)));
+  }
+  sweep.Update();
+  TEST_CHECK(sweep.GetAxis() == 2);
+}
+
+void TestStillSceneNeedsNoSwaps() {
+  Scene scene;
+  for (int i = 0; i < 100; ++i) {
+    scene.Add();
+  }
+  scene.sweep.Update();
+  scene.sweep.Update();
+  TEST_CHECK(scene.sweep.GetLastSwapCount() == 0);
+}
+
+void TestTouchingBoundsOverlap() {
+  // Bounds::Overlaps counts boxes that only touch, so the sweep has to too
+  SweepAndPrune<int> sweep;
+  sweep.Insert(0, Bounds(Vector3(0, 0, 0), Vector3(1, 1, 1)));
+  sweep.Insert(1, Bounds(Vector3(1, 0, 0), Vector3(2, 1, 1)));
+  sweep.Update();
+
+  int pairs = 0;
+  sweep.OperateOnPairs([&](int, int) { ++pairs; });
+  TEST_CHECK(pairs == 1);
+}
+} // namespace
+
+int main() {
+  TestMatchesBruteForce();
+  TestQueryMatchesBruteForce();
+  TestPicksLongestAxis();
+  TestStillSceneNeedsNoSwaps();
+  TestTouchingBoundsOverlap();
+  return Tests::Finish("SweepAndPruneTests");
+}
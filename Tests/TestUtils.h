@@ -0,0 +1,48 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+namespace NCL::CSC8503::Tests {
+/*
+Just enough to check things with in the test executables. A failed check
+prints where it was and carries on, so one run shows everything that's
+wrong, and Finish turns any failures into a non-zero exit code for ctest.
+*/
+inline int failedChecks = 0;
+
+inline bool Check(bool passed, const char *what, const char *file, int line) {
+  if (!passed) {
+    std::printf("%s:%d: check failed: %s\n", file, line, what);
+    ++failedChecks;
+  }
+  return passed;
+}
+
+inline bool CheckNear(float a, float b, float tolerance, const char *what,
+                      const char *file, int line) {
+  if (!(std::abs(a - b) <= tolerance)) {
+    std::printf("%s:%d: check failed: %s (%f vs %f)\n", file, line, what, a,
+                b);
+    ++failedChecks;
+    return false;
+  }
+  return true;
+}
+
+/// @brief Exit code for main
+inline int Finish(const char *name) {
+  if (failedChecks == 0) {
+    std::printf("%s: passed\n", name);
+    return 0;
+  }
+  std::printf("%s: %d checks failed\n", name, failedChecks);
+  return 1;
+}
+} // namespace NCL::CSC8503::Tests
+
+#define TEST_CHECK(condition)                                                  \
+  ::NCL::CSC8503::Tests::Check((condition), #condition, __FILE__, __LINE__)
+
+#define TEST_CHECK_NEAR(a, b, tolerance)                                       \
+  ::NCL::CSC8503::Tests::CheckNear((a), (b), (tolerance), #a " ~ " #b,         \
+                                   __FILE__, __LINE__)
@@ -0,0 +1,72 @@
+#include "BenchGame.h"
+#include "GameWorld.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace NCL;
+using namespace CSC8503;
+
+BenchGame::BenchGame(GameWorld &gameWorld, GameTechRendererInterface &renderer,
+                     PhysicsSystem &physics)
+    : TutorialGame(gameWorld, renderer, physics) {
+  SetCameraActive(false);
+  SetShowUi(false);
+}
+
+const char *BenchGame::SceneName(Scene scene) {
+  switch (scene) {
+  case Scene::Spheres:
+    return "spheres";
+  case Scene::AABBs:
+    return "aabbs";
+  case Scene::Mixed:
+    return "mixed";
+  case Scene::Bridges:
+    return "bridges";
+  }
+  return "unknown";
+}
+
+std::optional<BenchGame::Scene>
+BenchGame::SceneFromName(std::string_view name) {
+  for (Scene scene : AllScenes) {
+    if (name == SceneName(scene)) {
+      return scene;
+    }
+  }
+  return std::nullopt;
+}
+
+void BenchGame::BuildScene(Scene scene, int objectCount, unsigned seed) {
+  Clear();
+  // CreatedMixedGrid picks shapes with rand
+  srand(seed);
+
+  // Square grids, packed tightly enough that objects land on each other
+  int side = std::max(1, (int)std::ceil(std::sqrt((float)objectCount)));
+  constexpr float spacing = 2.5f;
+
+  switch (scene) {
+  case Scene::Spheres:
+    CreateSphereGrid(side, side, spacing, spacing, 1.0f);
+    break;
+  case Scene::AABBs:
+    CreateAABBGrid(side, side, spacing, spacing, Vector3(1, 1, 1));
+    AddFloorToWorld(Vector3(0, -2, 0));
+    break;
+  case Scene::Mixed:
+    CreatedMixedGrid(side, side, spacing, spacing);
+    AddFloorToWorld(Vector3(0, -2, 0));
+    break;
+  case Scene::Bridges: {
+    // Each bridge is its links plus the two fixed ends
+    constexpr int numLinks = 10;
+    int bridges = std::max(1, objectCount / (numLinks + 2));
+    for (int i = 0; i < bridges; ++i) {
+      BridgeConstraintTest(numLinks, Vector3(300, 50, 300 + i * 20.0f));
+    }
+    break;
+  }
+  }
+}
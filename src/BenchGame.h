@@ -0,0 +1,35 @@
+#pragma once
+
+#include "TutorialGame.h"
+
+#include <optional>
+#include <string_view>
+
+/*
+Builds the stress test scenes for the physics benchmark, out of the same
+world building helpers the tutorial scenes use, but without ever needing a
+window or a renderer to get at them.
+*/
+class BenchGame : public NCL::CSC8503::TutorialGame {
+public:
+  enum class Scene {
+    Spheres,
+    AABBs,
+    Mixed,
+    Bridges,
+  };
+
+  static constexpr Scene AllScenes[] = {Scene::Spheres, Scene::AABBs,
+                                        Scene::Mixed, Scene::Bridges};
+
+  BenchGame(NCL::CSC8503::GameWorld &gameWorld,
+            NCL::CSC8503::GameTechRendererInterface &renderer,
+            NCL::CSC8503::PhysicsSystem &physics);
+
+  static const char *SceneName(Scene scene);
+  static std::optional<Scene> SceneFromName(std::string_view name);
+
+  /// @brief Clear the world, and fill it with roughly objectCount objects.
+  /// The same scene, count and seed always builds the same world
+  void BuildScene(Scene scene, int objectCount, unsigned seed);
+};
@@ -187,16 +187,19 @@ void ClientGame::UpdateGame(float dt) {
 void ClientGame::ReceivePacket(GamePacketType type, GamePacket *payload,
                                int source) {
   int packetId = -1;
+  int objectId = -1;
   switch (type.type) {
   case BasicNetworkMessages::Full_State: {
     auto fs = GamePacket::as<FullPacket>(payload);
     lastFullSync = fs->fullState.stateID;
     packetId = lastFullSync;
+    objectId = fs->objectID;
     break;
   }
   case BasicNetworkMessages::Delta_State: {
     auto ds = GamePacket::as<DeltaPacket>(payload);
     packetId = ds->fullID;
+    objectId = ds->objectID;
     break;
   }
   case BasicNetworkMessages::Ping_Response: {
@@ -271,8 +274,8 @@ void ClientGame::ReceivePacket(GamePacketType type, GamePacket *payload,
     NET_ASSERT(packetId != -1, "Received network state packet without method "
                                "of extracting packetID for NetworkObject.");
     for (auto i : networkObjects) {
-      if (i->ReadPacket(*payload)) {
-        net->SendPacket(AckPacket(packetId));
+      if (i->ReadPacket(*payload, world)) {
+        net->SendPacket(AckPacket(packetId, objectId));
         break;
       }
     }
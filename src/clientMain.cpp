@@ -43,6 +43,7 @@ using namespace CSC8503;
 
 #include <chrono>
 #include <networking/NetworkObject.h>
+#include <string_view>
 #include <thread>
 
 #pragma region Test Functions
@@ -299,8 +300,18 @@ instead.
 This time, we've added some extra functionality to the window class - we can
 hide or show the
 
+Passing --physics-thread steps the physics on its own thread instead of once
+a frame.
+
 */
-int main() {
+int main(int argc, char **argv) {
+  bool threadedPhysics = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string_view(argv[i]) == "--physics-thread") {
+      threadedPhysics = true;
+    }
+  }
+
   WindowInitialisation initInfo;
   initInfo.width = 1280;
   initInfo.height = 720;
@@ -317,6 +328,11 @@ int main() {
 
   GameWorld *world = new GameWorld();
   PhysicsSystem *physics = new PhysicsSystem(*world);
+  // Bodies are drawn blended between steps, so they don't need to come
+  // often to look smooth
+  PhysicsSystem::StepSettings stepSettings = physics->GetStepSettings();
+  stepSettings.stepHz = 60;
+  physics->SetStepSettings(stepSettings);
 
 #ifdef USEVULKAN
   GameTechVulkanRenderer *renderer = new GameTechVulkanRenderer(*world);
@@ -334,6 +350,10 @@ int main() {
   TestNetworking();
 #endif
 
+  if (threadedPhysics) {
+    physics->StartThread();
+  }
+
   w->GetTimer().GetTimeDeltaSeconds(); // Clear the timer so we don't get a
                                        // larget first dt!
   while (w->UpdateWindow()) {
@@ -371,5 +391,6 @@ int main() {
 
     Debug::UpdateRenderables(dt);
   }
+  physics->StopThread();
   Window::DestroyGameWindow();
 }
\ No newline at end of file
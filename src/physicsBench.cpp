@@ -0,0 +1,296 @@
+#include "BenchGame.h"
+#include "DummyWindow.h"
+#include "GameWorld.h"
+#include "physics/PhysicsSystem.h"
+#include <DummyRenderer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+// windows.h has to come first
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+Runs the physics over canned scenes with no window, and writes out how long
+each frame took as JSON, so changes to the engine can be compared run to run.
+
+  CSC8503_PhysicsBench [--scene spheres|aabbs|mixed|bridges|all]
+                       [--count N] [--frames N] [--warmup N] [--seed N]
+                       [--workers N] [--out file.json]
+
+Peak memory can only be read for the process as a whole, so it's reported once
+for the run. Each scene instead reports how much its resident memory grew from
+just before it was built to the end of its last frame, which can be negative
+if it freed more than an earlier scene left behind.
+*/
+namespace {
+struct Options {
+  std::vector<BenchGame::Scene> scenes = {std::begin(BenchGame::AllScenes),
+                                          std::end(BenchGame::AllScenes)};
+  int count = 1000;
+  int frames = 600;
+  int warmup = 60;
+  unsigned seed = 1234;
+  int workers = -1;
+  std::string out;
+};
+
+struct SceneResult {
+  BenchGame::Scene scene;
+  int objects = 0;
+  std::vector<float> frameMs;
+  double substeps = 0;
+  double broadPhasePairs = 0;
+  double contactPairs = 0;
+  double contactPoints = 0;
+  long long residentGrowthBytes = 0;
+};
+
+// Frames are a fixed 60hz, so every run does the same amount of simulation
+constexpr float FrameDT = 1.0f / 60.0f;
+
+size_t ResidentMemoryBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.WorkingSetSize;
+  }
+  return 0;
+#elif defined(__APPLE__)
+  mach_task_basic_info info;
+  mach_msg_type_number_t size = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info,
+                &size) == KERN_SUCCESS) {
+    return (size_t)info.resident_size;
+  }
+  return 0;
+#else
+  // The second field is the resident set, in pages
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0;
+  size_t resident = 0;
+  if (statm >> pages >> resident) {
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+  }
+  return 0;
+#endif
+}
+
+size_t PeakMemoryBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+  }
+  return 0;
+#endif
+}
+
+float Percentile(const std::vector<float> &sorted, float p) {
+  if (sorted.empty()) {
+    return 0.0f;
+  }
+  size_t index = (size_t)std::lround(p * (sorted.size() - 1));
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool ParseOptions(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string_view value = argv[++i];
+
+    if (arg == "--scene") {
+      if (value == "all") {
+        continue;
+      }
+      auto scene = BenchGame::SceneFromName(value);
+      if (!scene) {
+        std::cerr << "Unknown scene " << value << std::endl;
+        return false;
+      }
+      options.scenes = {*scene};
+    } else if (arg == "--count") {
+      options.count = std::atoi(value.data());
+    } else if (arg == "--frames") {
+      options.frames = std::atoi(value.data());
+    } else if (arg == "--warmup") {
+      options.warmup = std::atoi(value.data());
+    } else if (arg == "--seed") {
+      options.seed = (unsigned)std::strtoul(value.data(), nullptr, 10);
+    } else if (arg == "--workers") {
+      options.workers = std::atoi(value.data());
+    } else if (arg == "--out") {
+      options.out = value;
+    } else {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return options.count > 0 && options.frames > 0 && options.warmup >= 0;
+}
+
+SceneResult RunScene(BenchGame &game, GameWorld &world,
+                     PhysicsSystem &physics, BenchGame::Scene scene,
+                     const Options &options) {
+  SceneResult result;
+  result.scene = scene;
+  size_t residentBefore = ResidentMemoryBytes();
+
+  game.BuildScene(scene, options.count, options.seed);
+  for (auto i : world) {
+    (void)i;
+    ++result.objects;
+  }
+
+  for (int i = 0; i < options.warmup; ++i) {
+    world.UpdateWorld(FrameDT);
+    physics.Update(FrameDT);
+  }
+
+  result.frameMs.reserve(options.frames);
+  for (int i = 0; i < options.frames; ++i) {
+    world.UpdateWorld(FrameDT);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    physics.Update(FrameDT);
+    std::chrono::duration<float, std::milli> ms =
+        std::chrono::high_resolution_clock::now() - start;
+    result.frameMs.push_back(ms.count());
+
+    const PhysicsProfiler::Frame &f = physics.GetProfiler().GetLastFrame();
+    result.substeps += f.substeps;
+    result.broadPhasePairs += f.broadPhasePairs;
+    result.contactPairs += f.contactPairs;
+    result.contactPoints += f.contactPoints;
+  }
+
+  double frames = options.frames;
+  result.substeps /= frames;
+  result.broadPhasePairs /= frames;
+  result.contactPairs /= frames;
+  result.contactPoints /= frames;
+  result.residentGrowthBytes =
+      (long long)ResidentMemoryBytes() - (long long)residentBefore;
+  return result;
+}
+
+void WriteJson(std::ostream &out, const Options &options,
+               const std::vector<SceneResult> &results) {
+  out << "{\n";
+  out << "  \"count\": " << options.count << ",\n";
+  out << "  \"frames\": " << options.frames << ",\n";
+  out << "  \"warmup\": " << options.warmup << ",\n";
+  out << "  \"seed\": " << options.seed << ",\n";
+  out << "  \"frameDT\": " << FrameDT << ",\n";
+  out << "  \"processPeakMemoryBytes\": " << PeakMemoryBytes() << ",\n";
+  out << "  \"scenes\": [";
+
+  for (size_t r = 0; r < results.size(); ++r) {
+    const SceneResult &result = results[r];
+
+    std::vector<float> sorted = result.frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (float ms : sorted) {
+      total += ms;
+    }
+
+    out << (r == 0 ? "\n" : ",\n");
+    out << "    {\n";
+    out << "      \"scene\": \"" << BenchGame::SceneName(result.scene)
+        << "\",\n";
+    out << "      \"objects\": " << result.objects << ",\n";
+    out << "      \"msPerFrame\": {\n";
+    out << "        \"mean\": " << total / sorted.size() << ",\n";
+    out << "        \"min\": " << sorted.front() << ",\n";
+    out << "        \"p50\": " << Percentile(sorted, 0.50f) << ",\n";
+    out << "        \"p90\": " << Percentile(sorted, 0.90f) << ",\n";
+    out << "        \"p99\": " << Percentile(sorted, 0.99f) << ",\n";
+    out << "        \"max\": " << sorted.back() << "\n";
+    out << "      },\n";
+    out << "      \"substepsPerFrame\": " << result.substeps << ",\n";
+    out << "      \"broadPhasePairsPerFrame\": " << result.broadPhasePairs
+        << ",\n";
+    out << "      \"contactPairsPerFrame\": " << result.contactPairs << ",\n";
+    out << "      \"contactPointsPerFrame\": " << result.contactPoints
+        << ",\n";
+    out << "      \"residentGrowthBytes\": " << result.residentGrowthBytes
+        << "\n";
+    out << "    }";
+  }
+  out << "\n  ]\n}\n";
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    return 1;
+  }
+
+  DummyWindow w{};
+  GameWorld world = GameWorld();
+  PhysicsSystem physics = PhysicsSystem(world);
+  physics.UseInterpolation(false);
+  // Every run has to take the same steps, however long they take
+  PhysicsSystem::StepSettings stepSettings = physics.GetStepSettings();
+  stepSettings.deterministic = true;
+  physics.SetStepSettings(stepSettings);
+  if (options.workers >= 0) {
+    physics.SetWorkerCount((unsigned)options.workers);
+  }
+
+  DummyRenderer renderer = DummyRenderer();
+  BenchGame game(world, renderer, physics);
+
+  std::vector<SceneResult> results;
+  for (BenchGame::Scene scene : options.scenes) {
+    results.push_back(RunScene(game, world, physics, scene, options));
+  }
+
+  if (options.out.empty()) {
+    WriteJson(std::cout, options, results);
+  } else {
+    std::ofstream file(options.out);
+    if (!file) {
+      std::cerr << "Couldn't open " << options.out << " for writing"
+                << std::endl;
+      return 1;
+    }
+    WriteJson(file, options, results);
+  }
+  return 0;
+}
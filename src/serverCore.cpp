@@ -66,6 +66,13 @@ void ServerCore::ReceivePacket(GamePacketType type, GamePacket *payload,
   case BasicNetworkMessages::Received_State: {
     auto packet = GamePacket::as<AckPacket>(payload);
     clients.updateLastReceivedStateID(source, packet->receivedID);
+    for (auto i : *gameWorld) {
+      NetworkObject *o = i->GetNetworkObject();
+      if (o && o->GetNetworkID() == packet->objectID) {
+        o->OnStateAcked(source, packet->receivedID);
+        break;
+      }
+    }
     break;
   }
   case BasicNetworkMessages::Hello: {
@@ -122,7 +129,8 @@ void ServerCore::BroadcastSnapshot(bool deltaFrame,
       }
 
       if (o->WritePacket(&newPacket, deltaFrame,
-                         player.second.lastReceivedStateID)) {
+                         player.second.lastReceivedStateID, player.first,
+                         world)) {
         SendPacketToClient(player.first, *newPacket);
       }
     }
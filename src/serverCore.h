@@ -130,6 +130,11 @@ public:
       return;
     game.RemovePlayer(clientID);
     clients.erase(clientID);
+    for (auto i : *gameWorld) {
+      if (NetworkObject *o = i->GetNetworkObject()) {
+        o->RemoveClient(clientID);
+      }
+    }
     SendGlobalPacket(PlayerDisconnectedPacket(clientID));
   }
 
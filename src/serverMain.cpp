@@ -3,13 +3,32 @@
 #include "physics/PhysicsSystem.h"
 #include <DummyRenderer.h>
 
+#include <string_view>
+
 using namespace NCL;
 using namespace CSC8503;
 
-int main() {
+int main(int argc, char **argv) {
   DummyWindow w{};
   GameWorld world = GameWorld();
   PhysicsSystem physics = PhysicsSystem(world);
+  // Nothing's drawn on the server
+  physics.UseInterpolation(false);
+
+  // --physics-csv <file> writes the physics timings for every frame out
+  // --physics-thread steps the physics on its own thread
+  bool threadedPhysics = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string_view(argv[i]) == "--physics-thread") {
+      threadedPhysics = true;
+    } else if (std::string_view(argv[i]) == "--physics-csv" && i + 1 < argc) {
+      if (!physics.GetProfiler().OpenCsv(argv[i + 1])) {
+        std::cout << "Couldn't open " << argv[i + 1] << " for writing"
+                  << std::endl;
+      }
+      ++i;
+    }
+  }
 
   DummyRenderer renderer = DummyRenderer();
 
@@ -17,6 +36,10 @@ int main() {
   g.SetCameraActive(false);
   g.SetShowUi(false);
 
+  if (threadedPhysics) {
+    physics.StartThread();
+  }
+
   auto lastFrameTime = std::chrono::high_resolution_clock::now();
 
   auto getDeltaSeconds = [&]() {